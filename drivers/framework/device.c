@@ -39,8 +39,9 @@ NTSTATUS IoCreateDevice(
         return STATUS_INVALID_PARAMETER;
     }
     
-    /* Allocate device object with extension */
-    Device = (PDEVICE_OBJECT)malloc(sizeof(DEVICE_OBJECT));
+    /* Allocate device object from its lookaside list; the extension has
+     * a per-driver size and comes straight from the pool */
+    Device = (PDEVICE_OBJECT)ExAllocateFromLookasideList(&IopDeviceLookaside);
     if (!Device) {
         return STATUS_INSUFFICIENT_RESOURCES;
     }
@@ -49,9 +50,10 @@ NTSTATUS IoCreateDevice(
     
     /* Allocate device extension if requested */
     if (DeviceExtensionSize > 0) {
-        Extension = malloc(DeviceExtensionSize);
+        Extension = ExAllocatePoolWithTag(DeviceExtensionSize,
+                                          IOP_TAG_EXTENSION);
         if (!Extension) {
-            free(Device);
+            ExFreeToLookasideList(&IopDeviceLookaside, Device);
             return STATUS_INSUFFICIENT_RESOURCES;
         }
         memset(Extension, 0, DeviceExtensionSize);
@@ -115,11 +117,11 @@ VOID IoDeleteDevice(
     
     /* Free device extension if allocated */
     if (DeviceObject->DeviceExtension) {
-        free(DeviceObject->DeviceExtension);
+        ExFreePoolWithTag(DeviceObject->DeviceExtension, IOP_TAG_EXTENSION);
     }
     
-    /* Free device object */
-    free(DeviceObject);
+    /* Return device object to its lookaside list */
+    ExFreeToLookasideList(&IopDeviceLookaside, DeviceObject);
 }
 
 /**
@@ -14,9 +14,29 @@
 PDRIVER_OBJECT g_DriverList = NULL;
 int g_DriverCount = 0;
 
+/* DEVICE_OBJECTs and IRPs come from these lists instead of the pool */
+lookaside_list_t IopDeviceLookaside;
+lookaside_list_t IopIrpLookaside;
+
 /* I/O Manager initialization flag */
 static BOOLEAN g_IoInitialized = FALSE;
 
+/**
+ * IopInitLookasideLists - Set up the I/O object caches
+ *
+ * Runs before pmm_init(): the lists start empty and fill up as objects
+ * are freed, so nothing is allocated here.
+ */
+static VOID IopInitLookasideLists(VOID)
+{
+    ExInitializeLookasideList(&IopDeviceLookaside, NULL, NULL,
+                              sizeof(DEVICE_OBJECT),
+                              LOOKASIDE_TAG('D', 'e', 'v', 'O'), 16);
+    ExInitializeLookasideList(&IopIrpLookaside, NULL, NULL,
+                              sizeof(IRP) + sizeof(IO_STACK_LOCATION),
+                              LOOKASIDE_TAG('I', 'r', 'p', ' '), 32);
+}
+
 /**
  * IoInitSystem - Initialize I/O Manager
  * 
@@ -30,6 +50,7 @@ NTSTATUS IoInitSystem(VOID)
     
     g_DriverList = NULL;
     g_DriverCount = 0;
+    IopInitLookasideLists();
     g_IoInitialized = TRUE;
     
     return STATUS_SUCCESS;
@@ -55,7 +76,8 @@ NTSTATUS IoCreateDriver(
     }
     
     /* Allocate driver object */
-    DriverObject = (PDRIVER_OBJECT)malloc(sizeof(DRIVER_OBJECT));
+    DriverObject = (PDRIVER_OBJECT)ExAllocatePoolWithTag(sizeof(DRIVER_OBJECT),
+                                                         IOP_TAG_DRIVER);
     if (!DriverObject) {
         return STATUS_INSUFFICIENT_RESOURCES;
     }
@@ -72,7 +94,7 @@ NTSTATUS IoCreateDriver(
     /* Call driver initialization */
     Status = DriverInit(DriverObject, DriverName);
     if (!NT_SUCCESS(Status)) {
-        free(DriverObject);
+        ExFreePoolWithTag(DriverObject, IOP_TAG_DRIVER);
         return Status;
     }
     
@@ -124,7 +146,7 @@ VOID IoDeleteDriver(
     }
     
     /* Free driver object */
-    free(DriverObject);
+    ExFreePoolWithTag(DriverObject, IOP_TAG_DRIVER);
 }
 
 /**
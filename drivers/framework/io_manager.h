@@ -11,11 +11,21 @@
 #define _IO_MANAGER_INTERNAL_H
 
 #include <drivers/io_manager.h>
+#include "../../kernel/mm/lookaside.h"
+#include "../../kernel/mm/pool.h"
+
+/* Pool tags for I/O Manager allocations (see the `pool` console command) */
+#define IOP_TAG_DRIVER      POOL_TAG('I', 'o', 'D', 'r')
+#define IOP_TAG_EXTENSION   POOL_TAG('I', 'o', 'D', 'x')
 
 /* Global driver list management */
 extern PDRIVER_OBJECT g_DriverList;
 extern int g_DriverCount;
 
+/* Lookaside lists for fixed-size I/O objects (see IoInitSystem) */
+extern lookaside_list_t IopDeviceLookaside;
+extern lookaside_list_t IopIrpLookaside;
+
 /* Internal functions */
 NTSTATUS IopCreateDevice(
     IN PDRIVER_OBJECT DriverObject,
@@ -0,0 +1,55 @@
+/*
+ * PROJECT:     System_Operative_Edit
+ * LICENSE:     GPL-3.0
+ * PURPOSE:     I/O Manager - IRP Allocation
+ * COPYRIGHT:   Adapted from ReactOS (GPL-3.0)
+ *              Original: ReactOS Project (ntoskrnl/io/iomgr/irp.c)
+ *              Adaptation: Universidad de Guayaquil
+ */
+
+#include "io_manager.h"
+#include <kstdlib.h>
+
+/**
+ * IoAllocateIrp - Allocate an I/O request packet
+ * @DeviceObject: Target device (may be NULL)
+ *
+ * IRPs are short-lived, so they come from IopIrpLookaside: each entry is
+ * an IRP followed by its I/O stack location.
+ *
+ * Returns: Zeroed IRP or NULL if out of memory
+ */
+PIRP IoAllocateIrp(
+    IN PDEVICE_OBJECT DeviceObject OPTIONAL
+)
+{
+    PIRP Irp;
+    PIO_STACK_LOCATION Stack;
+
+    Irp = (PIRP)ExAllocateFromLookasideList(&IopIrpLookaside);
+    if (!Irp) {
+        return NULL;
+    }
+
+    memset(Irp, 0, sizeof(IRP) + sizeof(IO_STACK_LOCATION));
+    Stack = (PIO_STACK_LOCATION)(Irp + 1);
+    Stack->DeviceObject = DeviceObject;
+
+    Irp->CurrentStackLocation = Stack;
+    Irp->DeviceObject = DeviceObject;
+    return Irp;
+}
+
+/**
+ * IoFreeIrp - Release an IRP from IoAllocateIrp
+ * @Irp: IRP to free
+ */
+VOID IoFreeIrp(
+    IN PIRP Irp
+)
+{
+    if (!Irp) {
+        return;
+    }
+    ExFreeToLookasideList(&IopIrpLookaside, Irp);
+}
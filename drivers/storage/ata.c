@@ -0,0 +1,245 @@
+/*
+ * PROJECT:     System_Operative_Edit
+ * LICENSE:     GPL-3.0
+ * PURPOSE:     ATA (IDE) PIO Disk Driver
+ * COPYRIGHT:   Adapted from ReactOS (GPL-3.0)
+ *              Original: ReactOS Project (drivers/storage/ide)
+ *              Adaptation: Universidad de Guayaquil
+ *
+ * Minimal LBA28 PIO driver for the legacy IDE ports that QEMU (and PC
+ * chipsets in compatibility mode) expose. There is no IRQ14/15 handler:
+ * nIEN is set on both channels and every command polls the status
+ * register, so it can be used from the page fault handler with
+ * interrupts disabled (the swap code does exactly that).
+ */
+
+#include "ata.h"
+
+/* Task file registers, relative to the channel base */
+#define ATA_REG_DATA        0
+#define ATA_REG_ERROR       1
+#define ATA_REG_COUNT       2
+#define ATA_REG_LBA0        3
+#define ATA_REG_LBA1        4
+#define ATA_REG_LBA2        5
+#define ATA_REG_DRIVE       6
+#define ATA_REG_STATUS      7
+#define ATA_REG_COMMAND     7
+
+/* Status bits */
+#define ATA_SR_ERR          0x01
+#define ATA_SR_DRQ          0x08
+#define ATA_SR_DF           0x20
+#define ATA_SR_BSY          0x80
+
+/* Device control: nIEN (no interrupts) */
+#define ATA_CTL_NIEN        0x02
+
+/* Commands */
+#define ATA_CMD_READ_PIO    0x20
+#define ATA_CMD_WRITE_PIO   0x30
+#define ATA_CMD_IDENTIFY    0xEC
+
+/* Status polls before giving up (~1 s of inb on real hardware) */
+#define ATA_TIMEOUT         1000000
+
+typedef struct _ATA_DRIVE {
+    BOOLEAN Present;
+    ULONG   Sectors;
+} ATA_DRIVE;
+
+static const USHORT g_AtaBase[2]    = { 0x1F0, 0x170 };
+static const USHORT g_AtaControl[2] = { 0x3F6, 0x376 };
+static ATA_DRIVE    g_AtaDrives[ATA_MAX_DRIVES];
+
+/* I/O port helpers ------------------------------------------------------- */
+static inline void outb(uint16_t port, uint8_t val) {
+    __asm__ volatile("outb %0,%1"::"a"(val),"Nd"(port));
+}
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t v;
+    __asm__ volatile("inb %1,%0":"=a"(v):"Nd"(port));
+    return v;
+}
+
+static inline void insw(uint16_t port, void* buf, uint32_t words) {
+    __asm__ volatile("cld; rep insw"
+                     : "+D"(buf), "+c"(words) : "d"(port) : "memory");
+}
+
+static inline void outsw(uint16_t port, const void* buf, uint32_t words) {
+    __asm__ volatile("cld; rep outsw"
+                     : "+S"(buf), "+c"(words) : "d"(port) : "memory");
+}
+
+/* ~400 ns after selecting a drive: four reads of the alternate status */
+static void AtapDelay(ULONG Channel)
+{
+    for (int i = 0; i < 4; i++)
+        (void)inb(g_AtaControl[Channel]);
+}
+
+/* Wait for BSY to clear; with Drq also wait for DRQ (or an error) */
+static NTSTATUS AtapWait(ULONG Channel, BOOLEAN Drq)
+{
+    USHORT base = g_AtaBase[Channel];
+    ULONG timeout = ATA_TIMEOUT;
+    UCHAR status;
+
+    while (timeout--) {
+        status = inb(base + ATA_REG_STATUS);
+        if (status & ATA_SR_BSY) continue;
+        if (status & (ATA_SR_ERR | ATA_SR_DF)) return STATUS_IO_DEVICE_ERROR;
+        if (!Drq || (status & ATA_SR_DRQ)) return STATUS_SUCCESS;
+    }
+    return STATUS_IO_TIMEOUT;
+}
+
+/* Select the drive and load an LBA28 address and sector count */
+static NTSTATUS AtapSetup(ULONG Drive, ULONG Lba, ULONG Count, UCHAR Command)
+{
+    ULONG channel = Drive >> 1;
+    USHORT base = g_AtaBase[channel];
+    NTSTATUS status;
+
+    status = AtapWait(channel, FALSE);
+    if (!NT_SUCCESS(status)) return status;
+
+    outb(base + ATA_REG_DRIVE, 0xE0 | ((Drive & 1) << 4) | ((Lba >> 24) & 0x0F));
+    AtapDelay(channel);
+    outb(base + ATA_REG_COUNT, (UCHAR)Count);   /* 256 -> 0 */
+    outb(base + ATA_REG_LBA0, (UCHAR)Lba);
+    outb(base + ATA_REG_LBA1, (UCHAR)(Lba >> 8));
+    outb(base + ATA_REG_LBA2, (UCHAR)(Lba >> 16));
+    outb(base + ATA_REG_COMMAND, Command);
+    return STATUS_SUCCESS;
+}
+
+static BOOLEAN AtapCheckRequest(ULONG Drive, ULONG Lba, ULONG Count, PCVOID Buffer)
+{
+    return Drive < ATA_MAX_DRIVES && g_AtaDrives[Drive].Present && Buffer &&
+           Count && Count <= ATA_MAX_TRANSFER &&
+           Lba < g_AtaDrives[Drive].Sectors &&
+           Count <= g_AtaDrives[Drive].Sectors - Lba;
+}
+
+/* IDENTIFY one drive position; fills g_AtaDrives[Drive] */
+static VOID AtapIdentify(ULONG Drive)
+{
+    ULONG channel = Drive >> 1;
+    USHORT base = g_AtaBase[channel];
+    USHORT id[256];
+
+    g_AtaDrives[Drive].Present = FALSE;
+    g_AtaDrives[Drive].Sectors = 0;
+
+    outb(base + ATA_REG_DRIVE, 0xA0 | ((Drive & 1) << 4));
+    AtapDelay(channel);
+    outb(base + ATA_REG_COUNT, 0);
+    outb(base + ATA_REG_LBA0, 0);
+    outb(base + ATA_REG_LBA1, 0);
+    outb(base + ATA_REG_LBA2, 0);
+    outb(base + ATA_REG_COMMAND, ATA_CMD_IDENTIFY);
+
+    /* 0 = no drive; 0xFF = floating bus (no channel) */
+    UCHAR status = inb(base + ATA_REG_STATUS);
+    if (status == 0 || status == 0xFF) return;
+
+    if (!NT_SUCCESS(AtapWait(channel, FALSE))) return;
+
+    /* ATAPI/SATA signatures: not a plain ATA disk */
+    if (inb(base + ATA_REG_LBA1) || inb(base + ATA_REG_LBA2)) return;
+
+    if (!NT_SUCCESS(AtapWait(channel, TRUE))) return;
+    insw(base + ATA_REG_DATA, id, 256);
+
+    /* Words 60-61: total LBA28 sectors */
+    g_AtaDrives[Drive].Sectors = (ULONG)id[60] | ((ULONG)id[61] << 16);
+    g_AtaDrives[Drive].Present = g_AtaDrives[Drive].Sectors != 0;
+}
+
+/**
+ * AtaInitialize - Probe the two legacy IDE channels
+ *
+ * Returns: STATUS_SUCCESS or STATUS_DEVICE_DOES_NOT_EXIST
+ */
+NTSTATUS AtaInitialize(VOID)
+{
+    BOOLEAN found = FALSE;
+
+    for (ULONG channel = 0; channel < 2; channel++) {
+        /* Polling only: keep IRQ14/15 quiet */
+        outb(g_AtaControl[channel], ATA_CTL_NIEN);
+    }
+    for (ULONG drive = 0; drive < ATA_MAX_DRIVES; drive++) {
+        AtapIdentify(drive);
+        if (g_AtaDrives[drive].Present) found = TRUE;
+    }
+    return found ? STATUS_SUCCESS : STATUS_DEVICE_DOES_NOT_EXIST;
+}
+
+/**
+ * AtaGetSectorCount - Size of a detected disk
+ * @Drive: drive number
+ *
+ * Returns: sector count or 0
+ */
+ULONG AtaGetSectorCount(IN ULONG Drive)
+{
+    if (Drive >= ATA_MAX_DRIVES || !g_AtaDrives[Drive].Present) return 0;
+    return g_AtaDrives[Drive].Sectors;
+}
+
+/**
+ * AtaReadSectors - Read sectors with PIO
+ */
+NTSTATUS AtaReadSectors(IN ULONG Drive, IN ULONG Lba, IN ULONG Count,
+                        OUT PVOID Buffer)
+{
+    PUCHAR buf = (PUCHAR)Buffer;
+    NTSTATUS status;
+
+    if (!AtapCheckRequest(Drive, Lba, Count, Buffer))
+        return STATUS_INVALID_PARAMETER;
+
+    status = AtapSetup(Drive, Lba, Count, ATA_CMD_READ_PIO);
+    if (!NT_SUCCESS(status)) return status;
+
+    /* One DRQ block per sector */
+    for (ULONG i = 0; i < Count; i++) {
+        status = AtapWait(Drive >> 1, TRUE);
+        if (!NT_SUCCESS(status)) return status;
+        insw(g_AtaBase[Drive >> 1] + ATA_REG_DATA, buf, ATA_SECTOR_SIZE / 2);
+        buf += ATA_SECTOR_SIZE;
+    }
+    return STATUS_SUCCESS;
+}
+
+/**
+ * AtaWriteSectors - Write sectors with PIO
+ *
+ * No CACHE FLUSH is issued: the only writer is the swap area, whose
+ * contents do not need to survive a power loss.
+ */
+NTSTATUS AtaWriteSectors(IN ULONG Drive, IN ULONG Lba, IN ULONG Count,
+                         IN PCVOID Buffer)
+{
+    const UCHAR* buf = (const UCHAR*)Buffer;
+    NTSTATUS status;
+
+    if (!AtapCheckRequest(Drive, Lba, Count, Buffer))
+        return STATUS_INVALID_PARAMETER;
+
+    status = AtapSetup(Drive, Lba, Count, ATA_CMD_WRITE_PIO);
+    if (!NT_SUCCESS(status)) return status;
+
+    for (ULONG i = 0; i < Count; i++) {
+        status = AtapWait(Drive >> 1, TRUE);
+        if (!NT_SUCCESS(status)) return status;
+        outsw(g_AtaBase[Drive >> 1] + ATA_REG_DATA, buf, ATA_SECTOR_SIZE / 2);
+        buf += ATA_SECTOR_SIZE;
+    }
+    /* The last sector is on the disk once BSY drops */
+    return AtapWait(Drive >> 1, FALSE);
+}
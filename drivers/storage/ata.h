@@ -0,0 +1,69 @@
+/*
+ * PROJECT:     System_Operative_Edit
+ * LICENSE:     GPL-3.0
+ * PURPOSE:     ATA (IDE) PIO Disk Driver - Header
+ * COPYRIGHT:   Adapted from ReactOS (GPL-3.0)
+ *              Original: ReactOS Project (drivers/storage/ide)
+ *              Adaptation: Universidad de Guayaquil
+ */
+
+#ifndef _ATA_H
+#define _ATA_H
+
+#include <drivers/ddk/wdm.h>
+
+#define ATA_SECTOR_SIZE     512
+#define ATA_MAX_DRIVES      4       /* primary/secondary x master/slave */
+#define ATA_MAX_TRANSFER    256     /* sectors per command (LBA28) */
+
+/* Drive numbers: (channel << 1) | slave */
+#define ATA_PRIMARY_MASTER      0
+#define ATA_PRIMARY_SLAVE       1
+#define ATA_SECONDARY_MASTER    2
+#define ATA_SECONDARY_SLAVE     3
+
+/**
+ * AtaInitialize - Probe the two legacy IDE channels
+ *
+ * Sends IDENTIFY DEVICE to the four drive positions and records the ATA
+ * disks found (ATAPI devices such as the QEMU CD-ROM are skipped).
+ * Drive interrupts are disabled: every transfer is polled.
+ *
+ * Returns: STATUS_SUCCESS if at least one disk was found,
+ *          STATUS_DEVICE_DOES_NOT_EXIST otherwise
+ */
+NTSTATUS AtaInitialize(VOID);
+
+/**
+ * AtaGetSectorCount - Size of a detected disk
+ * @Drive: ATA_PRIMARY_MASTER .. ATA_SECONDARY_SLAVE
+ *
+ * Returns: number of addressable LBA28 sectors, 0 if there is no disk
+ */
+ULONG AtaGetSectorCount(IN ULONG Drive);
+
+/**
+ * AtaReadSectors - Read sectors with PIO
+ * @Drive: drive number
+ * @Lba: first sector
+ * @Count: 1 .. ATA_MAX_TRANSFER sectors
+ * @Buffer: receives Count * ATA_SECTOR_SIZE bytes
+ *
+ * Returns: STATUS_SUCCESS, STATUS_IO_TIMEOUT or STATUS_IO_DEVICE_ERROR
+ */
+NTSTATUS AtaReadSectors(IN ULONG Drive, IN ULONG Lba, IN ULONG Count,
+                        OUT PVOID Buffer);
+
+/**
+ * AtaWriteSectors - Write sectors with PIO
+ * @Drive: drive number
+ * @Lba: first sector
+ * @Count: 1 .. ATA_MAX_TRANSFER sectors
+ * @Buffer: Count * ATA_SECTOR_SIZE bytes to write
+ *
+ * Returns: STATUS_SUCCESS, STATUS_IO_TIMEOUT or STATUS_IO_DEVICE_ERROR
+ */
+NTSTATUS AtaWriteSectors(IN ULONG Drive, IN ULONG Lba, IN ULONG Count,
+                         IN PCVOID Buffer);
+
+#endif /* _ATA_H */
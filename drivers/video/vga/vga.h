@@ -82,6 +82,8 @@ NTSTATUS VgaDriverEntry(
  * VgaSetMode - Set VGA display mode
  * @Mode: VGA mode number
  * 
+ * Boot only (__init): freed once the scheduler starts.
+ *
  * Returns: STATUS_SUCCESS or error code
  */
 NTSTATUS VgaSetMode(UCHAR Mode);
@@ -135,6 +137,17 @@ VOID VgaDrawRect(INT x, INT y, INT width, INT height, UCHAR Color);
  */
 VOID VgaDrawDemo(VOID);
 
+/**
+ * VgaAllocateShadow - Reservar el shadow framebuffer (vmalloc)
+ * Returns: STATUS_SUCCESS o STATUS_INSUFFICIENT_RESOURCES
+ */
+NTSTATUS VgaAllocateShadow(VOID);
+
+/**
+ * VgaFreeShadow - Liberar el shadow framebuffer
+ */
+VOID VgaFreeShadow(VOID);
+
 /**
  * VgaGetPixel - Leer el color de un pixel desde el shadow framebuffer
  * @x: Coordenada X
@@ -143,6 +156,26 @@ VOID VgaDrawDemo(VOID);
  */
 UCHAR VgaGetPixel(INT x, INT y);
 
+/**
+ * VgaBlitRect - Copiar un bloque de pixeles (un byte por pixel) a pantalla
+ * @x: Coordenada X de destino
+ * @y: Coordenada Y de destino
+ * @width: Ancho del bloque
+ * @height: Alto del bloque
+ * @Source: Pixeles de origen (color 0-15), fila a fila
+ * @Pitch: Bytes por fila de Source
+ */
+VOID VgaBlitRect(INT x, INT y, INT width, INT height,
+                 const UCHAR* Source, ULONG Pitch);
+
+/**
+ * VgaGetShadowBuffer - Shadow framebuffer para mapearlo en un proceso
+ * @Size: Recibe el tamaño en bytes
+ * @Pitch: Recibe los bytes por fila
+ * Returns: Direccion virtual del kernel (vmalloc) o NULL
+ */
+PUCHAR VgaGetShadowBuffer(PULONG Size, PULONG Pitch);
+
 /**
  * VgaGetDeviceObject - Get VGA device object
  * 
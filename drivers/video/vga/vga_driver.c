@@ -8,6 +8,7 @@
  */
 
 #include "vga.h"
+#include <init.h>
 
 /* External functions */
 extern NTSTATUS VgaInitializeDevice(PVGA_DEVICE_EXTENSION DevExt);
@@ -28,6 +29,8 @@ static VOID VgaDriverUnload(
         IoDeleteDevice(Device);
         Device = Next;
     }
+    VgaSetDeviceObject(NULL);
+    VgaFreeShadow();
 }
 
 /**
@@ -35,9 +38,13 @@ static VOID VgaDriverUnload(
  * @DriverObject: Driver object
  * @RegistryPath: Registry path
  * 
+ * Boot only (__init), like VgaInitializeDevice and VgaSetMode: kernel_main
+ * loads the driver once and free_initmem() drops this code afterwards.
+ * VgaDriverUnload stays resident, but the driver cannot be loaded again.
+ *
  * Returns: STATUS_SUCCESS or error code
  */
-NTSTATUS VgaDriverEntry(
+NTSTATUS __init VgaDriverEntry(
     IN PDRIVER_OBJECT DriverObject,
     IN PUNICODE_STRING RegistryPath
 )
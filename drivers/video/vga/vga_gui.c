@@ -7,6 +7,7 @@
 #include "vga_cursor.h"
 #include "../../input/ps2mouse.h"
 #include "vga_font.h"      /* VgaDrawString prototype */
+#include "../../../kernel/mm/pool.h"
 
 /* tick counter defined in syscall.c (used by speaker/beep function) */
 extern uint32_t get_tick_count(void);
@@ -161,13 +162,67 @@ static void ConsolePrint(const char *s)
     }
 }
 
+/* agrega v en decimal a buf, alineado a la derecha en width columnas */
+static void kg_append_dec(char *buf, uint32_t v, int width)
+{
+    char tmp[10];
+    int n = 0;
+    size_t len = kg_strlen(buf);
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    while (width-- > n && len < CONS_COLS) buf[len++] = ' ';
+    while (n && len < CONS_COLS) buf[len++] = tmp[--n];
+    buf[len] = '\0';
+}
+
+/* `pool`: los tags que más bytes tienen vivos (como poolmon); la tabla
+   completa va por serial porque la consola solo tiene CONS_ROWS líneas */
+static void ConsolePool(void)
+{
+    static pool_tag_stats_t snap[POOL_MAX_TAGS];
+    uint32_t n = pool_get_stats(snap, POOL_MAX_TAGS);
+    uint32_t shown = n < CONS_ROWS - 3 ? n : CONS_ROWS - 3;
+
+    /* selección parcial: los shown primeros ordenados por bytes */
+    for (uint32_t i = 0; i < shown; i++) {
+        uint32_t max = i;
+        for (uint32_t j = i + 1; j < n; j++)
+            if (snap[j].bytes > snap[max].bytes) max = j;
+        if (max != i) {
+            pool_tag_stats_t t = snap[i];
+            snap[i] = snap[max];
+            snap[max] = t;
+        }
+    }
+
+    ConsolePrint("tag     allocs   frees     bytes      pico  fallos\n");
+    for (uint32_t i = 0; i < shown; i++) {
+        char buf[CONS_COLS+1];
+        for (int k = 0; k < 4; k++) {
+            char c = (char)(snap[i].tag >> (k * 8));
+            buf[k] = (c >= 0x20 && c < 0x7F) ? c : '.';
+        }
+        buf[4] = '\0';
+        kg_append_dec(buf, snap[i].allocs, 10);
+        kg_append_dec(buf, snap[i].frees, 8);
+        kg_append_dec(buf, snap[i].bytes, 10);
+        kg_append_dec(buf, snap[i].peak_bytes, 10);
+        kg_append_dec(buf, snap[i].failures, 8);
+        ConsoleAddLine(buf);
+    }
+    ConsolePrint("(tabla completa por serial)\n");
+    pool_dump_serial();
+}
+
 static void console_execute(const char *cmd)
 {
     if (kg_strcmp(cmd, "help") == 0) {
         ConsolePrint("help - lista de comandos\n");
         ConsolePrint("clear - limpiar pantalla\n");
+        ConsolePrint("pool - memoria del kernel por tag\n");
     } else if (kg_strcmp(cmd, "clear") == 0) {
         ConsoleClear();
+    } else if (kg_strcmp(cmd, "pool") == 0) {
+        ConsolePool();
     } else {
         char buf[CONS_COLS+1];
         kg_strncpy(buf, "comando desconocido: ", CONS_COLS);
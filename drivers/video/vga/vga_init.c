@@ -5,6 +5,7 @@
  */
 
 #include "vga.h"
+#include <init.h>
 
 extern VOID VgaInitializePalette(VOID);
 extern VOID VgaWriteSequencer(UCHAR Index, UCHAR Value);
@@ -27,10 +28,14 @@ static inline uint8_t inb_vga(uint16_t port)
 /*
  * Tabla completa de registros para modo 640x480x16 (VGA modo 0x12)
  * Valores estandar de la especificacion VGA original de IBM
+ *
+ * El modo se programa una sola vez al cargar el driver: tablas,
+ * VgaSetMode() y VgaInitializeDevice() son __init, igual que su único
+ * llamador (VgaDriverEntry), y se liberan cuando arranca el scheduler.
  */
 
 /* Sequencer registers [index] = value */
-static const UCHAR seq_regs[] = {
+static const UCHAR seq_regs[] __initconst = {
     0x03,   /* [0] Reset: normal operation */
     0x01,   /* [1] Clocking Mode: 8 dot/char, bit3=0(NO Shift4), bit4=0(NO Shift Load) */
     0x0F,   /* [2] Map Mask: all planes enabled */
@@ -39,7 +44,7 @@ static const UCHAR seq_regs[] = {
 };
 
 /* CRTC registers [index] = value */
-static const UCHAR crtc_regs[] = {
+static const UCHAR crtc_regs[] __initconst = {
     0x5F,   /* [0]  Horizontal Total */
     0x4F,   /* [1]  Horizontal Display End */
     0x50,   /* [2]  Start Horizontal Blanking */
@@ -68,7 +73,7 @@ static const UCHAR crtc_regs[] = {
 };
 
 /* Graphics Controller registers [index] = value */
-static const UCHAR gc_regs[] = {
+static const UCHAR gc_regs[] __initconst = {
     0x00,   /* [0] Set/Reset */
     0x00,   /* [1] Enable Set/Reset */
     0x00,   /* [2] Color Compare */
@@ -84,7 +89,7 @@ static const UCHAR gc_regs[] = {
  * VALORES CORRECTOS para modo 0x12 (640x480x16) segun especificacion IBM VGA.
  * Los valores 0x38-0x3F en paletas 8-15 eran incorrectos y causaban
  * el efecto espejo horizontal al mapear colores erroneamente. */
-static const UCHAR ac_regs[] = {
+static const UCHAR ac_regs[] __initconst = {
     /* [0-15] Paleta: mapeo 1:1 de indice a color DAC (0-15) */
     0x00, 0x01, 0x02, 0x03,
     0x04, 0x05, 0x06, 0x07,
@@ -97,7 +102,7 @@ static const UCHAR ac_regs[] = {
     0x00,   /* [20] Color Select */
 };
 
-NTSTATUS VgaSetMode(UCHAR Mode)
+NTSTATUS __init VgaSetMode(UCHAR Mode)
 {
     int i;
 
@@ -169,7 +174,7 @@ NTSTATUS VgaSetMode(UCHAR Mode)
     return STATUS_INVALID_PARAMETER;
 }
 
-NTSTATUS VgaInitializeDevice(PVGA_DEVICE_EXTENSION DevExt)
+NTSTATUS __init VgaInitializeDevice(PVGA_DEVICE_EXTENSION DevExt)
 {
     NTSTATUS Status;
 
@@ -177,8 +182,15 @@ NTSTATUS VgaInitializeDevice(PVGA_DEVICE_EXTENSION DevExt)
         return STATUS_INVALID_PARAMETER;
     }
 
+    /* El shadow solo existe en modo grafico */
+    Status = VgaAllocateShadow();
+    if (!NT_SUCCESS(Status)) {
+        return Status;
+    }
+
     Status = VgaSetMode(VGA_MODE_GRAPHICS_640x480x16);
     if (!NT_SUCCESS(Status)) {
+        VgaFreeShadow();
         return Status;
     }
 
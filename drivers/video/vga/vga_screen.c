@@ -8,6 +8,7 @@
  */
 
 #include "vga.h"
+#include "../../../kernel/mm/vmalloc.h"
 
 /* External functions */
 extern VOID VgaWriteGraphicsController(UCHAR Index, UCHAR Value);
@@ -23,17 +24,60 @@ static PDEVICE_OBJECT g_VgaDevice = NULL;
  * Permite leer el color de cualquier pixel sin acceder al hardware VGA
  * (que no soporta lectura directa de color en modo planar de forma simple).
  * VgaPutPixel y VgaFillRect actualizan este buffer junto con el hardware.
+ *
+ * Sale de vmalloc() al entrar en modo grafico (VgaAllocateShadow) en vez
+ * de ser un array .bss: sin GUI esos 300 KB no ocupan RAM ni imagen.
  */
 #define SHADOW_W 640
 #define SHADOW_H 480
-static UCHAR g_shadow[SHADOW_W * SHADOW_H];
+static PUCHAR g_shadow = NULL;
+
+/**
+ * VgaAllocateShadow - Reserve the shadow framebuffer
+ *
+ * Returns: STATUS_SUCCESS or STATUS_INSUFFICIENT_RESOURCES
+ */
+NTSTATUS VgaAllocateShadow(VOID)
+{
+    if (!g_shadow) {
+        g_shadow = (PUCHAR)vmalloc(SHADOW_W * SHADOW_H);
+        if (!g_shadow) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+    return STATUS_SUCCESS;
+}
+
+/**
+ * VgaFreeShadow - Release the shadow framebuffer
+ */
+VOID VgaFreeShadow(VOID)
+{
+    vfree(g_shadow);
+    g_shadow = NULL;
+}
 
 UCHAR VgaGetPixel(INT x, INT y)
 {
+    if (!g_shadow) return 0;
     if (x < 0 || x >= SHADOW_W || y < 0 || y >= SHADOW_H) return 0;
     return g_shadow[y * SHADOW_W + x];
 }
 
+/**
+ * VgaGetShadowBuffer - Shadow framebuffer for read-only user mappings
+ * @Size: Receives the size in bytes
+ * @Pitch: Receives the bytes per row
+ *
+ * Returns: Kernel virtual address (vmalloc) or NULL outside graphics mode
+ */
+PUCHAR VgaGetShadowBuffer(PULONG Size, PULONG Pitch)
+{
+    if (Size) *Size = SHADOW_W * SHADOW_H;
+    if (Pitch) *Pitch = SHADOW_W;
+    return g_shadow;
+}
+
 /**
  * VgaSetDeviceObject - Set global VGA device object
  * @DeviceObject: VGA device object
@@ -73,6 +117,7 @@ VOID VgaPutPixel(INT x, INT y, UCHAR Color)
     if (!DevExt || !DevExt->GraphicsMode) return;
     if (x < 0 || x >= (INT)DevExt->ScreenWidth)  return;
     if (y < 0 || y >= (INT)DevExt->ScreenHeight) return;
+    if (!g_shadow) return;
 
     FrameBuffer = (PUCHAR)DevExt->FrameBuffer;
 
@@ -144,7 +189,7 @@ VOID VgaClearScreen(UCHAR Color)
     VgaWriteSequencer(2, 0x0F);
 
     /* Limpiar shadow framebuffer */
-    {
+    if (g_shadow) {
         ULONG total = SHADOW_W * SHADOW_H;
         for (ULONG i = 0; i < total; i++) g_shadow[i] = Color;
     }
@@ -160,6 +205,7 @@ VOID VgaFillRect(INT x, INT y, INT width, INT height, UCHAR Color)
     extern void serial_puts(const char*);
     serial_puts("[vga] VgaFillRect start\n");
     if (width <= 0 || height <= 0) return;
+    if (!g_shadow) return;
 
     /* actualizar shadow primero */
     for (INT row = 0; row < height; row++) {
@@ -220,6 +266,70 @@ VOID VgaFillRect(INT x, INT y, INT width, INT height, UCHAR Color)
     serial_puts("[vga] VgaFillRect hardware done\n");
 }
 
+/**
+ * VgaBlitRect - Copy a block of 8-bit pixels to the screen
+ * @x: Destination X coordinate
+ * @y: Destination Y coordinate
+ * @width: Block width
+ * @height: Block height
+ * @Source: Source pixels (color 0-15), row by row
+ * @Pitch: Bytes per source row
+ *
+ * Actualiza el shadow y reescribe cada byte de plano afectado una sola
+ * vez por fila: 4 escrituras al Map Mask por fila en lugar de 4 por
+ * pixel como VgaPutPixel. Los bytes de los bordes se rearman desde el
+ * shadow, asi que x y width no necesitan estar alineados a 8.
+ */
+VOID VgaBlitRect(INT x, INT y, INT width, INT height,
+                 const UCHAR* Source, ULONG Pitch)
+{
+    PVGA_DEVICE_EXTENSION DevExt = NULL;
+    PUCHAR FrameBuffer = NULL;
+    INT row, col, p, first, last;
+
+    if (!g_shadow || !Source || width <= 0 || height <= 0) return;
+
+    /* Recortar contra la pantalla moviendo el origen */
+    if (x < 0) { Source -= x; width += x; x = 0; }
+    if (y < 0) { Source -= (LONG)y * (LONG)Pitch; height += y; y = 0; }
+    if (x + width > SHADOW_W)  width  = SHADOW_W - x;
+    if (y + height > SHADOW_H) height = SHADOW_H - y;
+    if (width <= 0 || height <= 0) return;
+
+    if (g_VgaDevice) {
+        DevExt = (PVGA_DEVICE_EXTENSION)g_VgaDevice->DeviceExtension;
+        if (DevExt && DevExt->GraphicsMode)
+            FrameBuffer = (PUCHAR)DevExt->FrameBuffer;
+    }
+    first = x / 8;
+    last  = (x + width - 1) / 8;
+
+    for (row = 0; row < height; row++) {
+        PUCHAR line = g_shadow + (ULONG)(y + row) * SHADOW_W;
+        const UCHAR* src = Source + (ULONG)row * Pitch;
+
+        for (col = 0; col < width; col++)
+            line[x + col] = src[col];
+        if (!FrameBuffer) continue;
+
+        PUCHAR dest = FrameBuffer + (ULONG)(y + row) * (SHADOW_W / 8);
+        for (p = 0; p < 4; p++) {
+            VgaWriteSequencer(2, 1 << p);
+            for (col = first; col <= last; col++) {
+                const UCHAR* px = line + col * 8;
+                UCHAR planeValue = 0;
+                for (INT b = 0; b < 8; b++) {
+                    if (px[b] & (1 << p))
+                        planeValue |= (0x80 >> b);
+                }
+                dest[col] = planeValue;
+            }
+        }
+    }
+    if (FrameBuffer)
+        VgaWriteSequencer(2, 0x0F);
+}
+
 /**
  * VgaDrawLine - Draw a line between two points (Bresenham's algorithm)
  * @x1: Starting X coordinate
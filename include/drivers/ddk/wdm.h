@@ -54,6 +54,8 @@ typedef ULONG *PULONG;
 #define STATUS_DEVICE_DOES_NOT_EXIST     ((NTSTATUS)0xC00000C0L)
 #define STATUS_INVALID_DEVICE_REQUEST    ((NTSTATUS)0xC0000010L)
 #define STATUS_NO_MEMORY                 ((NTSTATUS)0xC0000017L)
+#define STATUS_IO_TIMEOUT                ((NTSTATUS)0xC00000B5L)
+#define STATUS_IO_DEVICE_ERROR           ((NTSTATUS)0xC0000185L)
 
 #define NT_SUCCESS(Status) ((NTSTATUS)(Status) >= 0)
 
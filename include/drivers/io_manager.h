@@ -78,6 +78,26 @@ NTSTATUS IoGetDeviceObjectPointer(
     OUT PDEVICE_OBJECT *DeviceObject
 );
 
+/**
+ * IoAllocateIrp - Allocate an I/O request packet
+ * @DeviceObject: Target device (may be NULL)
+ *
+ * The IRP carries a single I/O stack location (no device stacking yet).
+ *
+ * Returns: Zeroed IRP or NULL if out of memory
+ */
+PIRP IoAllocateIrp(
+    IN PDEVICE_OBJECT DeviceObject OPTIONAL
+);
+
+/**
+ * IoFreeIrp - Release an IRP from IoAllocateIrp
+ * @Irp: IRP to free
+ */
+VOID IoFreeIrp(
+    IN PIRP Irp
+);
+
 /**
  * IoInitSystem - Initialize I/O Manager
  * 
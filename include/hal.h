@@ -23,4 +23,32 @@ void cpu_halt(void);
 void cpu_disable_interrupts(void);
 void cpu_enable_interrupts(void);
 
+/*
+ * Sección crítica anidable: guarda EFLAGS y deshabilita interrupciones;
+ * irq_restore deja IF como estaba. Para el estado que comparten el
+ * código normal y las interrupciones (o el relleno desde el idle).
+ */
+static inline uint32_t irq_save(void)
+{
+    uint32_t flags;
+    __asm__ volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint32_t flags)
+{
+    __asm__ volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+
+/* CPUID: leaf 1, bits de EDX */
+#define CPUID_EDX_PSE   (1 << 3)    /* páginas de 4MB */
+#define CPUID_EDX_PAE   (1 << 6)
+#define CPUID_EDX_PGE   (1 << 13)   /* páginas globales */
+#define CPUID_EDX_SSE   (1 << 25)
+#define CPUID_EDX_SSE2  (1 << 26)
+
+/* Ejecutar CPUID; si la CPU no lo soporta (EFLAGS.ID fijo) todo queda a 0 */
+void cpu_cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx,
+               uint32_t* ecx, uint32_t* edx);
+
 #endif /* _HAL_H */
@@ -0,0 +1,23 @@
+#ifndef _INIT_H
+#define _INIT_H
+
+/*
+ * Código y datos que solo se usan durante el arranque.
+ *
+ * linker.ld junta estas secciones entre __init_start y __init_end, y
+ * free_initmem() devuelve esas páginas al PMM cuando arranca el
+ * scheduler. Nada marcado así puede llamarse ni leerse después.
+ *
+ *   __init       funciones
+ *   __initdata   datos modificables
+ *   __initconst  datos const (sección aparte: GCC no mezcla const y no
+ *                const en la misma sección)
+ */
+#define __init       __attribute__((section(".init.text")))
+#define __initdata   __attribute__((section(".init.data")))
+#define __initconst  __attribute__((section(".init.rodata")))
+
+/* Límites de las secciones .init (linker.ld) */
+extern char __init_start[], __init_end[];
+
+#endif /* _INIT_H */
@@ -12,11 +12,15 @@
 
 /* Memory management */
 void heap_init(void);   /* Llamar UNA vez antes del primer malloc() */
-void *malloc(size_t size);
+void *kmalloc(size_t size);   /* heap por slabs (kernel/mm/kmalloc.h) */
+void kfree(void *ptr);
+void *malloc(size_t size);    /* = kmalloc / kfree */
 void free(void *ptr);
 void *memset(void *ptr, int value, size_t n);
 void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
 int memcmp(const void *s1, const void *s2, size_t n);
+void memory_init(void);   /* elegir las rutinas mem* según CPUID */
 
 /* String functions */
 size_t strlen(const char *str);
@@ -253,6 +253,189 @@ static inline uint32_t sys_gui_draw_button(int x, int y, int w, int h, int press
     return ret;
 }
 
+#define SYS_FORK                  0x14   /* duplicar el proceso (copy-on-write) */
+
+/*
+ * sys_fork — crear una copia del proceso actual.
+ * Retorna 0 en el hijo, el pid del hijo en el padre o SYSCALL_ERR.
+ * Las páginas se comparten hasta que uno de los dos escribe en ellas.
+ *
+ *   uint32_t pid = sys_fork();
+ *   if (pid == (uint32_t)-1) { ... sin memoria ... }
+ *   else if (pid == 0)       { ... hijo ... }
+ *   else                     { ... padre, pid del hijo ... }
+ */
+static inline uint32_t sys_fork(void)
+{
+    uint32_t ret;
+    __asm__ volatile(
+        "int $0x30"
+        : "=a"(ret)
+        : "a"(SYS_FORK)
+        : "memory"
+    );
+    return ret;
+}
+
+/* Memoria de usuario: regiones anónimas y heap. Las páginas no ocupan
+ * RAM hasta el primer acceso. */
+#define SYS_MMAP        0x15
+#define SYS_MUNMAP      0x16
+#define SYS_BRK         0x17
+
+#define PROT_READ       0x1
+#define PROT_WRITE      0x2
+#define MAP_PRIVATE     0x02
+#define MAP_FIXED       0x10
+#define MAP_ANONYMOUS   0x20
+#define MAP_FAILED      ((void*)0xFFFFFFFF)
+
+/*
+ * sys_mmap — reservar len bytes de memoria anónima (a cero).
+ * addr es una pista que solo se respeta con MAP_FIXED; flags debe
+ * incluir MAP_ANONYMOUS. Retorna la dirección o MAP_FAILED.
+ *
+ *   char* buf = sys_mmap(0, 64 * 1024, PROT_READ | PROT_WRITE,
+ *                        MAP_PRIVATE | MAP_ANONYMOUS);
+ */
+static inline void* sys_mmap(void* addr, uint32_t len, uint32_t prot,
+                             uint32_t flags)
+{
+    uint32_t ret;
+    __asm__ volatile(
+        "int $0x30"
+        : "=a"(ret)
+        : "a"(SYS_MMAP), "b"(addr), "c"(len), "d"(prot), "S"(flags)
+        : "memory"
+    );
+    return (void*)ret;
+}
+
+static inline uint32_t sys_munmap(void* addr, uint32_t len)
+{
+    uint32_t ret;
+    __asm__ volatile(
+        "int $0x30"
+        : "=a"(ret)
+        : "a"(SYS_MUNMAP), "b"(addr), "c"(len)
+        : "memory"
+    );
+    return ret;
+}
+
+/* Mover el fin del heap; sys_brk(0) retorna el actual */
+static inline void* sys_brk(void* end)
+{
+    uint32_t ret;
+    __asm__ volatile(
+        "int $0x30"
+        : "=a"(ret)
+        : "a"(SYS_BRK), "b"(end)
+        : "memory"
+    );
+    return (void*)ret;
+}
+
+/* Uso de memoria de un proceso, en páginas de 4KB (para un "ps") */
+#define SYS_PROC_INFO   0x18
+
+typedef struct {
+    uint32_t pid;
+    uint32_t privilege;     /* 0 = kernel, 3 = usuario */
+    char     name[32];
+    uint32_t rss;           /* residentes: imagen + páginas tocadas en RAM */
+    uint32_t peak_rss;      /* máximo de rss desde que se creó */
+    uint32_t page_tables;   /* directorio (PDPT + 4 PDs con PAE) + page tables propias */
+    uint32_t committed;     /* reservado: imagen + todas las VMAs */
+    uint32_t touched;       /* de las VMAs, ya tocadas (RAM + swap) */
+    uint32_t swapped;       /* de las VMAs, en swap */
+    uint32_t minor_faults;
+    uint32_t major_faults;
+} SYS_PROCESS_INFO;
+
+/* Posiciones de la tabla de procesos (MAX_PROCESSES del kernel): el
+ * índice que retorna sys_proc_info nunca pasa de aquí */
+#define SYS_MAX_PROCESSES 16
+
+/*
+ * sys_proc_info — datos del primer proceso a partir de la posición index
+ * de la tabla de procesos. Retorna la posición desde la que seguir
+ * buscando, 0 si no quedan procesos o -EFAULT (negativo) si out no es
+ * escribible:
+ *
+ *   SYS_PROCESS_INFO pi;
+ *   uint32_t i = 0;
+ *   while ((int32_t)(i = sys_proc_info(i, &pi)) > 0 &&
+ *          i <= SYS_MAX_PROCESSES) { ... }
+ */
+static inline uint32_t sys_proc_info(uint32_t index, SYS_PROCESS_INFO* out)
+{
+    uint32_t ret;
+    __asm__ volatile(
+        "int $0x30"
+        : "=a"(ret)
+        : "a"(SYS_PROC_INFO), "b"(index), "c"(out)
+        : "memory"
+    );
+    return ret;
+}
+
+/*
+ * Superficie de dibujo propia: un buffer de un byte por pixel (color
+ * 0-15) mapeado en el proceso con escritura. Se dibuja ahí sin
+ * syscalls y sys_surface_damage() pasa a la pantalla solo el
+ * rectángulo que cambió. Con SURFACE_MAP_SHADOW se mapea además la
+ * copia de la pantalla entera (640x480), de solo lectura.
+ */
+#define SYS_SURFACE_MAP     0x19
+#define SYS_SURFACE_DAMAGE  0x1A
+
+#define SURFACE_MAP_SHADOW  0x1
+
+typedef struct {
+    int32_t        x, y;            /* entrada: esquina en pantalla */
+    uint32_t       width, height;   /* entrada: tamaño en pixeles */
+    uint8_t*       pixels;          /* salida: fila y en pixels + y * pitch */
+    uint32_t       pitch;           /* salida: bytes por fila */
+    const uint8_t* shadow;          /* salida: la pantalla, o NULL */
+    uint32_t       shadow_pitch;
+} SYS_SURFACE;
+
+/*
+ * sys_surface_map — crear la superficie del proceso (una sola). Rellena
+ * pixels/pitch/shadow y retorna 0, o SYSCALL_ERR:
+ *
+ *   SYS_SURFACE s = { .x = 100, .y = 100, .width = 200, .height = 50 };
+ *   if (sys_surface_map(&s, 0) == 0) {
+ *       s.pixels[10 * s.pitch + 20] = VGA_COLOR_RED;
+ *       sys_surface_damage(20, 10, 1, 1);
+ *   }
+ */
+static inline uint32_t sys_surface_map(SYS_SURFACE* s, uint32_t flags)
+{
+    uint32_t ret;
+    __asm__ volatile(
+        "int $0x30"
+        : "=a"(ret)
+        : "a"(SYS_SURFACE_MAP), "b"(s), "c"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+/* Copiar a la pantalla el rectángulo [x, x+w) x [y, y+h) de la superficie */
+static inline uint32_t sys_surface_damage(int x, int y, int w, int h)
+{
+    uint32_t ret;
+    __asm__ volatile(
+        "int $0x30"
+        : "=a"(ret)
+        : "a"(SYS_SURFACE_DAMAGE), "b"(x), "c"(y), "d"(w), "S"(h)
+        : "memory"
+    );
+    return ret;
+}
+
 static inline uint32_t sys_get_pixel(int x, int y)
 {
     uint32_t ret;
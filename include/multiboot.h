@@ -12,6 +12,19 @@
 #define MULTIBOOT_MEMORY_INFO 0x00000002
 #define MULTIBOOT_VIDEO_MODE 0x00000004
 
+/* Bits de multiboot_info.flags que nos interesan */
+#define MULTIBOOT_INFO_MEMORY   0x00000001   /* mem_lower/mem_upper validos */
+#define MULTIBOOT_INFO_CMDLINE  0x00000004
+#define MULTIBOOT_INFO_MODS     0x00000008   /* mods_count/mods_addr validos */
+#define MULTIBOOT_INFO_MEM_MAP  0x00000040   /* mmap_length/mmap_addr validos */
+
+/* Tipos de region del mapa de memoria (los mismos que E820) */
+#define MULTIBOOT_MEMORY_AVAILABLE  1
+#define MULTIBOOT_MEMORY_RESERVED   2
+#define MULTIBOOT_MEMORY_ACPI       3
+#define MULTIBOOT_MEMORY_NVS        4
+#define MULTIBOOT_MEMORY_BADRAM     5
+
 /* Multiboot header structure */
 struct multiboot_header {
     uint32_t magic;
@@ -40,4 +53,25 @@ struct multiboot_info {
 
 typedef struct multiboot_info multiboot_info_t;
 
+/* Entrada del mapa de memoria. 'size' no incluye el propio campo size:
+ * la siguiente entrada esta en (uint8_t*)entry + entry->size + 4. */
+struct multiboot_mmap_entry {
+    uint32_t size;
+    uint64_t addr;
+    uint64_t len;
+    uint32_t type;
+} __attribute__((packed));
+
+typedef struct multiboot_mmap_entry multiboot_mmap_entry_t;
+
+/* Modulo cargado por el bootloader */
+struct multiboot_module {
+    uint32_t mod_start;
+    uint32_t mod_end;
+    uint32_t cmdline;
+    uint32_t reserved;
+} __attribute__((packed));
+
+typedef struct multiboot_module multiboot_module_t;
+
 #endif /* _MULTIBOOT_H */
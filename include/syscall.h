@@ -27,6 +27,27 @@
 #define SYS_GUI_DRAW_WINDOW_TEXT  0x12   /* a=pointer, b=rx, c=ry, d=pointer, e=fg */
 #define SYS_GUI_DRAW_BUTTON       0x13   /* a=x,b=y,c=w,d=h,e=pressed, pointer label in esi */
 
+/* gestión de procesos */
+#define SYS_FORK                  0x14   /* duplicar el proceso (COW); hijo -> 0, padre -> pid */
+
+/* memoria de usuario (VMAs, ver kernel/mm/vma.h) */
+#define SYS_MMAP                  0x15   /* a=addr, b=len, c=prot, d=flags -> dirección */
+#define SYS_MUNMAP                0x16   /* a=addr, b=len */
+#define SYS_BRK                   0x17   /* a=nuevo fin del heap (0 = consultar) -> brk */
+
+/* a=índice en la tabla de procesos, b=SYS_PROCESS_INFO* -> índice siguiente, 0 al final */
+#define SYS_PROC_INFO             0x18
+
+/* superficies de dibujo mapeadas en el proceso */
+#define SYS_SURFACE_MAP           0x19   /* a=SYS_SURFACE* (entrada/salida), b=flags */
+#define SYS_SURFACE_DAMAGE        0x1A   /* a=x, b=y, c=w, d=h (coordenadas de la superficie) */
+
+#define PROT_READ       0x1
+#define PROT_WRITE      0x2
+#define MAP_PRIVATE     0x02
+#define MAP_FIXED       0x10
+#define MAP_ANONYMOUS   0x20
+
 #define SYSCALL_ERR      ((uint32_t)-1)
 
 #endif /* _SYSCALL_H */
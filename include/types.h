@@ -17,6 +17,9 @@ typedef int32_t ssize_t;
 typedef uint32_t uintptr_t;
 typedef int32_t intptr_t;
 
+/* Dirección física: con PAE puede pasar de 4GB */
+typedef uint64_t phys_addr_t;
+
 #define NULL ((void*)0)
 
 #define TRUE 1
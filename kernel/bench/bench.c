@@ -0,0 +1,1233 @@
+/*
+ * bench.c — Micro-benchmarks del kernel (ver bench.h)
+ *
+ * Cada benchmark imprime una línea por serial:
+ *   [bench] <nombre>: <ops> ops, <ciclos/op> ciclos/op
+ *
+ * Las mediciones usan rdtsc y restas de 32 bits: todas las fases están
+ * dimensionadas para no superar 2^32 ciclos en QEMU.
+ */
+#include "bench.h"
+#include "../mm/pmm.h"
+#include "../mm/vmm.h"
+#include "../mm/page.h"
+#include "../mm/fault.h"
+#include "../proc/process.h"
+#include "../mm/kmalloc.h"
+#include "../mm/lookaside.h"
+#include "../mm/vmalloc.h"
+#include "../mm/swap.h"
+#include "../mm/vma.h"
+#include "../../include/libsys.h"
+#include "../../drivers/video/vga/vga.h"
+#include <drivers/io_manager.h>
+#include <kstdlib.h>
+#include <types.h>
+
+#ifdef KERNEL_BENCH
+
+extern void serial_puts(const char*);
+
+/* Listas del I/O manager (drivers/framework/io_manager.c) */
+extern lookaside_list_t IopDeviceLookaside;
+extern lookaside_list_t IopIrpLookaside;
+
+/* ── Helpers ──────────────────────────────────────────────────────────── */
+
+static inline uint32_t rdtsc32(void)
+{
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    (void)hi;
+    return lo;
+}
+
+static void bench_print_dec(uint32_t v)
+{
+    char buf[11];
+    int i = 10;
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + (v % 10);
+        v /= 10;
+    } while (v && i > 0);
+    serial_puts(&buf[i]);
+}
+
+static void bench_report(const char* name, uint32_t ops, uint32_t cycles)
+{
+    serial_puts("[bench] ");
+    serial_puts(name);
+    serial_puts(": ");
+    bench_print_dec(ops);
+    serial_puts(" ops, ");
+    bench_print_dec(ops ? cycles / ops : 0);
+    serial_puts(" ciclos/op\r\n");
+}
+
+/* ── PMM: alloc/free de todos los frames ──────────────────────────────── */
+
+/* Cota de frames que guardamos (256MB); el resto queda sin tocar */
+#define BENCH_MAX_FRAMES   65536
+/* Operaciones alloc+free con la máquina casi llena */
+#define BENCH_CHURN_OPS    1024
+
+/* Tablas grandes de los benchmarks: vmalloc() en bench_run_all(), no
+ * .bss (serían ~264 KB de imagen aunque no se ejecute ningún bench) */
+static uint32_t* g_frames;
+
+/*
+ * Referencia "antes": el allocator original de pmm.c (escaneo lineal
+ * byte a byte, luego bit a bit, siempre desde el frame 0) sobre un
+ * bitmap propio del mismo tamaño que el PMM real.
+ */
+static uint8_t* legacy_bitmap;   /* BENCH_MAX_FRAMES / 8 bytes */
+static uint32_t legacy_bytes;
+
+static uint32_t legacy_alloc(void)
+{
+    for (uint32_t i = 0; i < legacy_bytes; i++) {
+        if (legacy_bitmap[i] == 0xFF) continue;
+        for (uint32_t j = 0; j < 8; j++) {
+            if (!((legacy_bitmap[i] >> j) & 1)) {
+                legacy_bitmap[i] |= (1 << j);
+                return i * 8 + j + 1;   /* +1: 0 significa "sin memoria" */
+            }
+        }
+    }
+    return 0;
+}
+
+static void legacy_free(uint32_t f)
+{
+    f--;
+    legacy_bitmap[f / 8] &= ~(uint8_t)(1 << (f % 8));
+}
+
+static void bench_pmm(void)
+{
+    uint32_t n = pmm_free_frames();
+    uint32_t t0, t1, i, got;
+
+    if (n > BENCH_MAX_FRAMES) n = BENCH_MAX_FRAMES;
+    legacy_bytes = (n + 7) / 8;
+    for (i = 0; i < legacy_bytes; i++)
+        legacy_bitmap[i] = 0;
+    if (n % 8)
+        legacy_bitmap[legacy_bytes - 1] = (uint8_t)(0xFF << (n % 8));
+
+    /* -- Antes: escaneo lineal -- */
+    t0 = rdtsc32();
+    for (i = 0; i < n; i++)
+        g_frames[i] = legacy_alloc();
+    t1 = rdtsc32();
+    bench_report("pmm legacy alloc-all", n, t1 - t0);
+
+    /* con la máquina llena, liberar uno del final y volver a pedirlo */
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_CHURN_OPS; i++) {
+        legacy_free(g_frames[n - 1 - (i % 64)]);
+        g_frames[n - 1 - (i % 64)] = legacy_alloc();
+    }
+    t1 = rdtsc32();
+    bench_report("pmm legacy churn (lleno)", BENCH_CHURN_OPS, t1 - t0);
+
+    t0 = rdtsc32();
+    for (i = 0; i < n; i++)
+        legacy_free(g_frames[i]);
+    t1 = rdtsc32();
+    bench_report("pmm legacy free-all", n, t1 - t0);
+
+    /* -- Después: bitmap de 2 niveles -- */
+    got = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < n; i++) {
+        g_frames[i] = pmm_alloc_frame();
+        if (!g_frames[i]) break;
+        got++;
+    }
+    t1 = rdtsc32();
+    bench_report("pmm alloc-all", got, t1 - t0);
+
+    if (got > 64) {
+        t0 = rdtsc32();
+        for (i = 0; i < BENCH_CHURN_OPS; i++) {
+            pmm_free_frame(g_frames[got - 1 - (i % 64)]);
+            g_frames[got - 1 - (i % 64)] = pmm_alloc_frame();
+        }
+        t1 = rdtsc32();
+        bench_report("pmm churn (lleno)", BENCH_CHURN_OPS, t1 - t0);
+    }
+
+    t0 = rdtsc32();
+    for (i = 0; i < got; i++)
+        pmm_free_frame(g_frames[i]);
+    t1 = rdtsc32();
+    bench_report("pmm free-all", got, t1 - t0);
+}
+
+/* ── Spawn: frames de directorio + page tables + stack de usuario ────── */
+
+#define BENCH_SPAWN_ITERS  64
+#define BENCH_STACK_PAGES  (USER_STACK_SIZE / PAGE_SIZE)
+#define BENCH_KMAP_PDI     (VMM_KMAP_BASE >> 22)
+
+/*
+ * Referencia "antes" de compartir las tablas del kernel: el directorio
+ * lleva una copia propia de cada page table del kernel con PTE_USER.
+ * Retorna los frames usados (en g_frames) o 0 sin memoria.
+ */
+static uint32_t legacy_clone_dir(void)
+{
+    uint32_t* kpd;
+    uint32_t need = 1, next = 1, i, j;
+    uint32_t* pd;
+
+    /* Formato clásico (entradas de 4 bytes, ventana kmap en el PDE
+     * 1021): con PAE no hay referencia "antes" que medir */
+    if (vmm_get_features() & VMM_FEAT_PAE) return 0;
+    kpd = (uint32_t*)vmm_kmap((uint32_t)vmm_get_kernel_directory());
+    if (!kpd) return 0;
+    for (i = 0; i < BENCH_KMAP_PDI; i++) {
+        if (kpd[i] & PTE_PRESENT) need++;
+    }
+    if (!pmm_alloc_batch(need, g_frames)) { vmm_kunmap(kpd); return 0; }
+
+    pd = (uint32_t*)vmm_kmap(g_frames[0]);
+    for (i = 0; i < 1024; i++) {
+        pd[i] = 0;
+        if (i >= BENCH_KMAP_PDI || !(kpd[i] & PTE_PRESENT)) continue;
+        uint32_t* newtbl = (uint32_t*)vmm_kmap(g_frames[next]);
+        if (kpd[i] & PTE_PS) {
+            /* con PSE el kernel ya no tiene tabla: la de 4KB de antes */
+            for (j = 0; j < 1024; j++)
+                newtbl[j] = ((kpd[i] & 0xFFC00000) + j * PAGE_SIZE) |
+                            PTE_PRESENT | PTE_WRITABLE | PTE_USER;
+        } else {
+            uint32_t* orig = (uint32_t*)vmm_kmap(kpd[i] & ~0xFFF);
+            for (j = 0; j < 1024; j++)
+                newtbl[j] = orig[j] | PTE_USER;
+            vmm_kunmap(orig);
+        }
+        vmm_kunmap(newtbl);
+        pd[i] = g_frames[next++] | PTE_PRESENT | PTE_WRITABLE | PTE_USER;
+    }
+    vmm_kunmap(pd);
+    vmm_kunmap(kpd);
+    return need;
+}
+
+/* Lo que hace proc_create_user() con la memoria: directorio, stack de
+ * usuario mapeado y una página de código (privatiza la tabla de 0-4MB) */
+static page_directory_t* spawn_dir(void)
+{
+    page_directory_t* dir = vmm_create_directory();
+    uint32_t stack[BENCH_STACK_PAGES];
+
+    if (!dir) return NULL;
+    if (pmm_alloc_batch(BENCH_STACK_PAGES, stack))
+        vmm_map_frames(dir, USER_STACK_TOP - USER_STACK_SIZE, stack,
+                       BENCH_STACK_PAGES, PTE_PRESENT | PTE_WRITABLE | PTE_USER);
+    vmm_map_page(dir, 0x00100000, 0x00100000, PTE_PRESENT | PTE_USER);
+    return dir;
+}
+
+/* Deshacer spawn_dir(): soltar el stack y después el directorio */
+static void spawn_teardown(page_directory_t* dir)
+{
+    for (uint32_t j = 0; j < BENCH_STACK_PAGES; j++) {
+        uint32_t va  = USER_STACK_TOP - USER_STACK_SIZE + j * PAGE_SIZE;
+        pte_t    pte = vmm_get_pte(dir, va);
+        vmm_unmap_page(dir, va);
+        if (pte & PTE_PRESENT) page_put(PTE_ADDR(pte));
+    }
+    vmm_destroy_directory(dir);
+}
+
+static void bench_spawn(void)
+{
+    uint32_t t0, t1, i, j, ok, need, before;
+    page_directory_t* dir;
+
+    /* -- Frames de un spawn: 1 a 1 vs pmm_alloc_batch() -- */
+    need = 2 + BENCH_STACK_PAGES;   /* directorio + tabla del stack + stack */
+    ok = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_SPAWN_ITERS; i++) {
+        for (j = 0; j < need; j++) {
+            g_frames[j] = pmm_alloc_frame();
+            if (!g_frames[j]) break;
+        }
+        while (j > 0)
+            pmm_free_frame(g_frames[--j]);
+        ok++;
+    }
+    t1 = rdtsc32();
+    bench_report("spawn frames (1 a 1)", ok, t1 - t0);
+
+    ok = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_SPAWN_ITERS; i++) {
+        if (!pmm_alloc_batch(need, g_frames)) break;
+        pmm_free_batch(need, g_frames);
+        ok++;
+    }
+    t1 = rdtsc32();
+    bench_report("spawn frames (batch)", ok, t1 - t0);
+
+    /* -- Directorio: clonar las tablas del kernel vs compartirlas -- */
+    need = legacy_clone_dir();
+    serial_puts("[bench] spawn clon: frames/dir=");
+    bench_print_dec(need);
+    serial_puts("\r\n");
+    pmm_free_batch(need, g_frames);
+
+    ok = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_SPAWN_ITERS; i++) {
+        need = legacy_clone_dir();
+        if (!need) break;
+        pmm_free_batch(need, g_frames);
+        ok++;
+    }
+    t1 = rdtsc32();
+    bench_report("spawn dir clonado", ok, t1 - t0);
+
+    before = pmm_free_frames();
+    dir = spawn_dir();
+    serial_puts("[bench] spawn compartido: frames/proceso (dir + stack)=");
+    bench_print_dec(before - pmm_free_frames());
+    serial_puts("\r\n");
+    if (dir) spawn_teardown(dir);
+
+    ok = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_SPAWN_ITERS; i++) {
+        dir = vmm_create_directory();
+        if (!dir) break;
+        vmm_destroy_directory(dir);
+        ok++;
+    }
+    t1 = rdtsc32();
+    bench_report("spawn dir compartido", ok, t1 - t0);
+
+    ok = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_SPAWN_ITERS; i++) {
+        dir = spawn_dir();
+        if (!dir) break;
+        spawn_teardown(dir);
+        ok++;
+    }
+    t1 = rdtsc32();
+    bench_report("spawn vmm (dir + stack + codigo)", ok, t1 - t0);
+}
+
+/* ── VMM: página a página vs rangos con invalidación diferida ────────── */
+
+#define BENCH_MAP_PAGES   256               /* 1MB */
+#define BENCH_MAP_VIRT    0x40000000
+
+/* Invalidaciones hechas desde la foto *before */
+static void bench_print_tlb(const char* name, const vmm_tlb_stats_t* before)
+{
+    vmm_tlb_stats_t ts;
+    vmm_get_tlb_stats(&ts);
+    serial_puts("[bench] tlb ");
+    serial_puts(name);
+    serial_puts(": invlpg=");
+    bench_print_dec(ts.invlpg - before->invlpg);
+    serial_puts(" cr3=");
+    bench_print_dec(ts.full_flushes - before->full_flushes);
+    serial_puts(" evitados=");
+    bench_print_dec(ts.avoided - before->avoided);
+    serial_puts("\r\n");
+}
+
+static void bench_vmm_range(void)
+{
+    page_directory_t* kdir = vmm_get_kernel_directory();
+    vmm_tlb_stats_t before;
+    uint32_t t0, t1, i;
+
+    if (!pmm_alloc_batch(BENCH_MAP_PAGES, g_frames)) return;
+
+    /* Directorio activo (el del kernel): primer mapeo, luego remapeo */
+    vmm_get_tlb_stats(&before);
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_MAP_PAGES; i++)
+        vmm_map_page(kdir, BENCH_MAP_VIRT + i * PAGE_SIZE, g_frames[i],
+                     PTE_PRESENT | PTE_WRITABLE);
+    for (i = 0; i < BENCH_MAP_PAGES; i++)
+        vmm_map_page(kdir, BENCH_MAP_VIRT + i * PAGE_SIZE, g_frames[i],
+                     PTE_PRESENT | PTE_WRITABLE);
+    for (i = 0; i < BENCH_MAP_PAGES; i++)
+        vmm_unmap_page(kdir, BENCH_MAP_VIRT + i * PAGE_SIZE);
+    t1 = rdtsc32();
+    bench_report("vmm map+remap+unmap 1 a 1", BENCH_MAP_PAGES, t1 - t0);
+    bench_print_tlb("1 a 1", &before);
+
+    vmm_get_tlb_stats(&before);
+    t0 = rdtsc32();
+    vmm_map_frames(kdir, BENCH_MAP_VIRT, g_frames, BENCH_MAP_PAGES,
+                   PTE_PRESENT | PTE_WRITABLE);
+    vmm_map_frames(kdir, BENCH_MAP_VIRT, g_frames, BENCH_MAP_PAGES,
+                   PTE_PRESENT | PTE_WRITABLE);
+    vmm_unmap_range(kdir, BENCH_MAP_VIRT, BENCH_MAP_PAGES * PAGE_SIZE);
+    t1 = rdtsc32();
+    bench_report("vmm map+remap+unmap rango", BENCH_MAP_PAGES, t1 - t0);
+    bench_print_tlb("rango", &before);
+
+    pmm_free_batch(BENCH_MAP_PAGES, g_frames);
+}
+
+/* ── Frames pre-zeroed: pool lleno vs. poner a cero en el momento ───── */
+
+static void bench_zero(void)
+{
+    pmm_zero_stats_t zs;
+    uint32_t t0, t1, i, n;
+
+    /* Pool lleno (lo que deja el idle) → todo hits */
+    pmm_zero_pool_refill(PMM_ZERO_POOL_SIZE);
+    t0 = rdtsc32();
+    for (i = 0; i < PMM_ZERO_POOL_SIZE; i++)
+        g_frames[i] = pmm_alloc_zeroed_frame();
+    t1 = rdtsc32();
+    bench_report("zeroed frame (pool)", PMM_ZERO_POOL_SIZE, t1 - t0);
+
+    /* Pool vacío → todo misses, cero síncrono */
+    t0 = rdtsc32();
+    for (n = PMM_ZERO_POOL_SIZE; n < 2 * PMM_ZERO_POOL_SIZE; n++)
+        g_frames[n] = pmm_alloc_zeroed_frame();
+    t1 = rdtsc32();
+    bench_report("zeroed frame (sincrono)", PMM_ZERO_POOL_SIZE, t1 - t0);
+
+    pmm_free_batch(n, g_frames);
+
+    pmm_get_zero_stats(&zs);
+    serial_puts("[bench] pool zero: hits=");
+    bench_print_dec(zs.hits);
+    serial_puts(" misses=");
+    bench_print_dec(zs.misses);
+    serial_puts("\r\n");
+}
+
+/* ── Fork: copia completa vs copy-on-write ───────────────────────────── */
+
+#define BENCH_FORK_ITERS   16
+#define BENCH_FORK_HEAP    256              /* 1MB de heap poblado */
+#define BENCH_FORK_VIRT    0x40000000
+#define BENCH_USER_RW      (PTE_PRESENT | PTE_WRITABLE | PTE_USER)
+
+/* Soltar los frames de usuario de [va, va + pages) y desmapearlos */
+static void release_user_range(page_directory_t* dir, uint32_t va,
+                               uint32_t pages)
+{
+    for (uint32_t j = 0; j < pages; j++) {
+        pte_t pte = vmm_get_pte(dir, va + j * PAGE_SIZE);
+        if (pte & PTE_PRESENT) page_put(PTE_ADDR(pte));
+    }
+    vmm_unmap_range(dir, va, pages * PAGE_SIZE);
+}
+
+/* Proceso de referencia: spawn_dir() + un heap de 1MB ya escrito */
+static page_directory_t* fork_parent(void)
+{
+    page_directory_t* dir = spawn_dir();
+    uint32_t i;
+
+    if (!dir) return NULL;
+    if (!pmm_alloc_batch(BENCH_FORK_HEAP, g_frames)) {
+        spawn_teardown(dir);
+        return NULL;
+    }
+    for (i = 0; i < BENCH_FORK_HEAP; i++) {
+        uint32_t* p = (uint32_t*)vmm_kmap(g_frames[i]);
+        if (p) { p[0] = i; vmm_kunmap(p); }
+        page_set(g_frames[i], PG_USER, 0);
+    }
+    vmm_map_frames(dir, BENCH_FORK_VIRT, g_frames, BENCH_FORK_HEAP,
+                   BENCH_USER_RW);
+    return dir;
+}
+
+/* Hijo (o padre): heap, stack y la referencia a la página de código que
+ * toma vmm_fork_directory() */
+static void fork_teardown(page_directory_t* dir, int code_ref)
+{
+    release_user_range(dir, BENCH_FORK_VIRT, BENCH_FORK_HEAP);
+    release_user_range(dir, USER_STACK_TOP - USER_STACK_SIZE,
+                       BENCH_STACK_PAGES);
+    if (code_ref) page_put(0x00100000);
+    vmm_destroy_directory(dir);
+}
+
+/* Fork "antes": copiar cada página de usuario escribible al hijo */
+static page_directory_t* eager_fork(page_directory_t* src)
+{
+    static const struct { uint32_t va, pages; } ranges[2] = {
+        { BENCH_FORK_VIRT, BENCH_FORK_HEAP },
+        { USER_STACK_TOP - USER_STACK_SIZE, BENCH_STACK_PAGES },
+    };
+    page_directory_t* dir = vmm_create_directory();
+
+    if (!dir) return NULL;
+    for (int r = 0; r < 2; r++) {
+        for (uint32_t j = 0; j < ranges[r].pages; j++) {
+            uint32_t va  = ranges[r].va + j * PAGE_SIZE;
+            pte_t    pte = vmm_get_pte(src, va);
+            uint32_t f, *d, *sp;
+
+            if (!(pte & PTE_PRESENT)) continue;
+            f = pmm_alloc_frame();
+            if (!f) return dir;
+            d  = (uint32_t*)vmm_kmap(f);
+            sp = (uint32_t*)vmm_kmap(PTE_ADDR(pte));
+            for (uint32_t k = 0; k < PAGE_SIZE / 4; k++) d[k] = sp[k];
+            vmm_kunmap(sp);
+            vmm_kunmap(d);
+            vmm_map_page(dir, va, f, BENCH_USER_RW);
+        }
+    }
+    vmm_map_page(dir, 0x00100000, 0x00100000, PTE_PRESENT | PTE_USER);
+    return dir;
+}
+
+static void bench_fork(void)
+{
+    page_directory_t *parent = fork_parent(), *child;
+    vmm_fault_stats_t fs;
+    uint32_t t0, t1, i, ok, before, copies;
+
+    if (!parent) return;
+
+    /* -- Copia completa -- */
+    before = pmm_free_frames();
+    child = eager_fork(parent);
+    serial_puts("[bench] fork copia: frames=");
+    bench_print_dec(before - pmm_free_frames());
+    serial_puts("\r\n");
+    if (child) fork_teardown(child, 0);
+
+    ok = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_FORK_ITERS; i++) {
+        child = eager_fork(parent);
+        if (!child) break;
+        fork_teardown(child, 0);
+        ok++;
+    }
+    t1 = rdtsc32();
+    bench_report("fork copia (1MB heap)", ok, t1 - t0);
+
+    /* -- Copy-on-write: solo tablas, los frames se comparten -- */
+    before = pmm_free_frames();
+    child = vmm_fork_directory(parent);
+    serial_puts("[bench] fork cow: frames=");
+    bench_print_dec(before - pmm_free_frames());
+    serial_puts("\r\n");
+    if (child) fork_teardown(child, 1);
+
+    ok = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_FORK_ITERS; i++) {
+        child = vmm_fork_directory(parent);
+        if (!child) break;
+        fork_teardown(child, 1);
+        ok++;
+    }
+    t1 = rdtsc32();
+    bench_report("fork cow (1MB heap)", ok, t1 - t0);
+
+    /* -- Primera escritura del hijo en cada página del heap -- */
+    child = vmm_fork_directory(parent);
+    if (child) {
+        vmm_get_fault_stats(&fs);
+        copies = fs.cow_copies;
+        t0 = rdtsc32();
+        for (i = 0; i < BENCH_FORK_HEAP; i++)
+            vmm_cow_break(child, BENCH_FORK_VIRT + i * PAGE_SIZE, 0);
+        t1 = rdtsc32();
+        vmm_get_fault_stats(&fs);
+        bench_report("fork cow: copia en escritura", fs.cow_copies - copies,
+                     t1 - t0);
+        fork_teardown(child, 1);
+    }
+
+    fork_teardown(parent, 0);
+}
+
+/* ── kmalloc: clases de tamaño y soak de dispositivos ────────────────── */
+
+#define BENCH_KMALLOC_OPS   256
+#define BENCH_SOAK_ITERS    20000
+
+/* Objetos vivos + slabs de todas las clases y páginas grandes */
+static void heap_usage(uint32_t* objs, uint32_t* frames)
+{
+    kmalloc_stats_t st;
+    kmalloc_get_stats(&st);
+    *objs = 0;
+    *frames = st.large_pages;
+    for (uint32_t c = 0; c < KMALLOC_CLASSES; c++) {
+        *objs   += st.cls[c].in_use;
+        *frames += st.cls[c].pages;
+    }
+}
+
+static void bench_kmalloc(void)
+{
+    static void* ptrs[BENCH_KMALLOC_OPS];
+    static DRIVER_OBJECT drv;
+    kmalloc_stats_t st;
+    uint32_t t0, t1, i, size, ok;
+    uint32_t objs0, frames0, objs1, frames1, pmm0;
+
+    /* -- Por clase: BENCH_KMALLOC_OPS allocs y luego sus frees -- */
+    for (size = 16; size <= KMALLOC_MAX_SMALL * 2; size <<= 1) {
+        t0 = rdtsc32();
+        for (i = 0; i < BENCH_KMALLOC_OPS; i++)
+            ptrs[i] = kmalloc(size);
+        for (i = 0; i < BENCH_KMALLOC_OPS; i++)
+            kfree(ptrs[i]);
+        t1 = rdtsc32();
+        serial_puts("[bench] kmalloc+kfree ");
+        bench_print_dec(size);
+        serial_puts("B");
+        bench_report("", BENCH_KMALLOC_OPS, t1 - t0);
+    }
+
+    /* -- Soak: IoCreateDevice/IoDeleteDevice en bucle. Con el bump
+     *    allocator cada vuelta perdía el DEVICE_OBJECT y su extensión -- */
+    heap_usage(&objs0, &frames0);
+    pmm0 = pmm_free_frames();
+    ok = 0;
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_SOAK_ITERS; i++) {
+        PDEVICE_OBJECT dev;
+        if (IoCreateDevice(&drv, 64 + (i & 0x3FF), NULL,
+                           FILE_DEVICE_UNKNOWN, 0, FALSE, &dev) != STATUS_SUCCESS)
+            break;
+        IoDeleteDevice(dev);
+        ok++;
+    }
+    t1 = rdtsc32();
+    bench_report("soak IoCreateDevice+IoDeleteDevice", ok, t1 - t0);
+    heap_usage(&objs1, &frames1);
+
+    serial_puts("[bench] soak: objetos vivos ");
+    bench_print_dec(objs0);
+    serial_puts(" -> ");
+    bench_print_dec(objs1);
+    serial_puts(", frames del heap ");
+    bench_print_dec(frames0);
+    serial_puts(" -> ");
+    bench_print_dec(frames1);
+    serial_puts(", frames libres del PMM ");
+    bench_print_dec(pmm0);
+    serial_puts(" -> ");
+    bench_print_dec(pmm_free_frames());
+    serial_puts(objs1 == objs0 && ok == BENCH_SOAK_ITERS ? " (sin fugas)\r\n"
+                                                          : " (FUGA)\r\n");
+
+    kmalloc_get_stats(&st);
+    for (i = 0; i < KMALLOC_CLASSES; i++) {
+        serial_puts("[bench] clase ");
+        bench_print_dec(st.cls[i].size);
+        serial_puts(": slabs=");
+        bench_print_dec(st.cls[i].slabs);
+        serial_puts(" uso=");
+        bench_print_dec(st.cls[i].in_use);
+        serial_puts("/");
+        bench_print_dec(st.cls[i].objects);
+        serial_puts(" allocs=");
+        bench_print_dec(st.cls[i].allocs);
+        serial_puts("\r\n");
+    }
+
+    /* -- Crecer el heap con bloques grandes y ver que vuelve a bajar -- */
+    kmalloc_get_stats(&st);
+    pmm0 = st.heap_pages;
+    for (i = 0; i < 64; i++)
+        ptrs[i] = kmalloc(64 * 1024);
+    kmalloc_get_stats(&st);
+    size = st.heap_pages;
+    for (i = 0; i < 64; i++)
+        kfree(ptrs[i]);
+    kmalloc_get_stats(&st);
+    serial_puts("[bench] heap: 64 x 64KB -> ");
+    bench_print_dec(size * 4);
+    serial_puts(" KB, tras liberar ");
+    bench_print_dec(st.heap_pages * 4);
+    serial_puts(" KB (pico ");
+    bench_print_dec(st.heap_peak * 4);
+    serial_puts(" KB)");
+    serial_puts(st.heap_pages == pmm0 ? " (devuelto al PMM)\r\n"
+                                      : " (NO DEVUELTO)\r\n");
+}
+
+/* ── Lookaside: objetos con stack de kernel, IRPs ─────────────────────── */
+
+#define BENCH_LOOKASIDE_OPS   4096
+
+/* Objeto de prueba con la forma de un thread_t: lo caro es el stack */
+typedef struct {
+    uint32_t stack;
+    uint32_t data[15];
+} bench_obj_t;
+
+static int bench_obj_ctor(void* obj)
+{
+    bench_obj_t* o = (bench_obj_t*)obj;
+    o->stack = pmm_alloc_pages(PMM_ORDER_FOR(KERNEL_STACK_SIZE));
+    return o->stack ? 0 : -1;
+}
+
+static void bench_obj_dtor(void* obj)
+{
+    pmm_free_pages(((bench_obj_t*)obj)->stack,
+                   PMM_ORDER_FOR(KERNEL_STACK_SIZE));
+}
+
+static void bench_print_list(const char* name, const lookaside_list_t* l)
+{
+    serial_puts("[bench] lookaside ");
+    serial_puts(name);
+    serial_puts(": allocs=");
+    bench_print_dec(l->total_allocs);
+    serial_puts(" fallos=");
+    bench_print_dec(l->alloc_misses);
+    serial_puts(" frees=");
+    bench_print_dec(l->total_frees);
+    serial_puts(" al heap=");
+    bench_print_dec(l->free_misses);
+    serial_puts(" guardados=");
+    bench_print_dec(l->count);
+    serial_puts("\r\n");
+}
+
+static void bench_lookaside(void)
+{
+    static lookaside_list_t list;
+    uint32_t t0, t1, i, objs0, frames0, objs1, frames1;
+    bench_obj_t* o;
+    PIRP irp;
+
+    /* -- Antes: kmalloc + stack del buddy en cada creación -- */
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_LOOKASIDE_OPS; i++) {
+        o = (bench_obj_t*)kmalloc(sizeof(bench_obj_t));
+        if (!o) break;
+        if (bench_obj_ctor(o) == 0) bench_obj_dtor(o);
+        kfree(o);
+    }
+    t1 = rdtsc32();
+    bench_report("kmalloc+ctor+dtor+kfree (objeto con stack)", i, t1 - t0);
+
+    /* -- Ahora: la lista conserva el objeto construido -- */
+    ExInitializeLookasideList(&list, bench_obj_ctor, bench_obj_dtor,
+                              sizeof(bench_obj_t),
+                              LOOKASIDE_TAG('B', 'n', 'c', 'h'), 0);
+    heap_usage(&objs0, &frames0);
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_LOOKASIDE_OPS; i++) {
+        o = (bench_obj_t*)ExAllocateFromLookasideList(&list);
+        if (!o) break;
+        ExFreeToLookasideList(&list, o);
+    }
+    t1 = rdtsc32();
+    bench_report("ExAllocate+ExFreeToLookasideList (objeto con stack)",
+                 i, t1 - t0);
+    bench_print_list("bench", &list);
+    ExDeleteLookasideList(&list);
+    heap_usage(&objs1, &frames1);
+    serial_puts(objs1 == objs0 ? "[bench] lookaside: heap sin cambios\r\n"
+                               : "[bench] lookaside: FUGA en el heap\r\n");
+
+    /* -- IRPs y DEVICE_OBJECTs del I/O manager -- */
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_LOOKASIDE_OPS; i++) {
+        irp = IoAllocateIrp(NULL);
+        if (!irp) break;
+        IoFreeIrp(irp);
+    }
+    t1 = rdtsc32();
+    bench_report("IoAllocateIrp+IoFreeIrp", i, t1 - t0);
+    bench_print_list("IRP", &IopIrpLookaside);
+    bench_print_list("DEVICE_OBJECT", &IopDeviceLookaside);
+}
+
+/* ── vmalloc: buffers grandes con frames sueltos ─────────────────────── */
+
+#define BENCH_VMALLOC_ITERS   64
+#define BENCH_VMALLOC_SIZE    (640 * 480)      /* shadow framebuffer VGA */
+
+static void bench_vmalloc(void)
+{
+    vmalloc_stats_t vs;
+    uint32_t t0, t1, i, pmm0;
+    uint8_t* p;
+
+    pmm0 = pmm_free_frames();
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_VMALLOC_ITERS; i++) {
+        p = (uint8_t*)vmalloc(BENCH_VMALLOC_SIZE);
+        if (!p) break;
+        p[0] = p[BENCH_VMALLOC_SIZE - 1] = (uint8_t)i;
+        vfree(p);
+    }
+    t1 = rdtsc32();
+    bench_report("vmalloc+vfree 300KB", i, t1 - t0);
+
+    vmalloc_get_stats(&vs);
+    serial_puts("[bench] vmalloc: areas=");
+    bench_print_dec(vs.areas);
+    serial_puts(" paginas=");
+    bench_print_dec(vs.pages);
+    serial_puts(" pico=");
+    bench_print_dec(vs.peak_pages);
+    serial_puts(" fallos=");
+    bench_print_dec(vs.failures);
+    serial_puts(", frames libres del PMM ");
+    bench_print_dec(pmm0);
+    serial_puts(" -> ");
+    bench_print_dec(pmm_free_frames());
+    serial_puts(pmm_free_frames() == pmm0 ? " (sin fugas)\r\n" : " (FUGA)\r\n");
+}
+
+/* ── mem*: rutinas por palabras vs. byte a byte ──────────────────────── */
+
+#define BENCH_MEM_MAX      (1024 * 1024)
+#define BENCH_MEM_BYTES    (4 * 1024 * 1024)  /* movidos por tamaño y rutina */
+
+/* Referencia "antes": los bucles byte a byte originales de lib/memory.c.
+ * volatile para que el compilador no los cambie por llamadas a memcpy */
+static void legacy_memcpy(void* dst, const void* src, size_t n)
+{
+    volatile uint8_t* d = (volatile uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    for (size_t i = 0; i < n; i++) d[i] = s[i];
+}
+
+static void legacy_memset(void* dst, int v, size_t n)
+{
+    volatile uint8_t* d = (volatile uint8_t*)dst;
+    for (size_t i = 0; i < n; i++) d[i] = (uint8_t)v;
+}
+
+static void bench_mem_pattern(uint8_t* p, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) p[i] = (uint8_t)(i * 7 + 1);
+}
+
+/* Ciclos por llamada de la rutina which (0 memcpy, 1 memset, 2 memmove,
+ * 3 memcmp, 4/5 memcpy/memset byte a byte) sobre size bytes */
+static uint32_t bench_mem_one(int which, uint8_t* dst, uint8_t* src,
+                              uint32_t size, uint32_t reps)
+{
+    uint32_t t0 = rdtsc32(), i;
+    volatile int r = 0;
+
+    for (i = 0; i < reps; i++) {
+        switch (which) {
+        case 0: memcpy(dst, src, size);            break;
+        case 1: memset(dst, (int)i, size);         break;
+        case 2: memmove(src + 1, src, size - 1);   break;
+        case 3: r += memcmp(dst, src, size);       break;
+        case 4: legacy_memcpy(dst, src, size);     break;
+        case 5: legacy_memset(dst, (int)i, size);  break;
+        }
+    }
+    (void)r;
+    return (rdtsc32() - t0) / reps;
+}
+
+static void bench_memory(void)
+{
+    static const char* names[] = { "memcpy", "memset", "memmove", "memcmp",
+                                   "memcpy byte", "memset byte" };
+    static const uint32_t sizes[] = { 8, 64, 512, 4096, 32768, 262144,
+                                      BENCH_MEM_MAX };
+    uint8_t* src = (uint8_t*)vmalloc(BENCH_MEM_MAX + 16);
+    uint8_t* dst = (uint8_t*)vmalloc(BENCH_MEM_MAX + 16);
+    uint32_t size, ok = 1;
+
+    if (!src || !dst) {
+        serial_puts("[bench] mem: sin memoria\r\n");
+        vfree(src);
+        vfree(dst);
+        return;
+    }
+
+    /* Correctitud: copias desalineadas y memmove solapado hacia atrás */
+    for (size = 1; size <= 8192; size = size * 3 + 1) {
+        bench_mem_pattern(src, size + 8);
+        memcpy(dst + 3, src + 1, size);
+        if (memcmp(dst + 3, src + 1, size) != 0) ok = 0;
+        memmove(src + 5, src + 2, size);
+        for (uint32_t i = 0; i < size; i++)
+            if (src[5 + i] != (uint8_t)((i + 2) * 7 + 1)) ok = 0;
+        dst[0] = dst[size + 1] = 0;
+        memset(dst + 1, 0xA5, size);
+        if (dst[0] || dst[1] != 0xA5 || dst[size] != 0xA5 || dst[size + 1])
+            ok = 0;
+    }
+    serial_puts(ok ? "[bench] mem: resultados correctos\r\n"
+                   : "[bench] mem: ERROR en memcpy/memmove/memset\r\n");
+
+    bench_mem_pattern(src, BENCH_MEM_MAX + 16);
+    for (uint32_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        uint32_t reps = BENCH_MEM_BYTES / sizes[k];
+        size = sizes[k];
+        serial_puts("[bench] mem ");
+        bench_print_dec(size);
+        serial_puts("B:");
+        for (int w = 0; w < 6; w++) {
+            serial_puts(" ");
+            serial_puts(names[w]);
+            serial_puts("=");
+            /* memcmp de bloques iguales: recorre todo */
+            if (w == 3) memcpy(dst, src, size);
+            bench_print_dec(bench_mem_one(w, dst, src, size, reps));
+        }
+        serial_puts(" ciclos/op\r\n");
+    }
+
+    vfree(src);
+    vfree(dst);
+}
+
+/* ── Swap: más memoria de usuario que RAM ────────────────────────────── */
+
+#define BENCH_SWAP_PROCS   8
+#define BENCH_SWAP_PAGES   512              /* 2MB por proceso */
+#define BENCH_SWAP_RAM     1024             /* frames que deja el globo (4MB) */
+#define BENCH_SWAP_PASSES  2
+#define BENCH_SWAP_REPS    4                /* vueltas seguidas por proceso */
+#define BENCH_SWAP_TAG(p, i)  (0x5A000000 | ((p) << 16) | (i))
+
+/* Frames que se come el "globo" para simular poca RAM: lista enlazada
+ * por la primera palabra de cada frame */
+static uint32_t g_balloon;
+
+static inline uint64_t rdtsc64(void)
+{
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* n / d con divl (sin __udivdi3); satura si el cociente no cabe */
+static uint32_t div64_32(uint64_t n, uint32_t d)
+{
+    uint32_t q, r, hi = (uint32_t)(n >> 32);
+    if (!d || hi >= d) return 0xFFFFFFFF;
+    __asm__("divl %4" : "=a"(q), "=d"(r) : "a"((uint32_t)n), "d"(hi), "rm"(d));
+    (void)r;
+    return q;
+}
+
+static uint32_t balloon_fill(uint32_t keep)
+{
+    uint32_t n = 0;
+    while (pmm_free_frames() > keep) {
+        uint32_t f = pmm_alloc_frame();
+        uint32_t* p;
+        if (!f) break;
+        p = (uint32_t*)vmm_kmap(f);
+        if (!p) { pmm_free_frame(f); break; }
+        *p = g_balloon;
+        vmm_kunmap(p);
+        g_balloon = f;
+        n++;
+    }
+    return n;
+}
+
+static void balloon_drain(void)
+{
+    while (g_balloon) {
+        uint32_t f = g_balloon;
+        uint32_t* p = (uint32_t*)vmm_kmap(f);
+        g_balloon = p ? *p : 0;
+        if (p) vmm_kunmap(p);
+        pmm_free_frame(f);
+    }
+}
+
+/* Correr "como" el proceso p: su thread como actual y su directorio en
+ * CR3, de modo que el #PF resuelve sobre sus VMAs (y cuenta sus fallos) */
+static void swap_enter(process_t* p)
+{
+    proc_set_current_thread(p->main_thread);
+    vmm_load_directory(p->page_dir);
+}
+
+/* Tocar cada página del área del proceso idx (en base): la etiqueta en
+ * la palabra 0 y un contador de visitas en la 1 */
+static void swap_touch(uint32_t base, uint32_t idx)
+{
+    volatile uint32_t* w;
+    for (uint32_t i = 0; i < BENCH_SWAP_PAGES; i++) {
+        w = (volatile uint32_t*)(base + i * PAGE_SIZE);
+        if (w[0] != BENCH_SWAP_TAG(idx, i)) w[0] = BENCH_SWAP_TAG(idx, i);
+        w[1]++;
+    }
+}
+
+static void bench_swap_report(const char* name, uint32_t accesses,
+                              uint32_t majors, uint64_t cycles)
+{
+    uint32_t mcycles = (uint32_t)(cycles >> 20);
+    serial_puts("[bench] swap ");
+    serial_puts(name);
+    serial_puts(": ");
+    bench_print_dec(accesses);
+    serial_puts(" paginas, ");
+    bench_print_dec(majors);
+    serial_puts(" fallos mayores, ");
+    bench_print_dec(div64_32(cycles, accesses ? accesses : 1));
+    serial_puts(" ciclos/pagina, ");
+    bench_print_dec(mcycles ? accesses / mcycles : accesses);
+    serial_puts(" paginas/Mciclo\r\n");
+}
+
+static void bench_swap(void)
+{
+    extern uint8_t _user_start, _user_end;
+    extern void user_entry(void);
+    thread_t* idle = proc_current_thread();
+    page_directory_t* kdir = vmm_get_kernel_directory();
+    process_t* procs[BENCH_SWAP_PROCS];
+    uint32_t base[BENCH_SWAP_PROCS];
+    vmm_fault_stats_t fs0, fs1;
+    swap_stats_t ss;
+    uint32_t i, r, pass, n = 0, pmm0, errors = 0, ballooned;
+    uint64_t t0;
+
+    swap_get_stats(&ss);
+    if (!swap_active()) {
+        serial_puts("[bench] swap: sin disco de swap (./run.sh -w 64)\r\n");
+        return;
+    }
+    if (ss.slots - ss.used < BENCH_SWAP_PROCS * BENCH_SWAP_PAGES) {
+        serial_puts("[bench] swap: area de swap muy chica\r\n");
+        return;
+    }
+    pmm0 = pmm_free_frames();
+
+    /* Procesos de usuario de verdad (sin correr: el scheduler aún no
+     * arrancó), cada uno con un área anónima de BENCH_SWAP_PAGES */
+    for (n = 0; n < BENCH_SWAP_PROCS; n++) {
+        procs[n] = proc_create_user("swapbench", (uint32_t)&_user_start,
+                                    (uint32_t)(&_user_end - &_user_start),
+                                    (uint32_t)user_entry);
+        if (!procs[n]) break;
+        base[n] = vma_mmap(&procs[n]->vm, procs[n]->page_dir, 0,
+                           BENCH_SWAP_PAGES * PAGE_SIZE, PTE_WRITABLE, 0);
+        if (!base[n]) { proc_destroy(procs[n]); break; }
+    }
+
+    ballooned = balloon_fill(BENCH_SWAP_RAM);
+    serial_puts("[bench] swap: ");
+    bench_print_dec(n);
+    serial_puts(" procesos x ");
+    bench_print_dec(BENCH_SWAP_PAGES * (PAGE_SIZE / 1024));
+    serial_puts(" KB con ");
+    bench_print_dec(pmm_free_frames() * (PAGE_SIZE / 1024));
+    serial_puts(" KB libres (globo ");
+    bench_print_dec(ballooned * (PAGE_SIZE / 1024));
+    serial_puts(" KB)\r\n");
+
+    /* -- Primer toque: todo minor, el reclaim hace lugar -- */
+    vmm_get_fault_stats(&fs0);
+    t0 = rdtsc64();
+    for (i = 0; i < n; i++) {
+        swap_enter(procs[i]);
+        swap_touch(base[i], i);
+    }
+    vmm_get_fault_stats(&fs1);
+    bench_swap_report("primer toque", n * BENCH_SWAP_PAGES,
+                      fs1.major - fs0.major, rdtsc64() - t0);
+
+    /* -- Barrido round-robin: el conjunto no entra, casi todo mayor -- */
+    vmm_get_fault_stats(&fs0);
+    t0 = rdtsc64();
+    for (pass = 0; pass < BENCH_SWAP_PASSES; pass++) {
+        for (i = 0; i < n; i++) {
+            swap_enter(procs[i]);
+            swap_touch(base[i], i);
+        }
+    }
+    vmm_get_fault_stats(&fs1);
+    bench_swap_report("round-robin", BENCH_SWAP_PASSES * n * BENCH_SWAP_PAGES,
+                      fs1.major - fs0.major, rdtsc64() - t0);
+
+    /* -- Localidad: cada proceso entra en RAM, vueltas seguidas -- */
+    vmm_get_fault_stats(&fs0);
+    t0 = rdtsc64();
+    for (i = 0; i < n; i++) {
+        swap_enter(procs[i]);
+        for (r = 0; r < BENCH_SWAP_REPS; r++)
+            swap_touch(base[i], i);
+    }
+    vmm_get_fault_stats(&fs1);
+    bench_swap_report("localidad", BENCH_SWAP_REPS * n * BENCH_SWAP_PAGES,
+                      fs1.major - fs0.major, rdtsc64() - t0);
+
+    /* -- Verificación: cada página volvió con su contenido -- */
+    for (i = 0; i < n; i++) {
+        swap_enter(procs[i]);
+        for (r = 0; r < BENCH_SWAP_PAGES; r++) {
+            volatile uint32_t* w =
+                (volatile uint32_t*)(base[i] + r * PAGE_SIZE);
+            if (w[0] != BENCH_SWAP_TAG(i, r) ||
+                w[1] != 1 + BENCH_SWAP_PASSES + BENCH_SWAP_REPS)
+                errors++;
+        }
+    }
+    vmm_load_directory(kdir);
+    proc_set_current_thread(idle);
+
+    serial_puts("[bench] swap: fallos mayores por proceso:");
+    for (i = 0; i < n; i++) {
+        serial_puts(" ");
+        bench_print_dec(procs[i]->major_faults);
+    }
+    swap_get_stats(&ss);
+    serial_puts("\r\n[bench] swap: out=");
+    bench_print_dec(ss.pages_out);
+    serial_puts(" in=");
+    bench_print_dec(ss.pages_in);
+    serial_puts(" reclaims=");
+    bench_print_dec(ss.reclaims);
+    serial_puts(" segunda oportunidad=");
+    bench_print_dec(ss.referenced);
+    serial_puts(" errores de disco=");
+    bench_print_dec(ss.io_errors);
+    serial_puts(errors ? "\r\n[bench] swap: ERROR, paginas corruptas=" :
+                         "\r\n[bench] swap: contenido correcto, corruptas=");
+    bench_print_dec(errors);
+    serial_puts("\r\n");
+
+    balloon_drain();
+    for (i = 0; i < n; i++)
+        proc_destroy(procs[i]);
+
+    swap_get_stats(&ss);
+    serial_puts("[bench] swap: slots ocupados al final=");
+    bench_print_dec(ss.used);
+    serial_puts(", frames libres del PMM ");
+    bench_print_dec(pmm0);
+    serial_puts(" -> ");
+    bench_print_dec(pmm_free_frames());
+    serial_puts("\r\n");
+}
+
+/* ── Superficie de usuario: trap por rectángulo vs. un solo damage ──── */
+
+#define BENCH_SURF_REDRAWS  8
+#define BENCH_SURF_X        160
+#define BENCH_SURF_Y        140
+#define BENCH_SURF_W        320
+#define BENCH_SURF_H        16
+
+static void surf_mem_fill(uint8_t* buf, int x, int y, int w, int h,
+                          uint8_t color)
+{
+    for (int row = y; row < y + h; row++)
+        memset(buf + (uint32_t)row * BENCH_SURF_W + x, color, (size_t)w);
+}
+
+/*
+ * La paleta de gui_user: fondo + 16 muestras. (A) una SYS_FILL_RECT por
+ * rectángulo con el wrapper de libsys (int 0x30 desde ring 0: el iret del
+ * stub restaura IF=0, así que no se habilitan interrupciones); (B) pintar en una superficie en memoria
+ * y publicar el rectángulo con VgaBlitRect, que es lo que ejecuta
+ * SYS_SURFACE_DAMAGE (más la copia desde usuario). Corre antes de
+ * iniciar la pantalla, así que ambos caminos escriben solo el shadow.
+ */
+static void bench_surface(void)
+{
+    uint32_t t0, t1, i;
+    int own_shadow = 0;
+    uint8_t* surf;
+
+    if (!VgaGetShadowBuffer(NULL, NULL)) {
+        if (VgaAllocateShadow() != STATUS_SUCCESS) return;
+        own_shadow = 1;
+    }
+    surf = (uint8_t*)vmalloc(BENCH_SURF_W * BENCH_SURF_H);
+    if (!surf) {
+        if (own_shadow) VgaFreeShadow();
+        return;
+    }
+
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_SURF_REDRAWS; i++) {
+        sys_fill_rect(BENCH_SURF_X, BENCH_SURF_Y, BENCH_SURF_W, BENCH_SURF_H, 7);
+        for (int c = 0; c < 16; c++)
+            sys_fill_rect(BENCH_SURF_X + c * 20 + 1, BENCH_SURF_Y + 1,
+                          18, 14, (uint8_t)c);
+    }
+    t1 = rdtsc32();
+    bench_report("paleta: SYS_FILL_RECT por rectangulo", i, t1 - t0);
+
+    t0 = rdtsc32();
+    for (i = 0; i < BENCH_SURF_REDRAWS; i++) {
+        surf_mem_fill(surf, 0, 0, BENCH_SURF_W, BENCH_SURF_H, 7);
+        for (int c = 0; c < 16; c++)
+            surf_mem_fill(surf, c * 20 + 1, 1, 18, 14, (uint8_t)c);
+        VgaBlitRect(BENCH_SURF_X, BENCH_SURF_Y, BENCH_SURF_W, BENCH_SURF_H,
+                    surf, BENCH_SURF_W);
+    }
+    t1 = rdtsc32();
+    bench_report("paleta: superficie + un damage", i, t1 - t0);
+
+    /* Ambos caminos deben dejar el mismo contenido en el shadow */
+    {
+        uint32_t pitch, bad = 0;
+        const uint8_t* sh = VgaGetShadowBuffer(NULL, &pitch);
+        for (uint32_t row = 0; row < BENCH_SURF_H; row++)
+            if (memcmp(sh + (BENCH_SURF_Y + row) * pitch + BENCH_SURF_X,
+                       surf + row * BENCH_SURF_W, BENCH_SURF_W) != 0)
+                bad++;
+        serial_puts(bad ? "[bench] superficie: shadow DISTINTO\r\n"
+                        : "[bench] superficie: shadow identico\r\n");
+    }
+
+    vfree(surf);
+    if (own_shadow) VgaFreeShadow();
+}
+
+/* ── Punto de entrada ─────────────────────────────────────────────────── */
+
+void bench_run_all(void)
+{
+    serial_puts("[bench] inicio\r\n");
+    g_frames      = (uint32_t*)vmalloc(BENCH_MAX_FRAMES * sizeof(uint32_t));
+    legacy_bitmap = (uint8_t*)vmalloc(BENCH_MAX_FRAMES / 8);
+    if (!g_frames || !legacy_bitmap) {
+        serial_puts("[bench] sin memoria para las tablas\r\n");
+        vfree(g_frames);
+        vfree(legacy_bitmap);
+        return;
+    }
+    bench_pmm();
+    bench_spawn();
+    bench_vmm_range();
+    bench_zero();
+    bench_fork();
+    bench_kmalloc();
+    bench_lookaside();
+    bench_vmalloc();
+    bench_memory();
+    bench_swap();
+    bench_surface();
+    vfree(legacy_bitmap);
+    vfree(g_frames);
+    serial_puts("[bench] fin\r\n");
+}
+
+#endif /* KERNEL_BENCH */
@@ -0,0 +1,21 @@
+/*
+ * bench.h — Micro-benchmarks del kernel
+ *
+ * Solo se compilan con KERNEL_BENCH definido:
+ *   make BENCH=1            (Makefile)
+ *   cmake -DKERNEL_BENCH=ON (CMake)
+ *
+ * kernel_main() llama a bench_run_all() una vez que PMM/VMM y el gestor
+ * de procesos están listos. Los resultados salen por COM1 en ciclos de
+ * TSC (rdtsc) por operación, así que basta con ./run.sh y revisar
+ * serial.log.
+ */
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <types.h>
+
+/* Ejecutar todos los benchmarks registrados y volcar resultados a serial */
+void bench_run_all(void);
+
+#endif /* _BENCH_H */
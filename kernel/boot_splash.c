@@ -32,6 +32,7 @@
  */
 
 #include "boot_splash.h"
+#include <init.h>
 
 /* ===========================================================================
  * SECCION 1: ACCESO A PUERTOS I/O
@@ -98,7 +99,7 @@ static inline void ac_w(unsigned char idx, unsigned char val)
  * Tablas extraidas de RBIL, FreeVGA y codigo fuente de VGABIOS (LGPLv2).
  * =========================================================================== */
 
-static void set_mode13h(void)
+static void __init set_mode13h(void)
 {
     /* Miscellaneous Output: 25.175 MHz, color I/O base 3Dx */
     outb(VGA_MISC_WRITE, 0x63);
@@ -186,7 +187,7 @@ static void set_mode13h(void)
  * Los 128 caracteres ASCII imprimibles (0x20-0x7F) cubren todo lo necesario.
  * Los caracteres 0x00-0x1F se mapean al glifo de espacio.
  */
-static const unsigned char EMBEDDED_FONT_8X16[256][16] = {
+static const unsigned char EMBEDDED_FONT_8X16[256][16] __initconst = {
     /* 0x00-0x1F: caracteres de control -> espacio */
     [0 ... 31] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},
     /* 0x20 SPACE   */ [0x20]={0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
@@ -289,7 +290,7 @@ static const unsigned char EMBEDDED_FONT_8X16[256][16] = {
     [128 ... 255] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},
 };
 
-static void load_font_from_bios(void)
+static void __init load_font_from_bios(void)
 {
     /*
      * FIX: Ya no leemos desde 0xF0000 (ROM BIOS no mapeada en modo protegido).
@@ -324,7 +325,7 @@ static void load_font_from_bios(void)
     }
 }
 
-static void set_mode3(void)
+static void __init set_mode3(void)
 {
     /* Miscellaneous Output: 25.175 MHz color, I/O @ 3Dx */
     outb(VGA_MISC_WRITE, 0x67);
@@ -416,7 +417,7 @@ static void set_mode3(void)
  * SECCION 4: PALETA DAC (componentes 0-63 por canal)
  * =========================================================================== */
 
-static void dac_set(unsigned char idx, unsigned char r,
+static void __init dac_set(unsigned char idx, unsigned char r,
                     unsigned char g, unsigned char b)
 {
     outb(VGA_DAC_WRITE, idx);
@@ -432,7 +433,7 @@ static void dac_set(unsigned char idx, unsigned char r,
  *  8 = Gris oscuro  10 = Verde barra      11 = Verde claro
  * 15 = Blanco       20 = Azul fondo alto  21 = Azul fondo bajo
  */
-static void setup_palette(void)
+static void __init setup_palette(void)
 {
     dac_set(0,   0,  0,  0);
     dac_set(1,   0,  7, 37);
@@ -458,7 +459,7 @@ static inline void px(int x, int y, unsigned char c)
         VGA13_FB[y * VGA13_W + x] = c;
 }
 
-static void fill_rect(int x, int y, int w, int h, unsigned char c)
+static void __init fill_rect(int x, int y, int w, int h, unsigned char c)
 {
     int dx, dy;
     for (dy = 0; dy < h; dy++)
@@ -466,14 +467,14 @@ static void fill_rect(int x, int y, int w, int h, unsigned char c)
             px(x + dx, y + dy, c);
 }
 
-static void fb_clear(unsigned char c)
+static void __init fb_clear(unsigned char c)
 {
     unsigned char *p = VGA13_FB;
     int i;
     for (i = 0; i < VGA13_W * VGA13_H; i++) p[i] = c;
 }
 
-static void rect_outline(int x, int y, int w, int h, unsigned char c)
+static void __init rect_outline(int x, int y, int w, int h, unsigned char c)
 {
     int i;
     for (i = 0; i < w; i++) { px(x+i,y,c); px(x+i,y+h-1,c); }
@@ -484,7 +485,7 @@ static void rect_outline(int x, int y, int w, int h, unsigned char c)
  * SECCION 6: FONT 8x8
  * =========================================================================== */
 
-static const unsigned char FONT8X8[91][8] = {
+static const unsigned char FONT8X8[91][8] __initconst = {
     /* 32 ' '  */ {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
     /* 33 '!'  */ {0x18,0x3C,0x3C,0x18,0x18,0x00,0x18,0x00},
     /* 34 '"'  */ {0x36,0x36,0x00,0x00,0x00,0x00,0x00,0x00},
@@ -582,7 +583,7 @@ static const unsigned char FONT8X8[91][8] = {
  * SECCION 7: PRIMITIVAS DE TEXTO EN MODO GRAFICO
  * =========================================================================== */
 
-static void draw_char(int sx, int sy, char c,
+static void __init draw_char(int sx, int sy, char c,
                        unsigned char color, int scale)
 {
     int row, col, bx, by;
@@ -604,15 +605,15 @@ static void draw_char(int sx, int sy, char c,
     }
 }
 
-static int slen(const char *s) { int n=0; while(s[n]) n++; return n; }
+static int __init slen(const char *s) { int n=0; while(s[n]) n++; return n; }
 
-static void draw_str(int x, int y, const char *s,
+static void __init draw_str(int x, int y, const char *s,
                       unsigned char color, int scale)
 {
     while (*s) { draw_char(x, y, *s, color, scale); x += 8*scale; s++; }
 }
 
-static void draw_str_c(int y, const char *s,
+static void __init draw_str_c(int y, const char *s,
                         unsigned char color, int scale)
 {
     int w = slen(s) * 8 * scale;
@@ -623,7 +624,7 @@ static void draw_str_c(int y, const char *s,
  * SECCION 8: DELAY SIN BIOS
  * =========================================================================== */
 
-static void delay_ms(unsigned int ms)
+static void __init delay_ms(unsigned int ms)
 {
     /* ~2000 NOPs por ms en QEMU sin KVM. volatile evita que -O2 lo elimine. */
     const unsigned int K = 2000;
@@ -636,7 +637,7 @@ static void delay_ms(unsigned int ms)
  * =========================================================================== */
 
 /* isqrt entera sin FPU */
-static int isqrt(int n)
+static int __init isqrt(int n)
 {
     int q;
     if (n <= 0) return 0;
@@ -645,7 +646,7 @@ static int isqrt(int n)
     return q;
 }
 
-static void fill_ellipse(int cx, int cy, int rx, int ry, unsigned char c)
+static void __init fill_ellipse(int cx, int cy, int rx, int ry, unsigned char c)
 {
     int r;
     for (r = -ry; r <= ry; r++) {
@@ -655,7 +656,7 @@ static void fill_ellipse(int cx, int cy, int rx, int ry, unsigned char c)
     }
 }
 
-static void stroke_ellipse(int cx, int cy, int rx, int ry, unsigned char c)
+static void __init stroke_ellipse(int cx, int cy, int rx, int ry, unsigned char c)
 {
     int r;
     for (r = -ry; r <= ry; r++) {
@@ -665,7 +666,7 @@ static void stroke_ellipse(int cx, int cy, int rx, int ry, unsigned char c)
     }
 }
 
-static void draw_logo(void)
+static void __init draw_logo(void)
 {
     int row;
     /* Fondo degradado */
@@ -701,7 +702,7 @@ static void draw_logo(void)
 #define BAR_W  200
 #define BAR_H  9
 
-static void draw_uint(int x, int y, unsigned int n, unsigned char c)
+static void __init draw_uint(int x, int y, unsigned int n, unsigned char c)
 {
     char buf[12]; int i = 10; buf[11] = '\0';
     if (n == 0) { buf[--i] = '0'; }
@@ -709,7 +710,7 @@ static void draw_uint(int x, int y, unsigned int n, unsigned char c)
     draw_str(x, y, buf + i, c, 1);
 }
 
-static void draw_progress(int step, int total, const char *label)
+static void __init draw_progress(int step, int total, const char *label)
 {
     int filled, pct;
     /* Fondo barra */
@@ -737,7 +738,7 @@ static void draw_progress(int step, int total, const char *label)
  * SECCION 11: PUNTO DE ENTRADA PUBLICO
  * =========================================================================== */
 
-void KernelShowBootSplash(void)
+void __init KernelShowBootSplash(void)
 {
     int i;
     const char *labels[5] = {
@@ -6,6 +6,9 @@
  *
  * Si el BIOS no soporta cambio de modo de video, la función retorna
  * inmediatamente sin modificar nada — el kernel sigue su camino normal.
+ *
+ * Todo el módulo (código, fuentes y paleta) es __init: sus páginas se
+ * devuelven al PMM cuando arranca el scheduler.
  */
 #ifndef _BOOT_SPLASH_H
 #define _BOOT_SPLASH_H
@@ -79,3 +79,36 @@ void cpu_enable_interrupts(void)
 {
     __asm__ volatile("sti");
 }
+
+/* ¿Se puede cambiar EFLAGS.ID (bit 21)? Entonces existe CPUID */
+static int cpu_has_cpuid(void)
+{
+    uint32_t before, after;
+    __asm__ volatile(
+        "pushf\n"
+        "pop %0\n"
+        "mov %0, %1\n"
+        "xor $0x200000, %1\n"
+        "push %1\n"
+        "popf\n"
+        "pushf\n"
+        "pop %1\n"
+        "push %0\n"
+        "popf\n"
+        : "=&r"(before), "=&r"(after) :: "cc");
+    return ((before ^ after) & 0x200000) != 0;
+}
+
+void cpu_cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx,
+               uint32_t* ecx, uint32_t* edx)
+{
+    uint32_t a = 0, b = 0, c = 0, d = 0;
+    if (cpu_has_cpuid())
+        __asm__ volatile("cpuid"
+                         : "=a"(a), "=b"(b), "=c"(c), "=d"(d)
+                         : "a"(leaf), "c"(0));
+    if (eax) *eax = a;
+    if (ebx) *ebx = b;
+    if (ecx) *ecx = c;
+    if (edx) *edx = d;
+}
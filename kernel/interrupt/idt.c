@@ -17,6 +17,10 @@
 #include "types.h"
 #include "../drivers/video/vga/vga.h"    /* colores VGA para pf_report */
 #include "../proc/process.h"   /* cpu_context_t se encuentra en kernel/proc */
+#include "../mm/fault.h"       /* vmm_handle_page_fault */
+#include "../mm/uaccess.h"     /* uaccess_fixup */
+
+extern void serial_print_hex(uint32_t v);   /* syscall.c */
 
 /* I/O helpers para puerto serial/com1 0x3F8 */
 static inline void outb(uint16_t port, uint8_t val) {
@@ -153,8 +157,7 @@ static inline void pic_eoi(uint8_t irq)
  * ═══════════════════════════════════════════════════════ */
 
 /* Reportar direcciones de page fault */
-/* pf_report is referenced from inline assembly in exc_page_fault, so
-   cannot be static (otherwise linker drops it). */
+/* pf_report lo usa page_fault_handler cuando el fallo no se resuelve */
 /* última dirección que provocó un PF; visible incluso antes de serial */
 volatile uint32_t g_last_pf_addr = 0;
 
@@ -254,24 +257,79 @@ __asm__(
 /* Resto de excepciones     → 'EX' */
 EXCEPTION_STUB(exc_generic,             0x4C45, 0x4C58);
 
-/* Definición manual del handler de page fault para mostrar CR2 */
+/*
+ * Page fault (0x0E)
+ *
+ * La CPU ya empujó el error code encima de eip/cs/eflags (y user_esp/ss
+ * si venía de Ring 3). Completamos un cpu_context_t igual que IRQ0:
+ * int_no, pusha y segmentos, y llamamos a page_fault_handler(ctx). Si
+ * retorna es que la página quedó mapeada: restaurar todo y reintentar.
+ */
+void page_fault_handler(cpu_context_t* ctx)
+{
+    uint32_t addr, fixup;
+    __asm__ volatile("mov %%cr2, %0" : "=r"(addr));
+
+    /* demand paging (VMAs del proceso actual) y copy-on-write */
+    if (vmm_handle_page_fault(addr, ctx->err_code))
+        return;
+
+    /* El kernel falló copiando de/a usuario: continuar en el fixup de
+     * la instrucción (la copia retorna -EFAULT) */
+    if ((ctx->cs & 3) == 0 && (fixup = uaccess_fixup(ctx->eip)) != 0) {
+        ctx->eip = fixup;
+        return;
+    }
+
+    /* Fallo real: reportar y congelar la CPU como antes */
+    vmm_note_fatal_fault();
+    pf_report(addr);
+    serial_puts("PF EIP=");
+    serial_print_hex(ctx->eip);
+    serial_puts(" ERR=");
+    serial_print_hex(ctx->err_code);
+    serial_puts(" CS=");
+    serial_print_hex(ctx->cs);
+    if ((ctx->cs & 3) == 3) {
+        serial_puts(" ESP3=");
+        serial_print_hex(ctx->user_esp);
+    }
+    serial_puts("\r\n");
+
+    /* dibujar 'PF' como antes */
+    *(volatile uint16_t*)(0xB8000 + 78 * 2) = 0x4C50;
+    *(volatile uint16_t*)(0xB8000 + 79 * 2) = 0x4C46;
+    __asm__ volatile("cli");
+    for (;;) __asm__ volatile("hlt");
+}
+
 void exc_page_fault(void);
 __asm__(
     ".global exc_page_fault\n"
     "exc_page_fault:\n"
-    /* guardar dirección fallida en variable */
-    "  movl %cr2, %eax\n"
-    "  push %eax\n"
-    "  call pf_report\n"
-    "  add $4, %esp\n"
-    /* dibujar 'PF' como antes */
-    "  movl $0xB8000+(78*2), %eax\n"
-    "  movw $0x4C50, (%eax)\n"
-    "  movl $0xB8000+(79*2), %eax\n"
-    "  movw $0x4C46, (%eax)\n"
-    "  cli\n"
-    "1: hlt\n"
-    "  jmp 1b\n"
+    /* err_code ya está en el stack; int_no encima */
+    "  pushl $0x0E\n"
+    "  pusha\n"
+    "  pushl %gs\n"
+    "  pushl %fs\n"
+    "  pushl %es\n"
+    "  pushl %ds\n"
+    "  movw $0x10, %ax\n"
+    "  movw %ax,   %ds\n"
+    "  movw %ax,   %es\n"
+    "  movw %ax,   %fs\n"
+    "  movw %ax,   %gs\n"
+    "  movl %esp, %ebx\n"   /* EBX = cpu_context_t* */
+    "  pushl %ebx\n"
+    "  call page_fault_handler\n"
+    "  addl $4, %esp\n"
+    "  popl %ds\n"
+    "  popl %es\n"
+    "  popl %fs\n"
+    "  popl %gs\n"
+    "  popa\n"
+    "  addl $8, %esp\n"     /* int_no + err_code */
+    "  iret\n"
 );
 
 /* ═══════════════════════════════════════════════════════
@@ -1,12 +1,16 @@
 #include "syscall.h"
 #include <gui.h>           /* GUI_WINDOW, GUI_MOUSE_EVENT */
-#include "../mm/vmm.h"   /* para validación de punteros y estructuras PTE */
+#include "../mm/vmm.h"   /* estructuras PTE */
+#include "../mm/uaccess.h" /* copy_from_user, copy_to_user, strncpy_from_user */
+#include "../mm/pmm.h"   /* PAGE_ALIGN */
+#include "../mm/page.h"  /* page_get (shadow compartido) */
 #include "../proc/process.h"
 #include "../proc/scheduler.h"
 #include "../drivers/video/vga/vga.h"    /* funciones VGA */
 #include "../drivers/video/vga/vga_font.h" /* VgaDrawString */
 #include "../drivers/input/ps2mouse.h" /* MOUSE_STATE */
 #include "../../include/libsys.h"  /* definiciones de SYS_MOUSE, etc. */
+#include <kstdlib.h>
 #include <types.h>
 
 /* función de serial definida en idt.c */
@@ -31,37 +35,6 @@ void syscall_tick_increment(void)
     }
 }
 
-/* Validación sencilla de punteros de usuario. Acepta direcciones < 0x80000000. */
-static int is_user_ptr(const void* p)
-{
-    uint32_t addr = (uint32_t)p;
-    if (addr >= 0x80000000) return 0;
-    /* verify page table entries have U bit set; protect from kernel-only addresses */
-    uint32_t cr3;
-    __asm__ volatile("mov %%cr3, %0" : "=r"(cr3));
-    /* walk two-level page tables */
-    pde_t *pde = (pde_t*)((cr3 & ~0xFFF) + ((addr >> 22) * sizeof(pde_t)));
-    if (!(*pde & PTE_PRESENT) || !(*pde & PTE_USER))
-        return 0;
-    pte_t *pte = (pte_t*)((*pde & ~0xFFF) + (((addr >> 12) & 0x3FF) * sizeof(pte_t)));
-    if (!(*pte & PTE_PRESENT) || !(*pte & PTE_USER))
-        return 0;
-    return 1;
-}
-
-/* Copia bytes de un buffer de usuario a kernel; retorna 0 en éxito, -1 en fallo. */
-static int copy_from_user(void* dest, const void* src, size_t len)
-{
-    uint8_t* d = (uint8_t*)dest;
-    const uint8_t* s = (const uint8_t*)src;
-    for (size_t i = 0; i < len; i++) {
-        if (!is_user_ptr(s + i))
-            return -1;
-        d[i] = s[i];
-    }
-    return 0;
-}
-
 /* helper to print a 32-bit value in hex to serial */
 void serial_print_hex(uint32_t v)
 {
@@ -75,6 +48,18 @@ void serial_print_hex(uint32_t v)
     serial_puts(buf);
 }
 
+void serial_print_dec(uint32_t v)
+{
+    char buf[11];
+    int i = 10;
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + (v % 10);
+        v /= 10;
+    } while (v && i > 0);
+    serial_puts(&buf[i]);
+}
+
 /* dump first few words from a stack pointer for debugging */
 void dump_stack(uint32_t *sp, int count)
 {
@@ -85,6 +70,221 @@ void dump_stack(uint32_t *sp, int count)
     serial_puts("\r\n");
 }
 
+/*
+ * Frame que deja syscall_entry en el stack de kernel de un thread de
+ * Ring 3 (de la dirección más baja a la más alta). La CPU cambia al
+ * stack de TSS.esp0 == kernel_stack_top, así que el frame termina
+ * justo en el tope.
+ */
+typedef struct {
+    uint32_t gs, fs, es, ds;
+    uint32_t ebx, ecx, edx, esi, edi, ebp;
+    uint32_t eip, cs, eflags, user_esp, user_ss;
+} syscall_frame_t;
+
+static int do_fork(void)
+{
+    thread_t* cur = proc_current_thread();
+    syscall_frame_t* f;
+    cpu_context_t regs;
+    process_t* child;
+
+    if (!cur || cur->privilege != PRIVILEGE_USER) return -1;
+    f = (syscall_frame_t*)(cur->kernel_stack_top - sizeof(syscall_frame_t));
+
+    regs.gs = f->gs;   regs.fs = f->fs;   regs.es = f->es;   regs.ds = f->ds;
+    regs.edi = f->edi; regs.esi = f->esi; regs.ebp = f->ebp; regs.esp_dummy = 0;
+    regs.ebx = f->ebx; regs.edx = f->edx; regs.ecx = f->ecx; regs.eax = 0;
+    regs.int_no = 0x30; regs.err_code = 0;
+    regs.eip = f->eip; regs.cs = f->cs; regs.eflags = f->eflags;
+    regs.user_esp = f->user_esp; regs.user_ss = f->user_ss;
+
+    /* El padre recibe el pid en EAX a la vuelta de syscall_entry; el
+     * hijo arranca con regs.eax = 0 desde su contexto inicial */
+    child = proc_fork(&regs);
+    return child ? (int)child->pid : -1;
+}
+
+/* SYS_MMAP: solo memoria anónima; la VMA se llena en los #PF */
+static uint32_t do_mmap(uint32_t addr, uint32_t len, uint32_t prot,
+                        uint32_t flags)
+{
+    process_t* proc = proc_current_process();
+    uint32_t va;
+
+    if (!proc || proc->privilege != PRIVILEGE_USER) return (uint32_t)-1;
+    if (!(flags & MAP_ANONYMOUS) || !len) return (uint32_t)-1;
+    va = vma_mmap(&proc->vm, proc->page_dir, addr, len,
+                  (prot & PROT_WRITE) ? PTE_WRITABLE : 0,
+                  (flags & MAP_FIXED) != 0);
+    return va ? va : (uint32_t)-1;
+}
+
+#if SYS_MAX_PROCESSES != MAX_PROCESSES
+#error "SYS_MAX_PROCESSES (libsys.h) debe ser igual a MAX_PROCESSES"
+#endif
+
+/* SYS_PROC_INFO: primer proceso vivo desde la posición index de la
+ * tabla. Retorna la posición siguiente (0 = no quedan) */
+static uint32_t do_proc_info(uint32_t index, void* out)
+{
+    process_t** table = proc_get_process_table();
+    SYS_PROCESS_INFO pi;
+    process_t* p = NULL;
+
+    for (; index < MAX_PROCESSES; index++) {
+        if (table[index] && table[index]->active) {
+            p = table[index];
+            break;
+        }
+    }
+    if (!p) return 0;
+
+    memset(&pi, 0, sizeof(pi));
+    pi.pid       = p->pid;
+    pi.privilege = p->privilege;
+    for (int i = 0; i < 31 && p->name[i]; i++) pi.name[i] = p->name[i];
+
+    /* Los de kernel usan el directorio del kernel y no tienen VMAs */
+    if (p->page_dir && p->page_dir != vmm_get_kernel_directory())
+        pi.page_tables = vmm_count_tables(p->page_dir);
+    pi.rss          = p->image_pages + p->vm.resident;
+    pi.peak_rss     = p->image_pages + p->vm.peak_resident;
+    pi.committed    = p->image_pages + vma_committed_pages(&p->vm);
+    pi.touched      = p->vm.resident + p->vm.swapped;
+    pi.swapped      = p->vm.swapped;
+    pi.minor_faults = p->minor_faults;
+    pi.major_faults = p->major_faults;
+
+    if (copy_to_user(out, &pi, sizeof(pi)) != 0) return (uint32_t)-EFAULT;
+    return index + 1;
+}
+
+/* Quitar las primeras pages páginas del shadow mapeadas en el proceso */
+static void shadow_unmap(process_t* proc, uint32_t pages)
+{
+    for (uint32_t i = 0; i < pages; i++) {
+        pte_t pte = vmm_get_pte(proc->page_dir,
+                                USER_SHADOW_BASE + i * PAGE_SIZE);
+        if (pte & PTE_PRESENT) page_put(PTE_ADDR(pte));
+    }
+    vmm_unmap_range(proc->page_dir, USER_SHADOW_BASE, pages * PAGE_SIZE);
+}
+
+/* Mapear el shadow de solo lectura en USER_SHADOW_BASE. Cada página lleva
+ * su referencia: el frame sobrevive a un vfree del shadow mientras siga
+ * mapeado en el proceso. Retorna las páginas mapeadas o 0 (sin shadow, o
+ * sin memoria para una page table: entonces no queda nada mapeado) */
+static uint32_t shadow_map(process_t* proc, PULONG pitch)
+{
+    ULONG size;
+    uint32_t k = (uint32_t)VgaGetShadowBuffer(&size, pitch);
+    uint32_t pages = PAGE_ALIGN(size) / PAGE_SIZE;
+
+    if (!k) return 0;
+    for (uint32_t i = 0; i < pages; i++) {
+        phys_addr_t frame = PTE_ADDR(vmm_kernel_pte(k + i * PAGE_SIZE));
+        if (vmm_map_range(proc->page_dir, USER_SHADOW_BASE + i * PAGE_SIZE,
+                          frame, PAGE_SIZE, PTE_PRESENT | PTE_USER) != 0) {
+            shadow_unmap(proc, i);
+            return 0;
+        }
+        if (!page_get(frame)) {
+            vmm_unmap_range(proc->page_dir, USER_SHADOW_BASE + i * PAGE_SIZE,
+                            PAGE_SIZE);
+            shadow_unmap(proc, i);
+            return 0;
+        }
+    }
+    return pages;
+}
+
+/*
+ * SYS_SURFACE_MAP: una superficie de 8bpp por proceso, memoria anónima
+ * de la VMA normal (demanda, fork, swap). El programa pinta en ella sin
+ * syscalls y publica el rectángulo sucio con SYS_SURFACE_DAMAGE. Con
+ * SURFACE_MAP_SHADOW se mapean además, de solo lectura, las páginas del
+ * shadow de vídeo en USER_SHADOW_BASE para leer la pantalla sin copias.
+ * Si algo falla no queda nada mapeado y la llamada se puede repetir.
+ */
+static uint32_t do_surface_map(void* udesc, uint32_t flags)
+{
+    process_t* proc = proc_current_process();
+    SYS_SURFACE desc;
+    uint32_t pitch, va, shadow_pages = 0;
+
+    if (!proc || proc->privilege != PRIVILEGE_USER || proc->surface_base)
+        return (uint32_t)-1;
+    if (copy_from_user(&desc, udesc, sizeof(desc)) != 0)
+        return (uint32_t)-EFAULT;
+    if (!desc.width || !desc.height || desc.width > 640 || desc.height > 480)
+        return (uint32_t)-1;
+
+    pitch = (desc.width + 3) & ~3u;
+    va = vma_mmap(&proc->vm, proc->page_dir, 0, pitch * desc.height,
+                  PTE_WRITABLE, 0);
+    if (!va) return (uint32_t)-1;
+
+    desc.pixels       = (uint8_t*)va;
+    desc.pitch        = pitch;
+    desc.shadow       = NULL;
+    desc.shadow_pitch = 0;
+
+    if ((flags & SURFACE_MAP_SHADOW) && VgaGetShadowBuffer(NULL, NULL)) {
+        ULONG spitch;
+        shadow_pages = shadow_map(proc, &spitch);
+        if (!shadow_pages) {
+            vma_remove(&proc->vm, proc->page_dir, va, pitch * desc.height);
+            return (uint32_t)-1;
+        }
+        desc.shadow       = (const uint8_t*)USER_SHADOW_BASE;
+        desc.shadow_pitch = spitch;
+    }
+
+    /* El descriptor primero: el estado del proceso solo cambia si el
+     * programa llegó a recibirlo */
+    if (copy_to_user(udesc, &desc, sizeof(desc)) != 0) {
+        shadow_unmap(proc, shadow_pages);
+        vma_remove(&proc->vm, proc->page_dir, va, pitch * desc.height);
+        return (uint32_t)-EFAULT;
+    }
+
+    proc->surface_base  = va;
+    proc->surface_pitch = pitch;
+    proc->surface_w     = desc.width;
+    proc->surface_h     = desc.height;
+    proc->surface_x     = desc.x;
+    proc->surface_y     = desc.y;
+    proc->shadow_pages  = shadow_pages;
+    return 0;
+}
+
+/* SYS_SURFACE_DAMAGE: volcar un rectángulo de la superficie a la
+ * pantalla, una línea por vez a través de un buffer del kernel */
+static uint32_t do_surface_damage(int x, int y, int w, int h)
+{
+    process_t* proc = proc_current_process();
+    uint8_t line[640];
+
+    if (!proc || !proc->surface_base) return (uint32_t)-1;
+
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > (int)proc->surface_w) w = (int)proc->surface_w - x;
+    if (y + h > (int)proc->surface_h) h = (int)proc->surface_h - y;
+    if (w <= 0 || h <= 0) return 0;
+
+    for (int row = 0; row < h; row++) {
+        const uint8_t* src = (const uint8_t*)proc->surface_base
+                           + (uint32_t)(y + row) * proc->surface_pitch + x;
+        if (copy_from_user(line, src, (uint32_t)w) != 0)
+            return (uint32_t)-EFAULT;
+        VgaBlitRect(proc->surface_x + x, proc->surface_y + y + row,
+                    w, 1, line, (ULONG)w);
+    }
+    return 0;
+}
+
 /* Stub de syscall: preserva registros y invoca dispatcher. */
 __attribute__((naked))
 void syscall_entry(void)
@@ -140,13 +340,8 @@ void syscall_entry(void)
         "pop %edi\n"
         "pop %ebp\n"
 
-        /* debug: dump a few words from the current stack frame before
-           we adjust for the interrupt return. This helps verify the
-           return address that iret will pop. */
-        "push $5\n"        /* count */
-        "push %esp\n"      /* pointer to stack */
-        "call dump_stack\n"
-        "add $8, %esp\n"    /* skip SS+ESP from interrupt frame */
+        /* EAX lleva el valor de retorno de syscall_dispatch hasta Ring 3:
+         * entre el call y el iret no puede llamarse nada más en C */
         "sti\n"
         "iret\n"
     );
@@ -205,19 +400,8 @@ uint32_t syscall_dispatch(uint32_t num, uint32_t a, uint32_t b,
     case SYS_DRAW_STRING: {
         /* a=x, b=y, c=pointer, d=fg, e=bg */
         char buf[128];
-        int i;
-        if (!is_user_ptr((const void*)c)) {
-            ret = (uint32_t)-1;
-            break;
-        }
-        /* copiar caracter a caracter hasta null o saturacion */
-        for (i = 0; i < (int)sizeof(buf)-1; i++) {
-            const char *uc = (const char*)(c + i);
-            if (!is_user_ptr(uc)) { ret = (uint32_t)-1; break; }
-            buf[i] = *uc;  /* acceso directo - pagina debe ser PTE_USER */
-            if (buf[i] == '\0') break;
-        }
-        if (ret != 0) break;
+        int n = strncpy_from_user(buf, (const char*)c, sizeof(buf));
+        if (n < 0) { ret = (uint32_t)n; break; }
         buf[sizeof(buf)-1] = '\0';
         VgaDrawString((INT)a, (INT)b, buf, (UCHAR)d, (UCHAR)e);
         ret = 0;
@@ -232,7 +416,6 @@ uint32_t syscall_dispatch(uint32_t num, uint32_t a, uint32_t b,
         break;
     case SYS_GET_MOUSE_STATE: {
         /* b = pointer to SYS_MOUSE */
-        if (!is_user_ptr((const void*)b)) { ret = (uint32_t)-1; break; }
         SYS_MOUSE ms;
         {
             extern MOUSE_STATE* MouseGetState(void);
@@ -245,51 +428,35 @@ uint32_t syscall_dispatch(uint32_t num, uint32_t a, uint32_t b,
                 ms.x = ms.y = ms.buttons = 0;
             }
         }
-        if (copy_from_user((void*)b, &ms, sizeof(ms)) != 0)
-            ret = (uint32_t)-1;
-        else
-            ret = 0;
+        ret = (uint32_t)copy_to_user((void*)b, &ms, sizeof(ms));
         break;
     }
     case SYS_DEBUG: {
         /* b = pointer a cadena usuario */
-        if (!is_user_ptr((const void*)b)) {
+        char buf[128];
+        int n = strncpy_from_user(buf, (const char*)b, sizeof(buf));
+        if (n < 0) {
             serial_puts("[debug] user ptr invalid\r\n");
-            ret = (uint32_t)-1;
+            ret = (uint32_t)n;
             break;
         }
-        /* simple copia y enviar a serial */
-        char buf[128];
-        int i;
-        for (i = 0; i < (int)sizeof(buf)-1; i++) {
-            char ch;
-            if (copy_from_user(&ch, (const void*)(b + i), 1) != 0) {
-                serial_puts("[debug] copy_from_user failed\r\n");
-                ret = (uint32_t)-1;
-                break;
-            }
-            buf[i] = ch;
-            if (ch == '\0') break;
-        }
-        if (i == (int)sizeof(buf)-1) {
-            /* unterminated? ensure null */
-            buf[sizeof(buf)-1] = '\0';
-        }
+        /* sin terminar dentro del buffer: cortar */
+        buf[sizeof(buf)-1] = '\0';
         serial_puts(buf);
         ret = 0;
         break;
     }
     case SYS_GET_MOUSE_EVENT: {
         /* b = pointer to SYS_MOUSE (user buffer) */
-        if (!is_user_ptr((const void*)b)) { ret = (uint32_t)-1; break; }
         GUI_MOUSE_EVENT ev;
+        if (!user_access_ok((const void*)b, sizeof(SYS_MOUSE), 1)) {
+            ret = (uint32_t)-EFAULT;
+            break;
+        }
         int status = GuiGetMouseEvent(&ev);
         if (status == 0) {
             SYS_MOUSE ms = { ev.x, ev.y, ev.buttons };
-            if (copy_from_user((void*)b, &ms, sizeof(ms)) != 0)
-                ret = (uint32_t)-1;
-            else
-                ret = 0;
+            ret = (uint32_t)copy_to_user((void*)b, &ms, sizeof(ms));
         } else {
             /* cola vacía */
             ret = (uint32_t)-1;
@@ -306,14 +473,9 @@ uint32_t syscall_dispatch(uint32_t num, uint32_t a, uint32_t b,
         break;
     case SYS_GUI_DRAW_WINDOW: {
         /* argumentos: a=x, b=y, c=w, d=h, e=pointer title */
-        if (!is_user_ptr((const void*)e)) { ret = (uint32_t)-1; break; }
         char title[128];
-        for (int i = 0; i < (int)sizeof(title)-1; i++) {
-            char ch;
-            if (copy_from_user(&ch, (const void*)(e + i), 1) != 0) { ret = (uint32_t)-1; break; }
-            title[i] = ch;
-            if (ch == '\0') break;
-        }
+        int n = strncpy_from_user(title, (const char*)e, sizeof(title));
+        if (n < 0) { ret = (uint32_t)n; break; }
         title[127] = '\0';
         GUI_WINDOW win = { (INT)a, (INT)b, (INT)c, (INT)d, title, 1 };
         GuiDrawWindow(&win);
@@ -322,16 +484,15 @@ uint32_t syscall_dispatch(uint32_t num, uint32_t a, uint32_t b,
     }
     case SYS_GUI_DRAW_WINDOW_TEXT: {
         /* a=pointer win (user), b=rx, c=ry, d=pointer txt, e=fg */
-        if (!is_user_ptr((const void*)a) || !is_user_ptr((const void*)d)) { ret = (uint32_t)-1; break; }
         GUI_WINDOW localWin;
-        if (copy_from_user(&localWin, (const void*)a, sizeof(localWin)) != 0) { ret = (uint32_t)-1; break; }
         char txt[128];
-        for (int i = 0; i < (int)sizeof(txt)-1; i++) {
-            char ch;
-            if (copy_from_user(&ch, (const void*)(d + i), 1) != 0) { ret = (uint32_t)-1; break; }
-            txt[i] = ch;
-            if (ch == '\0') break;
+        int n;
+        if (copy_from_user(&localWin, (const void*)a, sizeof(localWin)) != 0) {
+            ret = (uint32_t)-EFAULT;
+            break;
         }
+        n = strncpy_from_user(txt, (const char*)d, sizeof(txt));
+        if (n < 0) { ret = (uint32_t)n; break; }
         txt[127] = '\0';
         GuiDrawWindowText(&localWin, (INT)b, (INT)c, txt, (UCHAR)e);
         ret = 0;
@@ -346,6 +507,36 @@ uint32_t syscall_dispatch(uint32_t num, uint32_t a, uint32_t b,
         ret = 0;
         break;
     }
+    case SYS_FORK:
+        ret = (uint32_t)do_fork();
+        break;
+    case SYS_MMAP:
+        ret = do_mmap(a, b, c, d);
+        break;
+    case SYS_MUNMAP: {
+        process_t* proc = proc_current_process();
+        if (!proc || proc->privilege != PRIVILEGE_USER || (a & 0xFFF)) {
+            ret = (uint32_t)-1;
+            break;
+        }
+        ret = vma_remove(&proc->vm, proc->page_dir, a, b) == 0 ? 0 : (uint32_t)-1;
+        break;
+    }
+    case SYS_BRK: {
+        process_t* proc = proc_current_process();
+        if (!proc || proc->privilege != PRIVILEGE_USER) { ret = (uint32_t)-1; break; }
+        ret = vma_brk(&proc->vm, proc->page_dir, a);
+        break;
+    }
+    case SYS_PROC_INFO:
+        ret = do_proc_info(a, (void*)b);
+        break;
+    case SYS_SURFACE_MAP:
+        ret = do_surface_map((void*)a, b);
+        break;
+    case SYS_SURFACE_DAMAGE:
+        ret = do_surface_damage((int)a, (int)b, (int)c, (int)d);
+        break;
     default:
         /* syscall desconocido */
         ret = (uint32_t)-1;
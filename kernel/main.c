@@ -3,13 +3,19 @@
 #include "hal.h"
 #include "multiboot.h"
 #include "mm/pmm.h"
+#include "mm/memblock.h"
 #include "mm/vmm.h"
+#include "mm/vmalloc.h"
+#include "mm/pool.h"
+#include "mm/swap.h"
 #include "proc/process.h"
 #include "proc/scheduler.h"
 #include "interrupt/tss.h"
 #include "interrupt/syscall.h"
 #include "boot_splash.h"
+#include "bench/bench.h"
 #include <kstdlib.h>
+#include <init.h>
 
 /* entrada de mouse PS/2 (antes en vga_mouse.h) */
 #include "../drivers/input/ps2mouse.h"
@@ -56,6 +62,19 @@ void kernel_halt(void)
     while(1);
 }
 
+/* Devolver al PMM las páginas de las secciones .init (boot splash,
+ * tablas de modo VGA, ...). Nada __init corre después de esto. */
+static void free_initmem(void)
+{
+    extern void serial_puts(const char*);
+    extern void serial_print_dec(uint32_t v);
+    uint32_t frames = pmm_release_range((uint32_t)__init_start,
+                                        (uint32_t)__init_end);
+    serial_puts("[mm] init liberado: ");
+    serial_print_dec(frames * (PAGE_SIZE / 1024));
+    serial_puts(" KB\r\n");
+}
+
 
 
 void kernel_main(uint32_t magic, multiboot_info_t* mbi)
@@ -71,9 +90,8 @@ void kernel_main(uint32_t magic, multiboot_info_t* mbi)
      */
     /*
      * HEAP PRIMERO — antes de cualquier llamada a malloc().
-     * heap_init() calcula el inicio del heap usando el simbolo _kernel_end
-     * del linker script, garantizando que el heap nunca solape con el
-     * kernel image (antes HEAP_START == 0x100000 == inicio del kernel).
+     * heap_init() deja vacías las clases de kmalloc; los slabs se mapean
+     * en el rango del heap, así que malloc() retorna NULL hasta vmm_init().
      */
     heap_init();
 
@@ -83,6 +101,9 @@ void kernel_main(uint32_t magic, multiboot_info_t* mbi)
     serial_init();
     serial_puts("[boot] serial init\r\n");
 
+    /* memcpy/memset según CPUID, antes de la animación y del PMM */
+    memory_init();
+
     gdt_init();
     idt_init();
 
@@ -162,14 +183,12 @@ void kernel_main(uint32_t magic, multiboot_info_t* mbi)
      * Deben iniciarse ANTES del driver VGA para que el PMM no
      * asigne frames que ya usa el kernel image o el framebuffer. */
 
-    /* PMM: inicializar con la RAM reportada por multiboot */
-    {
-        uint32_t mem_upper_kb = 32768;   /* 32MB por defecto */
-        if (mbi && (mbi->flags & 0x01)) {
-            mem_upper_kb = mbi->mem_upper;
-        }
-        pmm_init(mem_upper_kb);
-    }
+    /* memblock: RAM y rangos ocupados del mapa de memoria (E820) de
+     * multiboot. Es el allocator hasta que el PMM arma su bitmap. */
+    memblock_init(mbi);
+
+    /* PMM: bitmap a partir de memblock (lo ubica con memblock_alloc) */
+    pmm_init();
     screen_set_color(VGA_COLOR_LIGHT_GREEN, VGA_COLOR_BLACK);
     screen_writeln("[OK] PMM inicializado");
 
@@ -203,6 +222,17 @@ void kernel_main(uint32_t magic, multiboot_info_t* mbi)
     screen_set_color(VGA_COLOR_LIGHT_GREEN, VGA_COLOR_BLACK);
     screen_writeln("[OK] Gestor de procesos inicializado");
 
+    /* Swap: disco ATA con firma de mkswap (opcional, ./run.sh -w) */
+    if (swap_init()) {
+        screen_set_color(VGA_COLOR_LIGHT_GREEN, VGA_COLOR_BLACK);
+        screen_writeln("[OK] Swap activo");
+    }
+
+#ifdef KERNEL_BENCH
+    /* Micro-benchmarks (make BENCH=1): resultados por serial */
+    bench_run_all();
+#endif
+
     if (!NT_SUCCESS(HalInitializeDisplay())) {
         kernel_panic("Failed to initialize display");
     }
@@ -248,6 +278,21 @@ void kernel_main(uint32_t magic, multiboot_info_t* mbi)
     }
     /* NOTA: screen_writeln() ya no funciona aqui (modo grafico activo) */
 
+    /* Lo que la GUI ocupa en vmalloc (el shadow framebuffer); sin GUI son
+     * 0 KB, antes eran 300 KB fijos en el .bss del kernel */
+    {
+        extern void serial_print_dec(uint32_t v);
+        vmalloc_stats_t vs;
+        vmalloc_get_stats(&vs);
+        serial_puts("[mm] vmalloc: ");
+        serial_print_dec(vs.pages * (PAGE_SIZE / 1024));
+        serial_puts(" KB en ");
+        serial_print_dec(vs.areas);
+        serial_puts(" areas (0 KB sin GUI)\r\n");
+    }
+    /* Quién tiene qué en el pool tras arrancar los drivers */
+    pool_dump_serial();
+
     /* dump bytes from both potential buffers so we know qué memoria
        está interpretando el emulador. */
     serial_puts("[VGA] buffer @A0000:");
@@ -290,6 +335,7 @@ void kernel_main(uint32_t magic, multiboot_info_t* mbi)
      * para el thread del gui_server. El idle lo anade scheduler_init(). */
     serial_puts("[boot] scheduler init\r\n");
     scheduler_init();
+    free_initmem();
 
     /* NOTA: No llamar screen_writeln aqui - VGA ya esta en modo grafico */
 
@@ -307,9 +353,12 @@ void kernel_main(uint32_t magic, multiboot_info_t* mbi)
      * NO usar 'cli' aqui — el scheduler necesita las interrupciones.
      * 'sti' garantiza que IF=1 antes del primer hlt.
      * 'hlt' suspende hasta el proximo tick — 0% CPU entre ticks.
+     * Antes de cada hlt se rellena un poco el pool de frames pre-zeroed
+     * del PMM (igual que kernel_idle()).
      */
     __asm__ volatile("sti");
     while (1) {
+        pmm_zero_pool_refill(PMM_ZERO_REFILL);
         __asm__ volatile("hlt");
     }
 }
\ No newline at end of file
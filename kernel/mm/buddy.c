@@ -0,0 +1,172 @@
+/*
+ * buddy.c — Buddy allocator binario para bloques físicamente contiguos
+ *
+ * Gestiona una zona de memoria física alineada a 4MB que el PMM reserva
+ * en su bitmap durante pmm_init(). Los bloques son de 2^order frames
+ * (order 0 = 4KB ... PMM_MAX_ORDER = 4MB).
+ *
+ * Las listas libres NO se guardan dentro de los frames: usamos arrays de
+ * metadatos indexados por frame de la zona (next/prev/order). Así el
+ * allocator nunca toca la memoria que administra y sirve aunque la zona
+ * no esté mapeada en el espacio virtual actual.
+ *
+ * Liberar un bloque lo fusiona con su buddy (idx ^ 2^order) mientras el
+ * buddy esté libre y tenga el mismo orden.
+ */
+#include "buddy.h"
+#include "pmm.h"
+#include "page.h"
+#include <types.h>
+
+/* ── Configuración ────────────────────────────────────────────────────── */
+#define ZONE_MAX_FRAMES   (PMM_BUDDY_ZONE_SIZE / PAGE_SIZE)
+#define NIL               0xFFFF          /* fin de lista */
+#define ORDER_NOT_FREE    0xFF            /* el frame no encabeza un bloque libre */
+
+/* ── Estado interno ───────────────────────────────────────────────────── */
+static uint32_t buddy_base   = 0;
+static uint32_t buddy_frames = 0;
+static uint32_t buddy_free   = 0;
+
+/* Metadatos por frame de la zona (solo válidos en la cabeza de un bloque) */
+static uint16_t buddy_next[ZONE_MAX_FRAMES];
+static uint16_t buddy_prev[ZONE_MAX_FRAMES];
+static uint8_t  buddy_order[ZONE_MAX_FRAMES];
+
+/* Listas libres y estadísticas por orden */
+static uint16_t          free_head[PMM_MAX_ORDER + 1];
+static pmm_buddy_stats_t buddy_stats;
+
+/* ── Helpers de lista ─────────────────────────────────────────────────── */
+
+static void list_push(uint32_t idx, uint32_t order)
+{
+    buddy_order[idx] = (uint8_t)order;
+    buddy_prev[idx]  = NIL;
+    buddy_next[idx]  = free_head[order];
+    if (free_head[order] != NIL)
+        buddy_prev[free_head[order]] = (uint16_t)idx;
+    free_head[order] = (uint16_t)idx;
+    buddy_stats.free_blocks[order]++;
+}
+
+static void list_remove(uint32_t idx, uint32_t order)
+{
+    uint16_t n = buddy_next[idx], p = buddy_prev[idx];
+    if (p != NIL) buddy_next[p] = n;
+    else          free_head[order] = n;
+    if (n != NIL) buddy_prev[n] = p;
+    buddy_order[idx] = ORDER_NOT_FREE;
+    buddy_stats.free_blocks[order]--;
+}
+
+/* ── Inicialización ───────────────────────────────────────────────────── */
+
+void buddy_init(uint32_t base, uint32_t frames)
+{
+    uint32_t i;
+
+    if (frames > ZONE_MAX_FRAMES) frames = ZONE_MAX_FRAMES;
+    buddy_base   = base;
+    buddy_frames = frames;
+    buddy_free   = 0;
+
+    for (i = 0; i <= PMM_MAX_ORDER; i++) {
+        free_head[i] = NIL;
+        buddy_stats.free_blocks[i] = 0;
+        buddy_stats.allocs[i]      = 0;
+        buddy_stats.frees[i]       = 0;
+        buddy_stats.failures[i]    = 0;
+    }
+    buddy_stats.splits = buddy_stats.merges = 0;
+    for (i = 0; i < ZONE_MAX_FRAMES; i++)
+        buddy_order[i] = ORDER_NOT_FREE;
+
+    /* Insertar los bloques alineados más grandes que quepan */
+    i = 0;
+    while (i < frames) {
+        uint32_t order = PMM_MAX_ORDER;
+        while (order > 0 &&
+               ((i & ((1u << order) - 1)) || i + (1u << order) > frames))
+            order--;
+        list_push(i, order);
+        buddy_free += 1u << order;
+        i += 1u << order;
+    }
+}
+
+int buddy_owns(uint32_t addr)
+{
+    return buddy_frames &&
+           addr >= buddy_base &&
+           addr <  buddy_base + buddy_frames * PAGE_SIZE;
+}
+
+uint32_t buddy_free_frames(void)  { return buddy_free; }
+uint32_t buddy_total_frames(void) { return buddy_frames; }
+
+/* ── API pública (declarada en pmm.h) ─────────────────────────────────── */
+
+uint32_t pmm_alloc_pages(uint32_t order)
+{
+    uint32_t o, idx;
+
+    if (order > PMM_MAX_ORDER) return 0;
+
+    /* Menor orden >= pedido con bloques libres */
+    for (o = order; o <= PMM_MAX_ORDER && free_head[o] == NIL; o++)
+        ;
+    if (o > PMM_MAX_ORDER) {
+        buddy_stats.failures[order]++;
+        return 0;
+    }
+
+    idx = free_head[o];
+    list_remove(idx, o);
+
+    /* Partir: la mitad superior vuelve a la lista del orden inferior */
+    while (o > order) {
+        o--;
+        list_push(idx + (1u << o), o);
+        buddy_stats.splits++;
+    }
+
+    buddy_free -= 1u << order;
+    buddy_stats.allocs[order]++;
+    for (o = 0; o < (1u << order); o++)
+        page_on_alloc(buddy_base + (idx + o) * PAGE_SIZE);
+    return buddy_base + idx * PAGE_SIZE;
+}
+
+void pmm_free_pages(uint32_t addr, uint32_t order)
+{
+    uint32_t idx;
+
+    if (order > PMM_MAX_ORDER || !buddy_owns(addr)) return;
+    idx = (addr - buddy_base) / PAGE_SIZE;
+    if (idx & ((1u << order) - 1)) return;          /* mal alineado */
+    if (buddy_order[idx] != ORDER_NOT_FREE) return; /* doble free */
+
+    buddy_free += 1u << order;
+    buddy_stats.frees[order]++;
+    for (uint32_t i = 0; i < (1u << order); i++)
+        page_on_free(addr + i * PAGE_SIZE);
+
+    /* Fusionar con el buddy mientras esté libre y sea del mismo orden */
+    while (order < PMM_MAX_ORDER) {
+        uint32_t b = idx ^ (1u << order);
+        if (b >= buddy_frames || buddy_order[b] != order)
+            break;
+        list_remove(b, order);
+        if (b < idx) idx = b;
+        order++;
+        buddy_stats.merges++;
+    }
+    list_push(idx, order);
+}
+
+void pmm_get_buddy_stats(pmm_buddy_stats_t* out)
+{
+    if (!out) return;
+    *out = buddy_stats;
+}
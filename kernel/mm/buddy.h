@@ -0,0 +1,23 @@
+/*
+ * buddy.h — Buddy allocator binario (uso interno del PMM)
+ *
+ * La API pública es pmm_alloc_pages()/pmm_free_pages() en pmm.h.
+ * Este header solo expone lo que pmm.c necesita para montar la zona.
+ */
+#ifndef _BUDDY_H
+#define _BUDDY_H
+
+#include <types.h>
+
+/* Inicializar la zona buddy sobre [base, base + frames*PAGE_SIZE).
+ * base debe estar alineada a (PAGE_SIZE << PMM_MAX_ORDER). */
+void buddy_init(uint32_t base, uint32_t frames);
+
+/* ¿La dirección física pertenece a la zona buddy? */
+int buddy_owns(uint32_t addr);
+
+/* Frames libres / totales dentro de la zona */
+uint32_t buddy_free_frames(void);
+uint32_t buddy_total_frames(void);
+
+#endif /* _BUDDY_H */
@@ -0,0 +1,153 @@
+/*
+ * fault.c — Resolución de page faults (demand paging)
+ *
+ * El stub de #PF en idt.c arma un cpu_context_t completo y llama a
+ * page_fault_handler(), que pasa por aquí antes de dar el fallo por
+ * fatal. Se resuelven tres casos y la instrucción se reintenta:
+ *   - acceso a una página NO presente dentro de una VMA del proceso
+ *     actual (stack, heap, mmap; ver vma.h): se mapea un frame a cero
+ *     (sobre 4GB si hay memoria alta con PAE), o
+ *     se lee del disco si el PTE es una entrada de swap (ver swap.h)
+ *   - escritura en una página PTE_COW (fork): se copia el frame si sigue
+ *     compartido o se devuelve el permiso de escritura si ya no
+ *   - acceso del kernel a una tabla suya (vmalloc) que el directorio
+ *     actual todavía no tiene: se copia el PDE del directorio del kernel
+ *
+ * Corre con interrupciones desactivadas (interrupt gate), así que no
+ * hace falta proteger el PMM ni las tablas del proceso.
+ */
+#include "fault.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "page.h"
+#include "swap.h"
+#include "../proc/process.h"
+#include <types.h>
+
+static vmm_fault_stats_t g_fault_stats;
+
+/* Copiar un frame completo (por la ventana kmap: puede estar fuera del
+ * identity map) */
+static int copy_frame(phys_addr_t dst, phys_addr_t src)
+{
+    void* d = vmm_kmap(dst);
+    void* s = vmm_kmap(src);
+    void *dp = d, *sp = s;
+    uint32_t n = PAGE_SIZE / 4;
+
+    if (!d || !s) {
+        if (d) vmm_kunmap(d);
+        if (s) vmm_kunmap(s);
+        return 0;
+    }
+    __asm__ volatile("rep movsl"
+                     : "+D"(dp), "+S"(sp), "+c"(n) :: "memory");
+    vmm_kunmap(d);
+    vmm_kunmap(s);
+    return 1;
+}
+
+int vmm_cow_break(page_directory_t* dir, uint32_t virt, uint32_t owner)
+{
+    pte_t pte = vmm_get_pte(dir, virt);
+    phys_addr_t old = PTE_ADDR(pte), frame;
+    uint32_t flags = (pte & PTE_USER) | PTE_PRESENT | PTE_WRITABLE;
+    page_t* pg;
+
+    virt &= ~(PAGE_SIZE - 1);
+    if (!(pte & PTE_PRESENT) || !(pte & PTE_COW)) return 0;
+
+    /* El otro lado ya copió (o terminó): la página vuelve a ser nuestra */
+    pg = page_of(old);
+    if (pg && pg->refcount == 1) {
+        vmm_map_page(dir, virt, old, flags);
+        g_fault_stats.cow_reused++;
+        return 1;
+    }
+
+    frame = pmm_alloc_user_frame();
+    if (!frame) return 0;
+    if (!copy_frame(frame, old)) {
+        pmm_free_frame(frame);
+        return 0;
+    }
+    page_set(frame, PG_USER, owner);
+    vmm_map_page(dir, virt, frame, flags);
+    page_put(old);
+    g_fault_stats.cow_copies++;
+    return 1;
+}
+
+int vmm_handle_page_fault(uint32_t addr, uint32_t err)
+{
+    process_t* proc;
+    vma_t* r;
+    phys_addr_t frame;
+    pte_t pte;
+
+    /* Tabla del kernel (vmalloc, heap) creada después que este directorio.
+     * Va antes de proc_current_process(): thread_t y process_t viven en
+     * el heap y tocarlos aquí podría volver a fallar. */
+    if (addr >= USER_SPACE_END && !(err & (PF_ERR_PRESENT | PF_ERR_USER)) &&
+        vmm_sync_kernel_pde(addr)) {
+        g_fault_stats.kernel_syncs++;
+        return 1;
+    }
+
+    proc = proc_current_process();
+    if (!proc) goto fatal;
+
+    /* Escritura sobre una página presente: solo es legal si es COW */
+    if (err & PF_ERR_PRESENT) {
+        if (!(err & PF_ERR_WRITE) || addr >= USER_SPACE_END) goto fatal;
+        if (!vmm_cow_break(proc->page_dir, addr, proc->pid)) goto fatal;
+        proc->minor_faults++;
+        return 1;
+    }
+
+    r = vma_find(&proc->vm, addr);
+    if (!r) goto fatal;
+    if ((err & PF_ERR_WRITE) && !(r->pte_flags & PTE_WRITABLE)) goto fatal;
+
+    /* Página desalojada: traerla del swap (fallo mayor) */
+    pte = vmm_get_pte(proc->page_dir, addr);
+    if (pte & PTE_SWAP) {
+        if (!swap_in(proc->page_dir, addr, pte, r->pte_flags, proc->pid))
+            goto fatal;
+        vma_charge(&proc->vm, 1);
+        if (proc->vm.swapped) proc->vm.swapped--;
+        proc->major_faults++;
+        g_fault_stats.major++;
+        return 1;
+    }
+
+    frame = pmm_alloc_zeroed_user_frame();
+    if (!frame) goto fatal;
+    page_set(frame, PG_USER, proc->pid);
+
+    vmm_map_page(proc->page_dir, addr & ~(PAGE_SIZE - 1), frame, r->pte_flags);
+    if (!(vmm_get_pte(proc->page_dir, addr) & PTE_PRESENT)) {
+        /* sin memoria para la page table */
+        pmm_free_frame(frame);
+        goto fatal;
+    }
+
+    vma_charge(&proc->vm, 1);
+    proc->minor_faults++;
+    g_fault_stats.minor++;
+    return 1;
+
+fatal:
+    return 0;
+}
+
+void vmm_note_fatal_fault(void)
+{
+    g_fault_stats.unresolved++;
+}
+
+void vmm_get_fault_stats(vmm_fault_stats_t* out)
+{
+    if (!out) return;
+    *out = g_fault_stats;
+}
@@ -0,0 +1,48 @@
+/*
+ * fault.h — Resolución de page faults (demand paging)
+ */
+#ifndef _FAULT_H
+#define _FAULT_H
+
+#include <types.h>
+#include "vmm.h"
+
+/* Bits del error code que empuja la CPU en un #PF */
+#define PF_ERR_PRESENT  (1 << 0)   /* 0 = página no presente, 1 = protección */
+#define PF_ERR_WRITE    (1 << 1)   /* el acceso era una escritura */
+#define PF_ERR_USER     (1 << 2)   /* el acceso vino de Ring 3 */
+
+/* Contadores globales del manejador */
+typedef struct {
+    uint32_t minor;         /* resueltos mapeando un frame a cero */
+    uint32_t major;         /* resueltos leyendo la página del swap */
+    uint32_t cow_copies;    /* escrituras COW resueltas copiando el frame */
+    uint32_t cow_reused;    /* escrituras COW sobre un frame ya no compartido */
+    uint32_t kernel_syncs;  /* PDEs del kernel copiados al directorio actual */
+    uint32_t unresolved;    /* fallos sin fixup (el kernel se detiene) */
+} vmm_fault_stats_t;
+
+/*
+ * Intentar resolver un #PF en addr con el error code de la CPU.
+ * Retorna 1 si la página quedó mapeada (reintentar la instrucción) o 0
+ * si es un fallo real.
+ */
+int vmm_handle_page_fault(uint32_t addr, uint32_t err);
+
+/*
+ * Romper el copy-on-write de la página virt de dir: si el frame sigue
+ * compartido se copia a uno nuevo de owner; si ya es la única referencia
+ * se vuelve a hacer escribible. Retorna 1 o 0 si la página no es COW o
+ * no hay memoria. Lo usa el #PF y sirve para directorios no cargados.
+ */
+int vmm_cow_break(page_directory_t* dir, uint32_t virt, uint32_t owner);
+
+/*
+ * Contar un fallo que nadie resolvió: ni vmm_handle_page_fault ni el
+ * fixup de uaccess. Lo llama page_fault_handler justo antes de detenerse.
+ */
+void vmm_note_fatal_fault(void);
+
+void vmm_get_fault_stats(vmm_fault_stats_t* out);
+
+#endif /* _FAULT_H */
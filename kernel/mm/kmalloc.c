@@ -0,0 +1,424 @@
+/*
+ * kmalloc.c — Heap del kernel por slabs (ver kmalloc.h)
+ *
+ * Cada clase de tamaño mantiene dos listas de slabs: los que tienen
+ * objetos libres (parciales o vacíos) y los llenos. Un slab es un bloque
+ * de 2^order páginas del heap con una cabecera al principio y el resto
+ * partido en objetos; los objetos libres forman una lista enlazada por
+ * su primera palabra.
+ *
+ *   clase  16..512 B  → slab de 1 página
+ *   clase  1 KB       → slab de 2 páginas
+ *   clase  2 KB       → slab de 4 páginas
+ *
+ * Las páginas salen del rango virtual del heap: un bitmap marca las
+ * direcciones ocupadas y cada página se respalda con un frame suelto del
+ * PMM al reservarla (heap_grow) y lo devuelve al soltarla (heap_shrink).
+ *
+ * kfree() no recibe el tamaño: lo saca del page_t del frame que hay
+ * detrás del puntero (PG_SLAB con el slab en owner, o PG_LARGE con las
+ * páginas del bloque grande).
+ */
+#include "kmalloc.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "page.h"
+#include <hal.h>
+#include <types.h>
+
+#define SLAB_MAGIC      0x5AB1
+#define SLAB_HDR_SIZE   32          /* cabecera redondeada: objetos alineados a 16 */
+
+typedef struct kslab {
+    struct kslab* next;
+    struct kslab* prev;
+    void*         free;             /* objetos libres */
+    uint16_t      in_use;
+    uint16_t      total;
+    uint8_t       cls;
+    uint8_t       order;            /* 2^order páginas */
+    uint16_t      magic;
+} kslab_t;
+
+typedef struct {
+    kslab_t* avail;                 /* con objetos libres */
+    kslab_t* full;
+    uint32_t empty;                 /* slabs de avail sin ningún objeto en uso */
+} kcache_t;
+
+static kcache_t        g_caches[KMALLOC_CLASSES];
+static kmalloc_stats_t g_stats;
+
+/* Páginas del rango virtual en uso: 1 bit por página */
+static uint32_t g_heap_map[KHEAP_PAGES / 32];
+static uint32_t g_heap_hint;        /* primera palabra que puede tener libres */
+
+/* ── Helpers ──────────────────────────────────────────────────────────── */
+
+/* Clase para size bytes (size <= KMALLOC_MAX_SMALL) */
+static uint32_t size_class(size_t size)
+{
+    uint32_t cls = 0;
+    while ((1u << (cls + KMALLOC_MIN_SHIFT)) < size)
+        cls++;
+    return cls;
+}
+
+/* Frames por slab de la clase: el objeto de 1KB y 2KB en un solo frame
+ * desperdiciaría casi un objeto por la cabecera */
+static uint32_t slab_order(uint32_t cls)
+{
+    uint32_t size = 1u << (cls + KMALLOC_MIN_SHIFT);
+    return size <= 512 ? 0 : size == 1024 ? 1 : 2;
+}
+
+/* ── Rango virtual del heap ───────────────────────────────────────────── */
+
+static inline void tlb_flush(uint32_t virt)
+{
+    __asm__ volatile("invlpg (%0)" :: "r"(virt) : "memory");
+}
+
+static void heap_mark(uint32_t first, uint32_t n, int used)
+{
+    for (uint32_t i = first; i < first + n; i++) {
+        if (used) g_heap_map[i / 32] |=  (1u << (i % 32));
+        else      g_heap_map[i / 32] &= ~(1u << (i % 32));
+    }
+}
+
+/* Primer hueco de n páginas libres del rango (first fit), o -1 */
+static int32_t heap_find(uint32_t n)
+{
+    uint32_t run = 0, start = 0;
+
+    for (uint32_t i = g_heap_hint * 32; i < KHEAP_PAGES; i++) {
+        if (!(i % 32) && g_heap_map[i / 32] == 0xFFFFFFFF) {
+            run = 0;
+            i += 31;
+            continue;
+        }
+        if (g_heap_map[i / 32] & (1u << (i % 32))) {
+            run = 0;
+            continue;
+        }
+        if (!run) start = i;
+        if (++run == n) return (int32_t)start;
+    }
+    return -1;
+}
+
+/* Desmapear n páginas desde va y devolver sus frames al PMM */
+static void heap_shrink(uint32_t va, uint32_t n)
+{
+    uint32_t first = (va - KHEAP_START) / PAGE_SIZE;
+
+    for (uint32_t i = 0; i < n; i++) {
+        pte_t pte = vmm_kernel_pte(va + i * PAGE_SIZE);
+        if (pte & PTE_PRESENT) pmm_free_frame(pte & ~0xFFF);
+    }
+    /* El directorio actual comparte las tablas del heap aunque no sea el
+     * del kernel: invalidar aquí siempre */
+    vmm_unmap_range(vmm_get_kernel_directory(), va, n * PAGE_SIZE);
+    for (uint32_t i = 0; i < n; i++)
+        tlb_flush(va + i * PAGE_SIZE);
+
+    heap_mark(first, n, 0);
+    if (first / 32 < g_heap_hint) g_heap_hint = first / 32;
+    g_stats.heap_pages   -= n;
+    g_stats.heap_shrinks += n;
+}
+
+/* n páginas virtualmente contiguas del rango, cada una con un frame del
+ * PMM. Retorna la dirección o 0. */
+static uint32_t heap_grow(uint32_t n)
+{
+    page_directory_t* kdir = vmm_get_kernel_directory();
+    int32_t first;
+    uint32_t va, i;
+
+    if (!kdir) return 0;                    /* antes de vmm_init() */
+    first = heap_find(n);
+    if (first < 0) return 0;
+    va = KHEAP_START + (uint32_t)first * PAGE_SIZE;
+    heap_mark((uint32_t)first, n, 1);
+    g_stats.heap_pages += n;
+    g_stats.heap_grows += n;
+
+    for (i = 0; i < n; i++) {
+        uint32_t frame = pmm_alloc_frame();
+        if (!frame) break;
+        if (vmm_map_frames(kdir, va + i * PAGE_SIZE, &frame, 1,
+                           PTE_PRESENT | PTE_WRITABLE) != 0) {
+            /* sin memoria para la page table */
+            pmm_free_frame(frame);
+            break;
+        }
+    }
+    if (i < n) {
+        heap_shrink(va, n);                 /* ignora las no mapeadas */
+        g_stats.heap_shrinks -= n;
+        g_stats.heap_grows   -= n;
+        return 0;
+    }
+
+    while (g_heap_hint < KHEAP_PAGES / 32 &&
+           g_heap_map[g_heap_hint] == 0xFFFFFFFF)
+        g_heap_hint++;
+    if (g_stats.heap_pages > g_stats.heap_peak)
+        g_stats.heap_peak = g_stats.heap_pages;
+    return va;
+}
+
+/* page_t del frame detrás de una dirección del heap, o NULL */
+static page_t* heap_page(const void* ptr)
+{
+    uint32_t va = (uint32_t)ptr;
+    pte_t pte;
+
+    if (va < KHEAP_START || va >= KHEAP_END) return NULL;
+    pte = vmm_kernel_pte(va);
+    if (!(pte & PTE_PRESENT)) return NULL;
+    return page_of(pte & ~0xFFF);
+}
+
+static void list_push(kslab_t** head, kslab_t* s)
+{
+    s->prev = NULL;
+    s->next = *head;
+    if (*head) (*head)->prev = s;
+    *head = s;
+}
+
+static void list_del(kslab_t** head, kslab_t* s)
+{
+    if (s->prev) s->prev->next = s->next;
+    else         *head = s->next;
+    if (s->next) s->next->prev = s->prev;
+    s->next = s->prev = NULL;
+}
+
+/* Slab nuevo de la clase, con todos sus objetos en la lista libre */
+static kslab_t* slab_create(uint32_t cls)
+{
+    uint32_t order = slab_order(cls);
+    uint32_t size  = 1u << (cls + KMALLOC_MIN_SHIFT);
+    uint32_t bytes = PAGE_SIZE << order;
+    uint32_t addr  = heap_grow(1u << order);
+    kslab_t* s;
+    uint8_t* obj;
+
+    if (!addr) return NULL;
+    s = (kslab_t*)addr;
+    s->next   = s->prev = NULL;
+    s->in_use = 0;
+    s->total  = (uint16_t)((bytes - SLAB_HDR_SIZE) / size);
+    s->cls    = (uint8_t)cls;
+    s->order  = (uint8_t)order;
+    s->magic  = SLAB_MAGIC;
+
+    /* Lista libre en orden de dirección */
+    s->free = NULL;
+    obj = (uint8_t*)addr + SLAB_HDR_SIZE + (s->total - 1) * size;
+    for (uint32_t i = 0; i < s->total; i++, obj -= size) {
+        *(void**)obj = s->free;
+        s->free = obj;
+    }
+
+    for (uint32_t f = 0; f < (1u << order); f++)
+        page_set(vmm_kernel_pte(addr + f * PAGE_SIZE) & ~0xFFF,
+                 PG_KERNEL | PG_SLAB, addr);
+
+    g_stats.cls[cls].slabs++;
+    g_stats.cls[cls].pages += 1u << order;
+    g_stats.cls[cls].objects += s->total;
+    return s;
+}
+
+static void slab_destroy(kslab_t* s)
+{
+    g_stats.cls[s->cls].slabs--;
+    g_stats.cls[s->cls].pages -= 1u << s->order;
+    g_stats.cls[s->cls].objects -= s->total;
+    s->magic = 0;
+    heap_shrink((uint32_t)s, 1u << s->order);
+}
+
+/* Slab del objeto ptr, o NULL si no es un objeto de slab */
+static kslab_t* slab_of(const void* ptr)
+{
+    page_t* pg = heap_page(ptr);
+    kslab_t* s;
+
+    if (!pg || !(pg->flags & PG_SLAB)) return NULL;
+    s = (kslab_t*)pg->owner;
+    if (!s || s->magic != SLAB_MAGIC) return NULL;
+    return s;
+}
+
+/* ── Pedidos grandes: páginas enteras del heap ───────────────────────── */
+
+static void* large_alloc(size_t size)
+{
+    uint32_t pages, addr;
+
+    if (size > KHEAP_END - KHEAP_START) {
+        g_stats.large_failures++;
+        return NULL;
+    }
+    pages = PAGE_ALIGN(size) / PAGE_SIZE;
+    addr  = heap_grow(pages);
+    if (!addr) {
+        g_stats.large_failures++;
+        return NULL;
+    }
+    for (uint32_t f = 0; f < pages; f++)
+        page_set(vmm_kernel_pte(addr + f * PAGE_SIZE) & ~0xFFF, PG_KERNEL, 0);
+    page_set(vmm_kernel_pte(addr) & ~0xFFF, PG_KERNEL | PG_LARGE, pages);
+
+    g_stats.large_allocs++;
+    g_stats.large_pages += pages;
+    return (void*)addr;
+}
+
+/* ── API pública ──────────────────────────────────────────────────────── */
+
+void kmalloc_init(void)
+{
+    for (uint32_t i = 0; i < KMALLOC_CLASSES; i++) {
+        g_caches[i].avail = g_caches[i].full = NULL;
+        g_caches[i].empty = 0;
+        g_stats.cls[i] = (kmalloc_class_stats_t){0};
+        g_stats.cls[i].size = 1u << (i + KMALLOC_MIN_SHIFT);
+    }
+    g_stats.large_allocs = g_stats.large_frees = 0;
+    g_stats.large_pages  = g_stats.large_failures = 0;
+    g_stats.bad_frees    = 0;
+    g_stats.heap_pages   = g_stats.heap_peak = 0;
+    g_stats.heap_grows   = g_stats.heap_shrinks = 0;
+    for (uint32_t i = 0; i < KHEAP_PAGES / 32; i++)
+        g_heap_map[i] = 0;
+    g_heap_hint = 0;
+}
+
+void* kmalloc(size_t size)
+{
+    uint32_t cls, flags;
+    kcache_t* c;
+    kslab_t* s;
+    void* obj;
+
+    if (!size) return NULL;
+    flags = irq_save();
+
+    if (size > KMALLOC_MAX_SMALL) {
+        obj = large_alloc(size);
+        irq_restore(flags);
+        return obj;
+    }
+
+    cls = size_class(size);
+    c   = &g_caches[cls];
+    s   = c->avail;
+    if (!s) {
+        s = slab_create(cls);
+        if (!s) {
+            g_stats.cls[cls].failures++;
+            irq_restore(flags);
+            return NULL;
+        }
+        list_push(&c->avail, s);
+        c->empty++;
+    }
+
+    if (s->in_use == 0) c->empty--;
+    obj = s->free;
+    s->free = *(void**)obj;
+    if (++s->in_use == s->total) {
+        list_del(&c->avail, s);
+        list_push(&c->full, s);
+    }
+
+    g_stats.cls[cls].in_use++;
+    g_stats.cls[cls].allocs++;
+    irq_restore(flags);
+    return obj;
+}
+
+void kfree(void* ptr)
+{
+    uint32_t flags;
+    kslab_t* s;
+    kcache_t* c;
+    page_t* pg;
+
+    if (!ptr) return;
+    flags = irq_save();
+
+    s = slab_of(ptr);
+    if (s) {
+        uint32_t size = 1u << (s->cls + KMALLOC_MIN_SHIFT);
+        uint32_t off  = (uint32_t)ptr - (uint32_t)s - SLAB_HDR_SIZE;
+
+        /* Puntero dentro del slab pero no al inicio de un objeto */
+        if ((uint32_t)ptr < (uint32_t)s + SLAB_HDR_SIZE || off % size ||
+            !s->in_use) {
+            g_stats.bad_frees++;
+            irq_restore(flags);
+            return;
+        }
+
+        c = &g_caches[s->cls];
+        if (s->in_use == s->total) {
+            list_del(&c->full, s);
+            list_push(&c->avail, s);
+        }
+        *(void**)ptr = s->free;
+        s->free = ptr;
+        g_stats.cls[s->cls].in_use--;
+        g_stats.cls[s->cls].frees++;
+
+        if (--s->in_use == 0) {
+            /* Conservar un slab vacío por clase; el resto vuelve al PMM */
+            if (c->empty) {
+                list_del(&c->avail, s);
+                slab_destroy(s);
+            } else {
+                c->empty++;
+            }
+        }
+        irq_restore(flags);
+        return;
+    }
+
+    pg = heap_page(ptr);
+    if (pg && (pg->flags & PG_LARGE) && !((uint32_t)ptr & (PAGE_SIZE - 1))) {
+        uint32_t pages = pg->owner;
+        g_stats.large_frees++;
+        g_stats.large_pages -= pages;
+        heap_shrink((uint32_t)ptr, pages);
+    } else {
+        g_stats.bad_frees++;
+    }
+    irq_restore(flags);
+}
+
+size_t ksize(const void* ptr)
+{
+    kslab_t* s = slab_of(ptr);
+    page_t* pg;
+
+    if (s) return 1u << (s->cls + KMALLOC_MIN_SHIFT);
+    pg = heap_page(ptr);
+    if (pg && (pg->flags & PG_LARGE)) return pg->owner * PAGE_SIZE;
+    return 0;
+}
+
+void kmalloc_get_stats(kmalloc_stats_t* out)
+{
+    uint32_t flags;
+    if (!out) return;
+    flags = irq_save();
+    *out = g_stats;
+    irq_restore(flags);
+}
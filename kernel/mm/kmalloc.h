@@ -0,0 +1,65 @@
+/*
+ * kmalloc.h — Heap del kernel: slabs por clases de tamaño
+ *
+ * kmalloc()/kfree() (declarados en kstdlib.h, y malloc()/free() encima)
+ * sirven los pedidos de hasta KMALLOC_MAX_SMALL bytes desde slabs: bloques
+ * de páginas partidos en objetos de una sola clase (potencias de dos de
+ * 16B a 2KB). Lo más grande se sirve en páginas enteras.
+ *
+ * Todo vive en un rango virtual propio [KHEAP_START, KHEAP_END): el heap
+ * crece página a página con frames cualquiera del PMM mapeados ahí, y un
+ * slab vacío (salvo uno por clase, para no rebotar frames en rachas de
+ * alloc/free) o un bloque grande liberado se desmapea y sus frames vuelven
+ * al PMM. No hay tamaño fijo ni hace falta memoria físicamente contigua.
+ */
+#ifndef _KMALLOC_H
+#define _KMALLOC_H
+
+#include <types.h>
+
+#define KMALLOC_MIN_SHIFT   4                   /* 16 bytes */
+#define KMALLOC_MAX_SHIFT   11                  /* 2 KB */
+#define KMALLOC_CLASSES     (KMALLOC_MAX_SHIFT - KMALLOC_MIN_SHIFT + 1)
+#define KMALLOC_MAX_SMALL   (1u << KMALLOC_MAX_SHIFT)
+
+/* Rango virtual del heap (ver el layout en vmm.h) */
+#define KHEAP_START         0xD8000000
+#define KHEAP_END           0xE0000000
+#define KHEAP_PAGES         ((KHEAP_END - KHEAP_START) / 4096)
+
+/* Uso de una clase de tamaño */
+typedef struct {
+    uint32_t size;          /* bytes por objeto */
+    uint32_t slabs;         /* slabs vivos */
+    uint32_t pages;         /* frames de esos slabs */
+    uint32_t objects;       /* capacidad total de esos slabs */
+    uint32_t in_use;        /* objetos entregados ahora mismo */
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;      /* sin memoria para un slab nuevo */
+} kmalloc_class_stats_t;
+
+typedef struct {
+    kmalloc_class_stats_t cls[KMALLOC_CLASSES];
+    uint32_t large_allocs;  /* pedidos > KMALLOC_MAX_SMALL */
+    uint32_t large_frees;
+    uint32_t large_pages;   /* frames en uso por pedidos grandes */
+    uint32_t large_failures;
+    uint32_t bad_frees;     /* kfree de punteros que no son del heap */
+
+    uint32_t heap_pages;    /* tamaño actual: páginas mapeadas en el rango */
+    uint32_t heap_peak;     /* high-water mark de heap_pages */
+    uint32_t heap_grows;    /* páginas tomadas del PMM (acumulado) */
+    uint32_t heap_shrinks;  /* páginas devueltas al PMM (acumulado) */
+} kmalloc_stats_t;
+
+/* Dejar las clases vacías. No toca el PMM ni el VMM: se puede llamar
+ * antes de pmm_init(); kmalloc() retorna NULL hasta vmm_init(). */
+void kmalloc_init(void);
+
+/* Bytes utilizables del bloque de ptr (>= lo pedido), 0 si no es del heap */
+size_t ksize(const void* ptr);
+
+void kmalloc_get_stats(kmalloc_stats_t* out);
+
+#endif /* _KMALLOC_H */
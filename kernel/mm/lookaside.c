@@ -0,0 +1,99 @@
+/*
+ * lookaside.c — Listas lookaside (ver lookaside.h)
+ *
+ * Los objetos libres se guardan en un array de punteros y no enlazados
+ * por su primera palabra como en kmalloc: así el objeto no se toca
+ * mientras está en la lista y conserva el estado del constructor.
+ *
+ * Solo push/pop de free[] van con interrupciones desactivadas; ctor, dtor
+ * y el pool corren fuera (el pool tiene su propia protección).
+ *
+ * Los objetos nuevos salen del pool con el tag de la lista, así que la
+ * tabla de `pool` cuenta lo que cada lista tiene en circulación.
+ */
+#include "lookaside.h"
+#include "pool.h"
+#include <hal.h>
+#include <types.h>
+
+/* ── API pública ──────────────────────────────────────────────────────── */
+
+void ExInitializeLookasideList(lookaside_list_t* list,
+                               lookaside_ctor_t ctor, lookaside_dtor_t dtor,
+                               uint32_t size, uint32_t tag, uint32_t depth)
+{
+    if (!list) return;
+    if (!depth || depth > LOOKASIDE_MAX_DEPTH) depth = LOOKASIDE_MAX_DEPTH;
+
+    list->size  = size;
+    list->tag   = tag;
+    list->depth = depth;
+    list->ctor  = ctor;
+    list->dtor  = dtor;
+    list->count = 0;
+    list->total_allocs = list->alloc_misses = 0;
+    list->total_frees  = list->free_misses  = 0;
+    list->failures     = 0;
+}
+
+void* ExAllocateFromLookasideList(lookaside_list_t* list)
+{
+    uint32_t flags;
+    void* obj = NULL;
+
+    if (!list) return NULL;
+
+    flags = irq_save();
+    list->total_allocs++;
+    if (list->count)
+        obj = list->free[--list->count];
+    else
+        list->alloc_misses++;
+    irq_restore(flags);
+    if (obj) return obj;
+
+    /* Fallo de la lista: objeto nuevo del pool */
+    obj = ExAllocatePoolWithTag(list->size, list->tag);
+    if (obj && list->ctor && list->ctor(obj) != 0) {
+        ExFreePoolWithTag(obj, list->tag);
+        obj = NULL;
+    }
+    if (!obj) list->failures++;
+    return obj;
+}
+
+void ExFreeToLookasideList(lookaside_list_t* list, void* obj)
+{
+    uint32_t flags;
+
+    if (!list || !obj) return;
+
+    flags = irq_save();
+    list->total_frees++;
+    if (list->count < list->depth) {
+        list->free[list->count++] = obj;
+        irq_restore(flags);
+        return;
+    }
+    list->free_misses++;
+    irq_restore(flags);
+
+    if (list->dtor) list->dtor(obj);
+    ExFreePoolWithTag(obj, list->tag);
+}
+
+void ExDeleteLookasideList(lookaside_list_t* list)
+{
+    uint32_t flags;
+    void* obj;
+
+    if (!list) return;
+    for (;;) {
+        flags = irq_save();
+        obj = list->count ? list->free[--list->count] : NULL;
+        irq_restore(flags);
+        if (!obj) break;
+        if (list->dtor) list->dtor(obj);
+        ExFreePoolWithTag(obj, list->tag);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * lookaside.h — Listas lookaside para objetos de tamaño fijo (estilo NT)
+ *
+ * Una lookaside list es una caché de objetos ya construidos de un solo
+ * tipo: ExFreeToLookasideList() no devuelve el objeto al pool sino que
+ * lo guarda (hasta depth objetos) y el próximo
+ * ExAllocateFromLookasideList() lo entrega sin pasar por el heap.
+ *
+ * A diferencia de NT, la lista acepta un constructor y un destructor al
+ * estilo de los slabs de Bonwick: ctor corre solo cuando el objeto sale
+ * del pool (con el tag de la lista) y dtor solo cuando vuelve a él.
+ * Mientras el objeto circula por la lista conserva lo que el constructor
+ * le dio (p.ej. el stack de kernel de un thread_t), y quien lo libera
+ * debe dejarlo en ese estado.
+ *
+ * Sin ctor, el objeto se entrega con lo que tuviera (no se pone a cero).
+ */
+#ifndef _LOOKASIDE_H
+#define _LOOKASIDE_H
+
+#include <types.h>
+
+#define LOOKASIDE_MAX_DEPTH   32   /* objetos libres que puede guardar una lista */
+
+/* Tag de 4 caracteres que se lee en orden en un volcado de memoria */
+#define LOOKASIDE_TAG(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+/* Retorna 0, o -1 si el objeto no se pudo construir */
+typedef int  (*lookaside_ctor_t)(void* obj);
+typedef void (*lookaside_dtor_t)(void* obj);
+
+typedef struct {
+    uint32_t          size;         /* bytes por objeto */
+    uint32_t          tag;          /* 4 caracteres, tag de pool de los objetos */
+    uint32_t          depth;        /* tope de free[] (<= LOOKASIDE_MAX_DEPTH) */
+    lookaside_ctor_t  ctor;
+    lookaside_dtor_t  dtor;
+
+    void*             free[LOOKASIDE_MAX_DEPTH];   /* objetos construidos */
+    uint32_t          count;        /* entradas válidas de free[] */
+
+    uint32_t          total_allocs;
+    uint32_t          alloc_misses; /* allocs que tuvieron que ir al pool */
+    uint32_t          total_frees;
+    uint32_t          free_misses;  /* frees que volvieron al pool (lista llena) */
+    uint32_t          failures;     /* sin memoria o ctor fallido */
+} lookaside_list_t;
+
+/*
+ * Preparar una lista vacía para objetos de size bytes. depth = 0 usa
+ * LOOKASIDE_MAX_DEPTH. No reserva memoria: se puede llamar antes del PMM.
+ */
+void ExInitializeLookasideList(lookaside_list_t* list,
+                               lookaside_ctor_t ctor, lookaside_dtor_t dtor,
+                               uint32_t size, uint32_t tag, uint32_t depth);
+
+/* Objeto construido de la lista (o del pool + ctor), NULL si no hay */
+void* ExAllocateFromLookasideList(lookaside_list_t* list);
+
+/* Devolver un objeto de esta lista, en estado construido */
+void ExFreeToLookasideList(lookaside_list_t* list, void* obj);
+
+/* Destruir y devolver al pool todos los objetos guardados */
+void ExDeleteLookasideList(lookaside_list_t* list);
+
+#endif /* _LOOKASIDE_H */
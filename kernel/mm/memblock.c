@@ -0,0 +1,167 @@
+/*
+ * memblock.c — Allocator de arranque (ver memblock.h)
+ *
+ * Dos arrays fijos de rangos, sin ordenar ni fusionar: en el arranque
+ * hay pocas entradas y solo se recorren unas cuantas veces. Todo corre
+ * antes de activar interrupciones y paginación, con identity map.
+ */
+#include "memblock.h"
+#include "pmm.h"
+#include <types.h>
+
+extern void serial_puts(const char*);
+
+/* Fin de la imagen cargada por el bootloader (linker.ld) */
+extern uint8_t _image_end;
+
+#define KERNEL_LOAD_ADDR   0x00100000   /* linker.ld: . = 0x00100000 */
+
+static memblock_t g_mb;
+
+/* ── Helpers ──────────────────────────────────────────────────────────── */
+
+static void add_region(uint64_t base, uint64_t len)
+{
+    uint64_t end = base + len;
+
+    /* La parte sobre 4GB va a la lista alta, en números de frame: solo
+     * la usa el PMM si la CPU tiene PAE */
+    if (end > 0x100000000ULL) {
+        uint64_t hs = base > 0x100000000ULL ? base : 0x100000000ULL;
+        uint32_t s = (uint32_t)((hs + PAGE_SIZE - 1) >> 12);
+        uint32_t e = (uint32_t)(end >> 12);
+        if (e > PMM_MAX_PFN) e = PMM_MAX_PFN;
+        if (e > s && g_mb.high_count < MEMBLOCK_MAX_HIGH) {
+            g_mb.high[g_mb.high_count].start = s;
+            g_mb.high[g_mb.high_count].end   = e;
+            g_mb.high_count++;
+        }
+    }
+
+    if (base >= 0x100000000ULL) return;
+    if (end > 0xFFFFF000ULL) end = 0xFFFFF000ULL;
+    if (g_mb.memory_count >= MEMBLOCK_MAX_REGIONS) return;
+
+    uint32_t s = PAGE_ALIGN((uint32_t)base);
+    uint32_t e = (uint32_t)end & ~(PAGE_SIZE - 1);
+    if (s < KERNEL_LOAD_ADDR) s = KERNEL_LOAD_ADDR;   /* < 1MB: BIOS/VGA */
+    if (e <= s) return;
+
+    g_mb.memory[g_mb.memory_count].start = s;
+    g_mb.memory[g_mb.memory_count].end   = e;
+    g_mb.memory_count++;
+}
+
+/* Primer rango reservado que se solapa con [a, b), o NULL */
+static memblock_range_t* find_reserved(uint32_t a, uint32_t b)
+{
+    for (uint32_t i = 0; i < g_mb.reserved_count; i++) {
+        if (a < g_mb.reserved[i].end && g_mb.reserved[i].start < b)
+            return &g_mb.reserved[i];
+    }
+    return NULL;
+}
+
+/* Leer las regiones utilizables del mmap (o mem_upper si no hay mmap) */
+static void collect_regions(multiboot_info_t* mbi)
+{
+    if (mbi && (mbi->flags & MULTIBOOT_INFO_MEM_MAP)) {
+        uint32_t p   = mbi->mmap_addr;
+        uint32_t end = mbi->mmap_addr + mbi->mmap_length;
+        while (p < end) {
+            multiboot_mmap_entry_t* e = (multiboot_mmap_entry_t*)p;
+            if (e->type == MULTIBOOT_MEMORY_AVAILABLE)
+                add_region(e->addr, e->len);
+            p += e->size + 4;
+        }
+    }
+
+    if (g_mb.memory_count == 0) {
+        uint32_t upper_kb = 32768;   /* 32MB por defecto */
+        if (mbi && (mbi->flags & MULTIBOOT_INFO_MEMORY))
+            upper_kb = mbi->mem_upper;
+        add_region(KERNEL_LOAD_ADDR, (uint64_t)upper_kb * 1024);
+    }
+}
+
+/* Reservar todo lo que el kernel ya ocupa antes de tener PMM */
+static void collect_reserved(multiboot_info_t* mbi)
+{
+    /* Imagen del kernel (incluye .bss, .init y las secciones .user) */
+    memblock_reserve(KERNEL_LOAD_ADDR, (uint32_t)&_image_end);
+
+    if (!mbi) return;
+
+    /* Estructuras de multiboot: podemos seguir consultándolas después */
+    memblock_reserve((uint32_t)mbi, (uint32_t)mbi + sizeof(multiboot_info_t));
+    if (mbi->flags & MULTIBOOT_INFO_MEM_MAP)
+        memblock_reserve(mbi->mmap_addr, mbi->mmap_addr + mbi->mmap_length);
+    if (mbi->flags & MULTIBOOT_INFO_CMDLINE)
+        memblock_reserve(mbi->cmdline, mbi->cmdline + 1);
+    if (mbi->flags & MULTIBOOT_INFO_MODS) {
+        multiboot_module_t* mods = (multiboot_module_t*)mbi->mods_addr;
+        memblock_reserve(mbi->mods_addr,
+                         mbi->mods_addr + mbi->mods_count * sizeof(multiboot_module_t));
+        for (uint32_t i = 0; i < mbi->mods_count; i++)
+            memblock_reserve(mods[i].mod_start, mods[i].mod_end);
+    }
+}
+
+/* ── API pública ──────────────────────────────────────────────────────── */
+
+void memblock_init(multiboot_info_t* mbi)
+{
+    g_mb.memory_count   = 0;
+    g_mb.high_count     = 0;
+    g_mb.reserved_count = 0;
+    g_mb.allocated      = 0;
+    g_mb.retired        = 0;
+
+    collect_regions(mbi);
+    collect_reserved(mbi);
+}
+
+void memblock_reserve(uint32_t start, uint32_t end)
+{
+    if (end <= start || g_mb.reserved_count >= MEMBLOCK_MAX_RESERVED) return;
+    g_mb.reserved[g_mb.reserved_count].start = start & ~(PAGE_SIZE - 1);
+    g_mb.reserved[g_mb.reserved_count].end   = PAGE_ALIGN(end);
+    g_mb.reserved_count++;
+}
+
+uint32_t memblock_alloc(uint32_t size, uint32_t limit)
+{
+    if (g_mb.retired) {
+        serial_puts("[memblock] alloc despues de pmm_init()\r\n");
+        return 0;
+    }
+    if (!size || g_mb.reserved_count >= MEMBLOCK_MAX_RESERVED) return 0;
+    size = PAGE_ALIGN(size);
+
+    for (uint32_t i = 0; i < g_mb.memory_count; i++) {
+        uint32_t a   = g_mb.memory[i].start;
+        uint32_t end = g_mb.memory[i].end;
+        if (end > limit) end = limit;
+
+        while (a < end && size <= end - a) {
+            memblock_range_t* r = find_reserved(a, a + size);
+            if (!r) {
+                memblock_reserve(a, a + size);
+                g_mb.allocated += size;
+                return a;
+            }
+            a = r->end;
+        }
+    }
+    return 0;
+}
+
+const memblock_t* memblock_get(void)
+{
+    return &g_mb;
+}
+
+void memblock_retire(void)
+{
+    g_mb.retired = 1;
+}
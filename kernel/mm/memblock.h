@@ -0,0 +1,58 @@
+/*
+ * memblock.h — Allocator de arranque (antes del PMM)
+ *
+ * memblock_init() lee el mapa de memoria de multiboot y arma dos listas
+ * de rangos físicos: la RAM utilizable y lo que ya está ocupado (imagen
+ * del kernel, estructuras de multiboot, módulos). memblock_alloc() toma
+ * memoria de ahí en first fit y la agrega a la lista de reservados; así
+ * se ubican las estructuras que el PMM necesita antes de existir (su
+ * bitmap y el array de page_t).
+ *
+ * La RAM por encima de 4GB queda aparte (high, en números de frame):
+ * memblock no la entrega nunca y el PMM la usa solo con PAE.
+ *
+ * pmm_init() construye el bitmap a partir de estas dos listas y retira
+ * memblock: desde entonces memblock_alloc() retorna 0 y la memoria se
+ * pide al PMM.
+ */
+#ifndef _MEMBLOCK_H
+#define _MEMBLOCK_H
+
+#include <types.h>
+#include <multiboot.h>
+
+#define MEMBLOCK_MAX_REGIONS    32      /* regiones utilizables del mmap */
+#define MEMBLOCK_MAX_RESERVED   32      /* rangos reservados dentro de ellas */
+#define MEMBLOCK_MAX_HIGH       8       /* regiones sobre 4GB */
+
+typedef struct { uint32_t start, end; } memblock_range_t;
+
+typedef struct {
+    memblock_range_t memory[MEMBLOCK_MAX_REGIONS];
+    uint32_t         memory_count;
+    memblock_range_t reserved[MEMBLOCK_MAX_RESERVED];
+    uint32_t         reserved_count;
+    memblock_range_t high[MEMBLOCK_MAX_HIGH];   /* frames, no direcciones */
+    uint32_t         high_count;
+    uint32_t         allocated;         /* bytes entregados por memblock_alloc */
+    int              retired;           /* el PMM ya tomó el control */
+} memblock_t;
+
+/* Leer el mmap (mbi puede ser NULL: se asumen 32MB sobre 1MB) y
+ * reservar la imagen del kernel y lo que dejó el bootloader */
+void memblock_init(multiboot_info_t* mbi);
+
+/* Marcar [start, end) como ocupado (redondeado a páginas) */
+void memblock_reserve(uint32_t start, uint32_t end);
+
+/* size bytes de RAM libre bajo limit, alineados a página y ya
+ * reservados. Retorna la dirección física o 0. */
+uint32_t memblock_alloc(uint32_t size, uint32_t limit);
+
+/* Las listas, para que pmm_init() arme el bitmap */
+const memblock_t* memblock_get(void);
+
+/* Lo llama pmm_init() al terminar */
+void memblock_retire(void);
+
+#endif /* _MEMBLOCK_H */
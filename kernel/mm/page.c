@@ -0,0 +1,79 @@
+/*
+ * page.c — Metadatos por frame físico (ver page.h)
+ *
+ * El array lo ubica pmm_init() junto al bitmap (bajo PMM_DIRECT_LIMIT),
+ * con una entrada de 8 bytes por frame: 512KB por cada 256MB de RAM
+ * (también la que queda sobre 4GB con PAE).
+ */
+#include "page.h"
+#include "pmm.h"
+#include <types.h>
+
+static page_t*  page_array  = NULL;
+static uint32_t page_frames = 0;
+
+void page_array_init(page_t* array, uint32_t frames)
+{
+    page_array  = array;
+    page_frames = array ? frames : 0;
+    for (uint32_t i = 0; i < page_frames; i++) {
+        page_array[i].refcount = 0;
+        page_array[i].flags    = 0;
+        page_array[i].owner    = 0;
+    }
+}
+
+page_t* page_of(phys_addr_t addr)
+{
+    uint32_t frame = (uint32_t)(addr >> 12);   /* sin división de 64 bits */
+    if (frame >= page_frames) return NULL;
+    return &page_array[frame];
+}
+
+void page_on_alloc(phys_addr_t addr)
+{
+    page_t* pg = page_of(addr);
+    if (!pg) return;
+    pg->refcount = 1;
+    pg->flags    = 0;
+    pg->owner    = 0;
+}
+
+void page_on_free(phys_addr_t addr)
+{
+    page_t* pg = page_of(addr);
+    if (!pg) return;
+    pg->refcount = 0;
+    pg->flags    = 0;
+    pg->owner    = 0;
+}
+
+void page_set(phys_addr_t addr, uint16_t flags, uint32_t owner)
+{
+    page_t* pg = page_of(addr);
+    if (!pg) return;
+    pg->flags = flags;
+    pg->owner = owner;
+}
+
+uint32_t page_get(phys_addr_t addr)
+{
+    page_t* pg = page_of(addr);
+    if (!pg || !pg->refcount || pg->refcount == 0xFFFF) return 0;
+    return ++pg->refcount;
+}
+
+uint32_t page_put(phys_addr_t addr)
+{
+    page_t* pg = page_of(addr);
+    if (!pg || !pg->refcount) return 0;   /* ya libre: ignorar */
+    if (--pg->refcount) return pg->refcount;
+
+    /* Última referencia: los frames fijados del kernel nunca se liberan */
+    if (pg->flags & PG_PINNED) {
+        pg->refcount = 1;
+        return 1;
+    }
+    pmm_free_frame(addr & ~(phys_addr_t)(PAGE_SIZE - 1));
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * page.h — Metadatos por frame físico (struct page)
+ *
+ * Un page_t por frame del PMM, indexado por número de frame
+ * (addr >> 12), también sobre 4GB con PAE. El PMM lo mantiene al
+ * allocar/liberar y el VMM lo usa para saber qué es cada frame y cuántos
+ * espacios de direcciones lo comparten, sin recorrer page tables.
+ *
+ *   refcount  0 = libre (o en magazine/pool del PMM), N = N referencias
+ *   flags     PG_* (qué contiene el frame)
+ *   owner     pid del proceso dueño (0 = kernel)
+ */
+#ifndef _PAGE_H
+#define _PAGE_H
+
+#include <types.h>
+
+/* ── Flags ──────────────────────────────────────────────────────────────── */
+#define PG_KERNEL      (1 << 0)   /* memoria del kernel (imagen, stacks, heap) */
+#define PG_USER        (1 << 1)   /* datos de un proceso de usuario */
+#define PG_PAGETABLE   (1 << 2)   /* page directory o page table */
+#define PG_PINNED      (1 << 3)   /* no se puede desalojar ni mover */
+#define PG_ZEROED      (1 << 4)   /* entregado lleno de ceros */
+#define PG_SLAB        (1 << 5)   /* slab de kmalloc (owner = cabecera del slab) */
+#define PG_LARGE       (1 << 6)   /* bloque grande de kmalloc (owner = order) */
+
+typedef struct {
+    uint16_t refcount;
+    uint16_t flags;
+    uint32_t owner;
+} page_t;
+
+/* ── API ────────────────────────────────────────────────────────────────── */
+
+/* Metadatos del frame que contiene addr, o NULL si el PMM no lo cubre */
+page_t* page_of(phys_addr_t addr);
+
+/* Tomar una referencia más sobre un frame allocado. Retorna el nuevo
+ * refcount (0 si el frame no existe o está libre). */
+uint32_t page_get(phys_addr_t addr);
+
+/* Soltar una referencia; al llegar a 0 el frame vuelve al PMM.
+ * Retorna el refcount que queda. */
+uint32_t page_put(phys_addr_t addr);
+
+/* Fijar flags y dueño de un frame recién allocado */
+void page_set(phys_addr_t addr, uint16_t flags, uint32_t owner);
+
+/* ── Uso interno del PMM ────────────────────────────────────────────────── */
+
+/* Instalar el array (frames entradas, ya reservado por el PMM) a cero */
+void page_array_init(page_t* array, uint32_t frames);
+
+/* Frame recién allocado: refcount=1, sin flags, dueño kernel */
+void page_on_alloc(phys_addr_t addr);
+
+/* Frame devuelto al PMM: todo a cero */
+void page_on_free(phys_addr_t addr);
+
+#endif /* _PAGE_H */
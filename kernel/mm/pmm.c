@@ -1,104 +1,658 @@
 /*
- * pmm.c — Physical Memory Manager (bitmap allocator)
+ * pmm.c — Physical Memory Manager (bitmap allocator de 2 niveles)
  *
- * Divide la RAM en frames de 4096 bytes.
- * Usa un bitmap estático de 2048 bytes → cubre hasta 64MB (16384 frames).
- * Cada bit representa un frame: 0=libre, 1=usado.
+ * Divide la RAM en frames de 4096 bytes. El frame N es la dirección
+ * física N * PAGE_SIZE.
+ * Nivel 0: bitmap de palabras de 32 bits, un bit por frame: 0=libre, 1=usado.
+ * Nivel 1: bitmap resumen — un bit por palabra de nivel 0.
+ *          1 = esa palabra tiene al menos un frame libre.
+ *
+ * Buscar un frame libre es: bsf sobre el resumen → palabra candidata,
+ * bsf sobre la palabra invertida → frame. Con el cursor pmm_hint (primera
+ * palabra de resumen que puede tener libres) la asignación y la
+ * liberación quedan en O(1) en la práctica, en vez de recorrer miles de
+ * bytes llenos cuando la máquina se va llenando.
+ *
+ * Tamaño y contenido salen de memblock (memblock.c), que ya leyó el mapa
+ * de memoria de multiboot (E820): el bitmap se dimensiona para la región
+ * utilizable más alta y se pide a memblock_alloc() bajo PMM_DIRECT_LIMIT.
+ * Solo las regiones utilizables se marcan libres; luego se vuelve a
+ * ocupar todo lo que memblock tiene reservado (imagen del kernel, info
+ * de multiboot, módulos, el propio bitmap).
+ *
+ * Cada frame tiene además un page_t (page.c) con refcount, flags y dueño.
+ * Se actualiza en todos los caminos de alloc/free de este archivo y del
+ * buddy; lo ocupado en el arranque queda como PG_KERNEL | PG_PINNED.
+ *
+ * Los frames liberados pasan primero por un "magazine" (pila LIFO de
+ * PMM_MAGAZINE_SIZE frames): siguen marcados como usados en el bitmap y
+ * el próximo pmm_alloc_frame()/pmm_alloc_batch() los reutiliza sin tocar
+ * el bitmap. Es el patrón típico de crear/destruir procesos y tablas.
+ *
+ * Además se mantiene un pool de hasta PMM_ZERO_POOL_SIZE frames ya
+ * llenos de ceros, que el thread idle rellena con rep stosd mientras la
+ * CPU no tiene otra cosa que hacer. pmm_alloc_zeroed_frame() saca de ahí
+ * y solo pone a cero en el momento si el pool está vacío.
+ *
+ * Una zona de hasta PMM_BUDDY_ZONE_SIZE bytes alineada a su tamaño se
+ * marca como usada en el bitmap y se entrega al buddy allocator
+ * (buddy.c) para los pedidos contiguos (pmm_alloc_pages). Si el bitmap
+ * se agota, pmm_alloc_frame() toma frames sueltos de la zona (order 0).
+ *
+ * Con PAE (vmm_pae_capable) el bitmap también cubre la RAM sobre 4GB
+ * (memblock la deja en su lista alta). Esos frames solo se alcanzan por
+ * vmm_kmap, así que los allocators del kernel no los ven: se buscan en
+ * las palabras de resumen desde pmm_low_summary, con su propio cursor,
+ * y solo los entregan pmm_alloc_user_frame() y
+ * pmm_alloc_zeroed_user_frame() para páginas de usuario.
+ *
+ * Si no queda nada, pmm_alloc_frame() y pmm_alloc_batch() piden a
+ * swap_reclaim() que desaloje páginas de usuario al disco de swap y
+ * reintentan una vez (sin área de swap fallan como siempre).
  */
 #include "pmm.h"
+#include "memblock.h"
+#include "buddy.h"
+#include "page.h"
+#include "swap.h"
+#include "vmm.h"       /* vmm_kmap para frames fuera del identity map */
+#include <hal.h>       /* irq_save/irq_restore */
 #include <types.h>
 
+extern void serial_puts(const char*);
+extern void serial_print_hex(uint32_t v);
+
 /* ── Configuración ────────────────────────────────────────────────────────── */
-/* Número máximo de frames que manejamos (64MB / 4KB = 16384) */
-#define MAX_FRAMES      16384
-/* El bitmap ocupa MAX_FRAMES / 8 bytes = 2048 bytes */
-#define BITMAP_SIZE     (MAX_FRAMES / 8)
+#define PMM_MIN_ZONE       0x00010000   /* zona buddy mínima: 64KB */
 
 /* ── Estado interno ───────────────────────────────────────────────────────── */
-static uint8_t  pmm_bitmap[BITMAP_SIZE];   /* 0=libre, 1=usado */
-static uint32_t pmm_total_frames = 0;
-static uint32_t pmm_used  = 0;
+static uint32_t* pmm_bitmap  = NULL;        /* nivel 0: 0=libre, 1=usado */
+static uint32_t* pmm_summary = NULL;        /* nivel 1: 1=palabra con libres */
+static uint32_t  pmm_bitmap_words  = 0;
+static uint32_t  pmm_summary_words = 0;
+static uint32_t  pmm_max_frames    = 0;     /* frames cubiertos por el bitmap */
+static uint32_t  pmm_hint = 0;              /* primera palabra de resumen a mirar */
+static uint32_t  pmm_total_frames = 0;
+static uint32_t  pmm_used  = 0;
+
+/* Memoria alta (sobre 4GB, solo con PAE): resumen desde pmm_low_summary */
+static uint32_t  pmm_low_frames    = 0;     /* frames bajo 4GB en el bitmap */
+static uint32_t  pmm_low_summary   = 0;     /* palabras de resumen de esos */
+static uint32_t  pmm_high_hint     = 0;
+static uint32_t  pmm_high_total    = 0;
+static uint32_t  pmm_high_used     = 0;
+
+/* Magazine de frames recién liberados (marcados usados en el bitmap) */
+static uint32_t  pmm_mag[PMM_MAGAZINE_SIZE];
+static uint32_t  pmm_mag_count = 0;
 
-/* Dirección física del primer frame manejado */
-#define BASE_ADDR   PMM_FREE_START
+/* Pool de frames pre-zeroed (usados en el bitmap, contenido = 0) */
+static uint32_t          pmm_zpool[PMM_ZERO_POOL_SIZE];
+static uint32_t          pmm_zpool_count = 0;
+static pmm_zero_stats_t  pmm_zstats;
 
 /* ── Helpers de bitmap ────────────────────────────────────────────────────── */
+
+/* Índice del bit menos significativo a 1 (v != 0) */
+static inline uint32_t bsf32(uint32_t v)
+{
+    uint32_t idx;
+    __asm__("bsf %1, %0" : "=r"(idx) : "rm"(v));
+    return idx;
+}
+
+/* Poner a cero un frame; los que quedan fuera del identity map se
+ * alcanzan por la ventana kmap del VMM */
+static void zero_frame(phys_addr_t addr)
+{
+    void* p = (addr < PMM_DIRECT_LIMIT) ? (void*)(uint32_t)addr : vmm_kmap(addr);
+    uint32_t d = (uint32_t)p, c = PAGE_SIZE / 4;
+
+    if (!p) return;
+    __asm__ volatile("cld; rep stosl"
+                     : "+D"(d), "+c"(c) : "a"(0) : "memory");
+    if (addr >= PMM_DIRECT_LIMIT) vmm_kunmap(p);
+}
+
+static inline int bitmap_test(uint32_t frame)
+{
+    return (pmm_bitmap[frame / 32] >> (frame % 32)) & 1;
+}
+
+/* Marca el frame como usado y apaga el bit de resumen si la palabra se llenó */
 static inline void bitmap_set(uint32_t frame)
 {
-    pmm_bitmap[frame / 8] |= (1 << (frame % 8));
+    uint32_t w = frame / 32;
+    pmm_bitmap[w] |= (1u << (frame % 32));
+    if (pmm_bitmap[w] == 0xFFFFFFFF)
+        pmm_summary[w / 32] &= ~(1u << (w % 32));
 }
 
+/* Marca el frame como libre, enciende el resumen y retrocede el cursor */
 static inline void bitmap_clear(uint32_t frame)
 {
-    pmm_bitmap[frame / 8] &= ~(uint8_t)(1 << (frame % 8));
+    uint32_t w = frame / 32;
+    pmm_bitmap[w] &= ~(1u << (frame % 32));
+    pmm_summary[w / 32] |= (1u << (w % 32));
+    if (w / 32 >= pmm_low_summary) {
+        if (w / 32 < pmm_high_hint) pmm_high_hint = w / 32;
+    } else if (w / 32 < pmm_hint) {
+        pmm_hint = w / 32;
+    }
 }
 
-static inline int bitmap_test(uint32_t frame)
+/* ── Helpers de inicialización ────────────────────────────────────────────── */
+
+/* ¿Están libres todos los frames de [base, base+size)? */
+static int range_is_free(uint32_t base, uint32_t size)
 {
-    return (pmm_bitmap[frame / 8] >> (frame % 8)) & 1;
+    for (uint32_t f = base / PAGE_SIZE; f < (base + size) / PAGE_SIZE; f++) {
+        if (f >= pmm_max_frames || bitmap_test(f)) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Elegir la zona buddy: el bloque más grande (hasta PMM_BUDDY_ZONE_SIZE)
+ * alineado a min(tamaño, 4MB) y completamente libre bajo
+ * PMM_DIRECT_LIMIT — los stacks de kernel salen de aquí y se acceden
+ * por identity mapping.
+ */
+static void setup_buddy_zone(void)
+{
+    uint32_t size, align, base, f;
+
+    for (size = PMM_BUDDY_ZONE_SIZE; size >= PMM_MIN_ZONE; size >>= 1) {
+        align = size < (PAGE_SIZE << PMM_MAX_ORDER) ? size
+                                                    : (PAGE_SIZE << PMM_MAX_ORDER);
+        for (base = align; base + size <= PMM_DIRECT_LIMIT; base += align) {
+            if (!range_is_free(base, size)) continue;
+
+            for (f = base / PAGE_SIZE; f < (base + size) / PAGE_SIZE; f++)
+                bitmap_set(f);
+            pmm_total_frames -= size / PAGE_SIZE;
+            buddy_init(base, size / PAGE_SIZE);
+
+            serial_puts("[pmm] zona buddy ");
+            serial_print_hex(base);
+            serial_puts(" + ");
+            serial_print_hex(size);
+            serial_puts("\r\n");
+            return;
+        }
+    }
+    buddy_init(0, 0);
+    serial_puts("[pmm] sin zona buddy\r\n");
 }
 
 /* ── API pública ──────────────────────────────────────────────────────────── */
 
-void pmm_init(uint32_t mem_upper_kb)
+void pmm_init(void)
 {
-    uint32_t i;
-    uint32_t mem_end;
+    const memblock_t* mb = memblock_get();
+    uint32_t i, f, max_end = 0, max_high = 0;
 
-    /* Marcar todo como usado por defecto (seguro) */
-    for (i = 0; i < BITMAP_SIZE; i++)
-        pmm_bitmap[i] = 0xFF;
+    /* Dimensionar el bitmap para la región utilizable más alta.
+     * Redondeamos a 1024 frames para que el resumen quede entero. */
+    for (i = 0; i < mb->memory_count; i++) {
+        if (mb->memory[i].end > max_end) max_end = mb->memory[i].end;
+    }
+    pmm_low_frames = ((max_end / PAGE_SIZE) + 1023) & ~1023u;
 
-    /* Calcular extremo de RAM disponible */
-    mem_end = (mem_upper_kb + 1024) * 1024;   /* mem_upper en KB desde 1MB */
-    if (mem_end > PMM_FREE_END)
-        mem_end = PMM_FREE_END;
+    /* La RAM sobre 4GB solo sirve si el VMM puede activar PAE */
+    if (mb->high_count && vmm_pae_capable()) {
+        for (i = 0; i < mb->high_count; i++) {
+            if (mb->high[i].end > max_high) max_high = mb->high[i].end;
+        }
+        pmm_low_frames = 0x100000;            /* el resumen alto empieza en 4GB */
+    }
+    pmm_max_frames    = max_high ? ((max_high + 1023) & ~1023u) : pmm_low_frames;
+    pmm_bitmap_words  = pmm_max_frames / 32;
+    pmm_summary_words = pmm_bitmap_words / 32;
+    pmm_low_summary   = pmm_low_frames / 1024;
+
+    /* Ubicar bitmap + resumen en RAM libre y reservarlos */
+    {
+        uint32_t bytes = (pmm_bitmap_words + pmm_summary_words) * sizeof(uint32_t);
+        uint32_t addr  = memblock_alloc(bytes, PMM_DIRECT_LIMIT);
+        if (!addr) {
+            serial_puts("[pmm] sin espacio para el bitmap\r\n");
+            pmm_max_frames = 0;
+            return;
+        }
+        pmm_bitmap  = (uint32_t*)addr;
+        pmm_summary = pmm_bitmap + pmm_bitmap_words;
+    }
 
-    /* Liberar frames en el rango PMM_FREE_START..mem_end */
+    /* Array de page_t: una entrada por frame cubierto por el bitmap */
     {
-        uint32_t start_frame = (PMM_FREE_START - BASE_ADDR) / PAGE_SIZE;
-        uint32_t end_frame   = (mem_end        - BASE_ADDR) / PAGE_SIZE;
+        uint32_t bytes = pmm_max_frames * sizeof(page_t);
+        uint32_t addr  = memblock_alloc(bytes, PMM_DIRECT_LIMIT);
+        if (!addr) serial_puts("[pmm] sin espacio para struct page\r\n");
+        page_array_init((page_t*)addr, pmm_max_frames);
+    }
+
+    /* Marcar todo como usado por defecto (seguro) */
+    for (i = 0; i < pmm_bitmap_words; i++)
+        pmm_bitmap[i] = 0xFFFFFFFF;
+    for (i = 0; i < pmm_summary_words; i++)
+        pmm_summary[i] = 0;
+    pmm_hint = 0;
+    pmm_total_frames = 0;
+    pmm_used = 0;
+    pmm_high_hint = pmm_low_summary;
+    pmm_high_total = 0;
+    pmm_high_used = 0;
+    pmm_mag_count = 0;
+    pmm_zpool_count = 0;
+
+    /* Liberar las regiones utilizables (las solapadas cuentan una vez) */
+    for (i = 0; i < mb->memory_count; i++) {
+        serial_puts("[pmm] RAM ");
+        serial_print_hex(mb->memory[i].start);
+        serial_puts(" - ");
+        serial_print_hex(mb->memory[i].end);
+        serial_puts("\r\n");
+        for (f = mb->memory[i].start / PAGE_SIZE;
+             f < mb->memory[i].end / PAGE_SIZE; f++) {
+            if (bitmap_test(f)) {
+                bitmap_clear(f);
+                pmm_total_frames++;
+            }
+        }
+    }
+
+    /* Memoria alta: nada de memblock se reserva ahí */
+    for (i = 0; max_high && i < mb->high_count; i++) {
+        serial_puts("[pmm] RAM alta, frames ");
+        serial_print_hex(mb->high[i].start);
+        serial_puts(" - ");
+        serial_print_hex(mb->high[i].end);
+        serial_puts("\r\n");
+        for (f = mb->high[i].start; f < mb->high[i].end; f++) {
+            if (bitmap_test(f)) {
+                bitmap_clear(f);
+                pmm_high_total++;
+            }
+        }
+    }
 
-        if (end_frame > MAX_FRAMES)
-            end_frame = MAX_FRAMES;
+    /* Volver a ocupar lo reservado que cayó dentro de la RAM */
+    for (i = 0; i < mb->reserved_count; i++) {
+        for (f = mb->reserved[i].start / PAGE_SIZE;
+             f < mb->reserved[i].end / PAGE_SIZE && f < pmm_max_frames; f++) {
+            if (!bitmap_test(f)) {
+                bitmap_set(f);
+                pmm_total_frames--;
+            }
+        }
+    }
 
-        pmm_total_frames = end_frame - start_frame;
+    setup_buddy_zone();
 
-        for (i = start_frame; i < end_frame; i++)
-            bitmap_clear(i);
+    /* Todo lo ocupado a esta altura es del kernel y no se mueve */
+    for (f = 0; f < pmm_low_frames; f++) {
+        if (bitmap_test(f) && !buddy_owns(f * PAGE_SIZE)) {
+            page_on_alloc(f * PAGE_SIZE);
+            page_set(f * PAGE_SIZE, PG_KERNEL | PG_PINNED, 0);
+        }
+    }
+
+    /* De aquí en adelante la memoria se pide al PMM */
+    memblock_retire();
+}
+
+uint32_t pmm_release_range(uint32_t start, uint32_t end)
+{
+    uint32_t flags = irq_save();
+    uint32_t n = 0;
 
-        pmm_used = 0;
+    for (uint32_t f = PAGE_ALIGN(start) / PAGE_SIZE;
+         f < end / PAGE_SIZE && f < pmm_max_frames; f++) {
+        if (!bitmap_test(f) || buddy_owns(f * PAGE_SIZE)) continue;
+        page_on_free(f * PAGE_SIZE);
+        bitmap_clear(f);
+        pmm_total_frames++;
+        n++;
     }
+    irq_restore(flags);
+    return n;
+}
+
+/* Frame libre más bajo del bitmap, o 0 si el bitmap está lleno */
+static uint32_t bitmap_alloc(void)
+{
+    uint32_t s;
+
+    for (s = pmm_hint; s < pmm_low_summary; s++) {
+        if (!pmm_summary[s]) continue;          /* 1024 frames llenos */
+
+        uint32_t w     = s * 32 + bsf32(pmm_summary[s]);
+        uint32_t frame = w * 32 + bsf32(~pmm_bitmap[w]);
+
+        bitmap_set(frame);
+        pmm_used++;
+        pmm_hint = s;
+        return frame * PAGE_SIZE;
+    }
+    pmm_hint = pmm_low_summary;
+    return 0;
+}
+
+/* Frame libre más bajo sobre 4GB, o 0 si no hay (sin PAE nunca hay) */
+static phys_addr_t highmem_alloc(void)
+{
+    uint32_t s;
+
+    for (s = pmm_high_hint; s < pmm_summary_words; s++) {
+        if (!pmm_summary[s]) continue;
+
+        uint32_t w     = s * 32 + bsf32(pmm_summary[s]);
+        uint32_t frame = w * 32 + bsf32(~pmm_bitmap[w]);
+
+        bitmap_set(frame);
+        pmm_high_used++;
+        pmm_high_hint = s;
+        return (phys_addr_t)frame << 12;
+    }
+    pmm_high_hint = pmm_summary_words;
+    return 0;
+}
+
+/* Devolver un frame del bitmap (no del buddy) al estado libre */
+static void bitmap_free(uint32_t frame)
+{
+    if (frame >= pmm_max_frames) return;
+    if (bitmap_test(frame)) {
+        bitmap_clear(frame);
+        if (frame >= pmm_low_frames) pmm_high_used--;
+        else                         pmm_used--;
+    }
+}
+
+/* ¿Está el frame ya en el magazine? (detecta doble free) */
+static int mag_contains(uint32_t addr)
+{
+    for (uint32_t i = 0; i < pmm_mag_count; i++) {
+        if (pmm_mag[i] == addr) return 1;
+    }
+    return 0;
+}
+
+/* Frame del magazine o del bitmap: los dos cuentan en pmm_used */
+static uint32_t take_bitmap_frame(void)
+{
+    /* Camino rápido: frame reciclado del magazine */
+    if (pmm_mag_count)
+        return pmm_mag[--pmm_mag_count];
+    return bitmap_alloc();
+}
+
+/* Siguiente frame libre sin tocar sus metadatos. Como todo lo que toca
+ * bitmap, magazine y pool, con interrupciones off: el idle rellena el
+ * pool de pre-zeroed desde los mismos frames (pmm_zero_pool_refill) */
+static uint32_t take_frame(void)
+{
+    uint32_t addr = take_bitmap_frame();
+    if (addr) return addr;
+
+    /* Bitmap agotado: usar un frame suelto de la zona buddy */
+    addr = pmm_alloc_pages(0);
+    if (addr) return addr;
+
+    /* Último recurso: los frames pre-zeroed también sirven */
+    if (pmm_zpool_count)
+        return pmm_zpool[--pmm_zpool_count];
+    return 0;   /* sin memoria */
 }
 
 uint32_t pmm_alloc_frame(void)
 {
-    uint32_t i, j;
+    uint32_t flags = irq_save();
+    uint32_t addr  = take_frame();
+    irq_restore(flags);
+
+    /* Sin frames: mandar páginas de usuario al swap (fuera de la sección
+     * crítica: escribe al disco) y reintentar */
+    if (!addr && swap_reclaim(SWAP_CLUSTER)) {
+        flags = irq_save();
+        addr  = take_frame();
+        irq_restore(flags);
+    }
+    if (addr) page_on_alloc(addr);
+    return addr;
+}
+
+static void free_frame(phys_addr_t addr)
+{
+    uint32_t frame = (uint32_t)(addr >> 12);
 
-    for (i = 0; i < BITMAP_SIZE; i++) {
-        if (pmm_bitmap[i] == 0xFF) continue;   /* byte lleno, siguiente */
-        for (j = 0; j < 8; j++) {
-            uint32_t frame = i * 8 + j;
-            if (!bitmap_test(frame)) {
-                bitmap_set(frame);
+    /* Memoria alta antes que buddy_owns(): truncada a 32 bits podría
+     * caer en la zona buddy. Va directa al bitmap, sin magazine */
+    if (frame >= pmm_low_frames) {
+        if (frame >= pmm_max_frames || !bitmap_test(frame)) return;
+        page_on_free(addr);
+        bitmap_free(frame);
+        return;
+    }
+    if (buddy_owns((uint32_t)addr)) {
+        pmm_free_pages((uint32_t)addr, 0);
+        return;
+    }
+    if (!bitmap_test(frame)) return;
+    if (mag_contains((uint32_t)addr)) return;
+    page_on_free(addr);
+
+    if (pmm_mag_count < PMM_MAGAZINE_SIZE) {
+        pmm_mag[pmm_mag_count++] = (uint32_t)addr;   /* sigue "usado" en el bitmap */
+        return;
+    }
+    bitmap_free(frame);
+}
+
+void pmm_free_frame(phys_addr_t addr)
+{
+    uint32_t flags = irq_save();
+    free_frame(addr);
+    irq_restore(flags);
+}
+
+static uint32_t alloc_batch(uint32_t n, uint32_t* out)
+{
+    uint32_t got = 0, s;
+
+    /* 1. Vaciar el magazine */
+    while (got < n && pmm_mag_count)
+        out[got++] = pmm_mag[--pmm_mag_count];
+
+    /* 2. Tomar varios bits libres por palabra del bitmap en una pasada */
+    for (s = pmm_hint; got < n && s < pmm_low_summary; s++) {
+        while (got < n && pmm_summary[s]) {
+            uint32_t w    = s * 32 + bsf32(pmm_summary[s]);
+            uint32_t free = ~pmm_bitmap[w];
+            uint32_t take = 0;
+
+            while (got < n && free) {
+                uint32_t b = bsf32(free);
+                free &= free - 1;
+                take |= 1u << b;
+                out[got++] = (w * 32 + b) * PAGE_SIZE;
                 pmm_used++;
-                return BASE_ADDR + frame * PAGE_SIZE;
             }
+            pmm_bitmap[w] |= take;
+            if (pmm_bitmap[w] == 0xFFFFFFFF)
+                pmm_summary[s] &= ~(1u << (w % 32));
         }
+        if (pmm_summary[s]) break;   /* quedan libres aquí: no avanzar el cursor */
     }
-    return 0;   /* sin memoria */
+    if (s > pmm_hint) pmm_hint = s;
+
+    /* 3. Completar con frames sueltos de la zona buddy */
+    while (got < n) {
+        uint32_t addr = pmm_alloc_pages(0);
+        if (!addr) {
+            /* Todo o nada: devolver lo obtenido */
+            for (uint32_t i = 0; i < got; i++)
+                free_frame(out[i]);
+            return 0;
+        }
+        out[got++] = addr;
+    }
+
+    for (uint32_t i = 0; i < got; i++)
+        page_on_alloc(out[i]);
+    return got;
 }
 
-void pmm_free_frame(uint32_t addr)
+uint32_t pmm_alloc_batch(uint32_t n, uint32_t* out)
 {
-    if (addr < BASE_ADDR) return;
-    uint32_t frame = (addr - BASE_ADDR) / PAGE_SIZE;
-    if (frame >= MAX_FRAMES) return;
-    if (bitmap_test(frame)) {
-        bitmap_clear(frame);
-        pmm_used--;
+    uint32_t flags, got;
+
+    if (!out) return 0;
+    flags = irq_save();
+    got = alloc_batch(n, out);
+    irq_restore(flags);
+
+    /* Todo o nada: liberar al menos lo que falta antes de reintentar */
+    if (!got && n && swap_reclaim(n > SWAP_CLUSTER ? n : SWAP_CLUSTER)) {
+        flags = irq_save();
+        got = alloc_batch(n, out);
+        irq_restore(flags);
     }
+    return got;
+}
+
+void pmm_free_batch(uint32_t n, const uint32_t* frames)
+{
+    uint32_t flags;
+
+    if (!frames) return;
+    flags = irq_save();
+    for (uint32_t i = 0; i < n; i++)
+        free_frame(frames[i]);
+    irq_restore(flags);
 }
 
-uint32_t pmm_free_frames(void) { return pmm_total_frames - pmm_used; }
-uint32_t pmm_used_frames(void) { return pmm_used; }
+phys_addr_t pmm_alloc_user_frame(void)
+{
+    uint32_t flags = irq_save();
+    phys_addr_t addr = highmem_alloc();
+
+    if (!addr) addr = take_frame();
+    irq_restore(flags);
+
+    if (!addr && swap_reclaim(SWAP_CLUSTER)) {
+        flags = irq_save();
+        addr = highmem_alloc();
+        if (!addr) addr = take_frame();
+        irq_restore(flags);
+    }
+    if (addr) page_on_alloc(addr);
+    return addr;
+}
+
+uint32_t pmm_highmem_frames(void)
+{
+    return pmm_high_total;
+}
+
+uint32_t pmm_highmem_free(void)
+{
+    return pmm_high_total - pmm_high_used;
+}
+
+/* Los frames del magazine y del pool siguen marcados en el bitmap (y en
+ * pmm_used) aunque estén libres; ninguno de los dos guarda frames buddy */
+uint32_t pmm_free_frames(void)
+{
+    return (pmm_total_frames - pmm_used) + pmm_mag_count + pmm_zpool_count +
+           buddy_free_frames();
+}
+
+uint32_t pmm_used_frames(void)
+{
+    return (pmm_used - pmm_mag_count - pmm_zpool_count) +
+           (buddy_total_frames() - buddy_free_frames());
+}
+
+/* ── Pool de frames pre-zeroed ────────────────────────────────────────────── */
+
+uint32_t pmm_alloc_zeroed_frame(void)
+{
+    uint32_t flags = irq_save();
+    uint32_t addr  = 0;
+
+    if (pmm_zpool_count) {
+        addr = pmm_zpool[--pmm_zpool_count];
+        pmm_zstats.hits++;
+        page_on_alloc(addr);
+    } else {
+        pmm_zstats.misses++;
+    }
+    irq_restore(flags);
+
+    if (!addr) {
+        /* Camino lento, con interrupciones activas: pmm_alloc_frame puede
+         * llegar a swap_reclaim y a las escrituras PIO del disco */
+        addr = pmm_alloc_frame();
+        if (!addr) return 0;
+        zero_frame(addr);
+    }
+    page_set(addr, PG_ZEROED, 0);
+    return addr;
+}
+
+uint32_t pmm_zero_pool_refill(uint32_t max)
+{
+    uint32_t done = 0;
+
+    while (done < max) {
+        uint32_t flags = irq_save();
+        uint32_t addr  = 0;
+
+        /* Ni pmm_alloc_frame(), que podría mandar páginas de usuario al
+         * swap, ni la zona buddy: el pool solo guarda frames del bitmap,
+         * que siguen contados en pmm_used (ver pmm_used_frames) */
+        if (pmm_zpool_count < PMM_ZERO_POOL_SIZE)
+            addr = take_bitmap_frame();
+        irq_restore(flags);
+        if (!addr) break;
+
+        /* El frame es nuestro: ponerlo a cero con interrupciones activas */
+        zero_frame(addr);
+
+        flags = irq_save();
+        if (pmm_zpool_count < PMM_ZERO_POOL_SIZE) {
+            pmm_zpool[pmm_zpool_count++] = addr;
+            page_on_free(addr);     /* en el pool cuenta como libre */
+            pmm_zstats.zeroed++;
+            done++;
+        } else {
+            free_frame(addr);   /* alguien llenó el pool mientras tanto */
+        }
+        irq_restore(flags);
+    }
+    return done;
+}
+
+phys_addr_t pmm_alloc_zeroed_user_frame(void)
+{
+    phys_addr_t addr;
+
+    /* Sin memoria alta, el pool de frames pre-zeroed es lo mejor */
+    if (pmm_high_total == pmm_high_used)
+        return pmm_alloc_zeroed_frame();
+
+    addr = pmm_alloc_user_frame();
+    if (!addr) return 0;
+    zero_frame(addr);
+    page_set(addr, PG_ZEROED, 0);
+    return addr;
+}
+
+void pmm_get_zero_stats(pmm_zero_stats_t* out)
+{
+    if (!out) return;
+    *out = pmm_zstats;
+    out->pooled = pmm_zpool_count;
+}
@@ -5,35 +5,125 @@
  * Un bit = 1 frame de 4096 bytes.
  * Bit 0 = frame libre, Bit 1 = frame usado.
  *
- * Layout de memoria física:
- *   0x00000 - 0x0FFFF  → Reservado (BIOS, IVT, VGA text)
- *   0x10000 - 0x9FFFF  → Reservado (EBDA, ROM)
- *   0xA0000 - 0xBFFFF  → VGA framebuffer — NO tocar
- *   0x100000- 0x1FFFFF → Kernel image (cargado por GRUB)
- *   0x200000- ...      → Frames libres para procesos y heap
+ * La RAM disponible sale del mapa de memoria de multiboot (E820).
+ * Layout típico de memoria física:
+ *   0x00000 - 0x9FFFF  → Reservado (IVT, BIOS data, EBDA) — nunca libre
+ *   0xA0000 - 0xFFFFF  → VGA framebuffer + ROMs — NO tocar
+ *   0x100000- _image_end → Kernel image (cargado por GRUB) — reservado
+ *   resto de RAM tipo 1 → Frames libres (bitmap + zona buddy); el heap
+ *                         del kernel (kmalloc) toma de aquí sus slabs
  */
 #ifndef _PMM_H
 #define _PMM_H
 
 #include <types.h>
+#include <multiboot.h>
 
 #define PAGE_SIZE       4096
 #define PAGE_ALIGN(a)   (((a) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
 
-/* Rango de frames libres (fisica) — empieza en 8MB para no pisar kernel */
-#define PMM_FREE_START  0x00800000   /* 8 MB */
-#define PMM_FREE_END    0x04000000   /* 64 MB — ajustar segun RAM real */
+/* Memoria física que el kernel puede leer/escribir directamente (identity
+ * map de vmm_init). Las estructuras del PMM y la zona buddy viven debajo.
+ * pmm_alloc_frame() entrega siempre el frame libre más bajo, así que los
+ * frames por encima solo se usan cuando la memoria baja se agotó. */
+#define PMM_DIRECT_LIMIT  0x08000000   /* 128 MB */
 
-/* Inicializar el PMM con los datos de memoria de multiboot */
-void pmm_init(uint32_t mem_upper_kb);
+/* Con PAE el PMM también toma la RAM sobre 4GB, hasta este frame (16GB:
+ * el array de page_t de todo eso tiene que caber bajo PMM_DIRECT_LIMIT).
+ * Esos frames solo los entregan las funciones *_user_frame. */
+#define PMM_MAX_PFN       0x00400000
 
-/* Allocar un frame fisico — retorna direccion fisica o 0 si no hay */
+/* Frames recién liberados que se reciclan antes de volver al bitmap */
+#define PMM_MAGAZINE_SIZE 32
+
+/* Frames pre-zeroed que mantiene el idle (PMM_ZERO_REFILL por pasada) */
+#define PMM_ZERO_POOL_SIZE 64
+#define PMM_ZERO_REFILL    8
+
+/* Zona buddy para bloques contiguos: se reserva del bitmap en pmm_init().
+ * Bloques de 2^order frames, order 0..PMM_MAX_ORDER (4KB..4MB). */
+#define PMM_MAX_ORDER        10
+#define PMM_BUDDY_ZONE_SIZE  0x00800000   /* 8 MB, alineada a 4MB */
+
+/* Orden de un bloque de 'bytes' bytes (redondeando hacia arriba) */
+#define PMM_ORDER_FOR(bytes) \
+    ((bytes) <= 0x1000 ? 0 : (bytes) <= 0x2000 ? 1 : (bytes) <= 0x4000 ? 2 : \
+     (bytes) <= 0x8000 ? 3 : (bytes) <= 0x10000 ? 4 : (bytes) <= 0x20000 ? 5 : \
+     (bytes) <= 0x40000 ? 6 : (bytes) <= 0x80000 ? 7 : (bytes) <= 0x100000 ? 8 : \
+     (bytes) <= 0x200000 ? 9 : 10)
+
+/* Estadísticas del buddy, por orden */
+typedef struct {
+    uint32_t free_blocks[PMM_MAX_ORDER + 1];  /* bloques en cada lista libre */
+    uint32_t allocs[PMM_MAX_ORDER + 1];
+    uint32_t frees[PMM_MAX_ORDER + 1];
+    uint32_t failures[PMM_MAX_ORDER + 1];     /* pedidos sin bloque disponible */
+    uint32_t splits;
+    uint32_t merges;
+} pmm_buddy_stats_t;
+
+/* Inicializar el PMM con la RAM y los rangos reservados de memblock
+ * (memblock_init() primero). Retira memblock al terminar. */
+void pmm_init(void);
+
+/* Devolver al PMM frames que quedaron reservados en el arranque y ya no
+ * se usan (las secciones .init del kernel). Retorna cuántos liberó. */
+uint32_t pmm_release_range(uint32_t start, uint32_t end);
+
+/* Allocar un frame fisico — retorna direccion fisica o 0 si no hay
+ * (con swap activo, antes de fallar desaloja páginas de usuario) */
 uint32_t pmm_alloc_frame(void);
 
-/* Liberar un frame fisico */
-void pmm_free_frame(uint32_t addr);
+/* Liberar un frame fisico (de cualquier allocator de frames sueltos) */
+void pmm_free_frame(phys_addr_t addr);
+
+/* Frame para una página de usuario: primero memoria alta (solo se
+ * accede por vmm_kmap), después como pmm_alloc_frame(). 0 = sin memoria */
+phys_addr_t pmm_alloc_user_frame(void);
+
+/* Igual, lleno de ceros (sin memoria alta libre sale del pool) */
+phys_addr_t pmm_alloc_zeroed_user_frame(void);
+
+/* Frames sobre 4GB que gestiona el PMM (0 sin PAE) y cuántos quedan libres */
+uint32_t pmm_highmem_frames(void);
+uint32_t pmm_highmem_free(void);
+
+/* Allocar n frames (no contiguos) en una sola pasada: primero del magazine,
+ * luego varios bits por palabra del bitmap. Todo o nada: retorna n y
+ * llena out[0..n-1], o retorna 0 sin allocar nada. */
+uint32_t pmm_alloc_batch(uint32_t n, uint32_t* out);
+
+/* Liberar n frames (de pmm_alloc_frame o pmm_alloc_batch) */
+void pmm_free_batch(uint32_t n, const uint32_t* frames);
+
+/* Contadores del pool de frames pre-zeroed */
+typedef struct {
+    uint32_t hits;      /* pmm_alloc_zeroed_frame() servido desde el pool */
+    uint32_t misses;    /* pool vacío: se puso a cero en el momento */
+    uint32_t zeroed;    /* frames puestos a cero por el idle */
+    uint32_t pooled;    /* frames en el pool ahora mismo */
+} pmm_zero_stats_t;
+
+/* Allocar un frame lleno de ceros (del pool si hay). 0 = sin memoria */
+uint32_t pmm_alloc_zeroed_frame(void);
+
+/* Poner a cero hasta max frames y guardarlos en el pool. Lo llama el
+ * thread idle antes de hlt. Retorna cuántos frames agregó. */
+uint32_t pmm_zero_pool_refill(uint32_t max);
+
+void pmm_get_zero_stats(pmm_zero_stats_t* out);
+
+/* Allocar 2^order frames fisicamente contiguos y alineados a su tamaño.
+ * Retorna la direccion fisica del primer frame o 0 si no hay bloque. */
+uint32_t pmm_alloc_pages(uint32_t order);
+
+/* Liberar un bloque obtenido con pmm_alloc_pages (mismo order) */
+void pmm_free_pages(uint32_t addr, uint32_t order);
+
+/* Copiar las estadisticas del buddy */
+void pmm_get_buddy_stats(pmm_buddy_stats_t* out);
 
-/* Estadisticas */
+/* Estadisticas (memoria bajo 4GB; la alta va aparte) */
 uint32_t pmm_free_frames(void);
 uint32_t pmm_used_frames(void);
 
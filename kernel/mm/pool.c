@@ -0,0 +1,158 @@
+/*
+ * pool.c — Pool del kernel con tags (ver pool.h)
+ *
+ * Cada bloque lleva delante una cabecera de 8 bytes {tag, size}, como el
+ * POOL_HEADER de NT: ExFreePool() no necesita que le digan el tamaño ni
+ * el tag. Los bloques quedan alineados a 8.
+ *
+ * La tabla de tags es un array fijo que se busca en lineal; solo se toca
+ * con interrupciones desactivadas. Un tag que ya no cabe se contabiliza
+ * en el último slot.
+ */
+#include "pool.h"
+#include <hal.h>
+#include <kstdlib.h>
+#include <types.h>
+
+extern void serial_puts(const char*);
+extern void serial_print_dec(uint32_t v);
+
+typedef struct {
+    uint32_t tag;
+    uint32_t size;          /* bytes pedidos, sin la cabecera */
+} pool_header_t;
+
+#define POOL_TAG_OTHER  POOL_TAG('?', '?', '?', '?')
+
+static pool_tag_stats_t g_tags[POOL_MAX_TAGS];
+static uint32_t         g_tag_count;
+
+/* ── Helpers ──────────────────────────────────────────────────────────── */
+
+/* Entrada de tag, creándola si hace falta. Con interrupciones off. */
+static pool_tag_stats_t* tag_entry(uint32_t tag)
+{
+    pool_tag_stats_t* e;
+
+    for (uint32_t i = 0; i < g_tag_count; i++) {
+        if (g_tags[i].tag == tag) return &g_tags[i];
+    }
+    if (g_tag_count < POOL_MAX_TAGS - 1) {
+        e = &g_tags[g_tag_count++];
+    } else {
+        /* tabla llena: todo lo demás va al último slot */
+        e = &g_tags[POOL_MAX_TAGS - 1];
+        if (e->tag == POOL_TAG_OTHER) return e;
+        g_tag_count = POOL_MAX_TAGS;
+        tag = POOL_TAG_OTHER;
+    }
+    e->tag = tag;
+    e->bytes = e->peak_bytes = 0;
+    e->allocs = e->frees = e->failures = 0;
+    return e;
+}
+
+static void serial_put_tag(uint32_t tag)
+{
+    char s[5];
+    for (int i = 0; i < 4; i++) {
+        char c = (char)(tag >> (i * 8));
+        s[i] = (c >= 0x20 && c < 0x7F) ? c : '.';
+    }
+    s[4] = '\0';
+    serial_puts(s);
+}
+
+/* ── API pública ──────────────────────────────────────────────────────── */
+
+void* ExAllocatePoolWithTag(size_t size, uint32_t tag)
+{
+    pool_header_t* h = NULL;
+    pool_tag_stats_t* e;
+    uint32_t flags;
+
+    if (size && size <= 0xFFFFFFFF - sizeof(pool_header_t))
+        h = (pool_header_t*)kmalloc(size + sizeof(pool_header_t));
+
+    flags = irq_save();
+    e = tag_entry(tag);
+    if (!h) {
+        e->failures++;
+        irq_restore(flags);
+        return NULL;
+    }
+    h->tag  = tag;
+    h->size = size;
+    e->allocs++;
+    e->bytes += size;
+    if (e->bytes > e->peak_bytes) e->peak_bytes = e->bytes;
+    irq_restore(flags);
+    return h + 1;
+}
+
+void ExFreePoolWithTag(void* ptr, uint32_t tag)
+{
+    pool_header_t* h;
+    pool_tag_stats_t* e;
+    uint32_t flags;
+
+    if (!ptr) return;
+    h = (pool_header_t*)ptr - 1;
+
+    if (tag && h->tag != tag) {
+        serial_puts("[pool] free con tag ");
+        serial_put_tag(tag);
+        serial_puts(" de un bloque ");
+        serial_put_tag(h->tag);
+        serial_puts("\r\n");
+    }
+
+    flags = irq_save();
+    e = tag_entry(h->tag);
+    e->frees++;
+    e->bytes -= h->size;
+    irq_restore(flags);
+
+    kfree(h);
+}
+
+void ExFreePool(void* ptr)
+{
+    ExFreePoolWithTag(ptr, 0);
+}
+
+uint32_t pool_get_stats(pool_tag_stats_t* out, uint32_t max)
+{
+    uint32_t flags, n;
+
+    if (!out) return 0;
+    flags = irq_save();
+    n = g_tag_count < max ? g_tag_count : max;
+    for (uint32_t i = 0; i < n; i++)
+        out[i] = g_tags[i];
+    irq_restore(flags);
+    return n;
+}
+
+void pool_dump_serial(void)
+{
+    static pool_tag_stats_t snap[POOL_MAX_TAGS];
+    uint32_t n = pool_get_stats(snap, POOL_MAX_TAGS);
+
+    serial_puts("[pool] tag  allocs frees bytes pico fallos\r\n");
+    for (uint32_t i = 0; i < n; i++) {
+        serial_puts("[pool] ");
+        serial_put_tag(snap[i].tag);
+        serial_puts(" ");
+        serial_print_dec(snap[i].allocs);
+        serial_puts(" ");
+        serial_print_dec(snap[i].frees);
+        serial_puts(" ");
+        serial_print_dec(snap[i].bytes);
+        serial_puts(" ");
+        serial_print_dec(snap[i].peak_bytes);
+        serial_puts(" ");
+        serial_print_dec(snap[i].failures);
+        serial_puts("\r\n");
+    }
+}
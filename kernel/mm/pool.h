@@ -0,0 +1,48 @@
+/*
+ * pool.h — Pool del kernel con tags (estilo NT)
+ *
+ * ExAllocatePoolWithTag() es kmalloc() con una cabecera que guarda el
+ * tamaño pedido y un tag de 4 caracteres del subsistema que pide. Por
+ * cada tag se lleva la cuenta de bytes vivos, allocs, frees, pico y
+ * fallos: con eso se ve quién se come el heap, como poolmon en Windows
+ * (comando `pool` de la consola de la GUI, o pool_dump_serial()).
+ *
+ * A diferencia de NT no hay tipos de pool (paged/nonpaged): todo el heap
+ * del kernel es residente.
+ */
+#ifndef _POOL_H
+#define _POOL_H
+
+#include <types.h>
+
+#define POOL_MAX_TAGS   48      /* tags distintos; el último slot es "????" */
+
+/* Tag de 4 caracteres que se lee en orden en un volcado de memoria */
+#define POOL_TAG(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+typedef struct {
+    uint32_t tag;
+    uint32_t bytes;         /* bytes pedidos y no liberados */
+    uint32_t peak_bytes;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;      /* kmalloc devolvió NULL */
+} pool_tag_stats_t;
+
+/* size bytes del heap a cuenta de tag. NULL si no hay memoria. */
+void* ExAllocatePoolWithTag(size_t size, uint32_t tag);
+
+/* Liberar un bloque del pool; un tag distinto al de la reserva se
+ * avisa por serial y el bloque se libera igual (NULL se ignora) */
+void ExFreePoolWithTag(void* ptr, uint32_t tag);
+void ExFreePool(void* ptr);
+
+/* Copiar hasta max tags en uso a out, por orden de aparición.
+ * Retorna cuántos se copiaron. */
+uint32_t pool_get_stats(pool_tag_stats_t* out, uint32_t max);
+
+/* Tabla completa por serial, una línea por tag */
+void pool_dump_serial(void);
+
+#endif /* _POOL_H */
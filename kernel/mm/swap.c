@@ -0,0 +1,293 @@
+/*
+ * swap.c — Reclaim de páginas de usuario y swap en disco (ver swap.h)
+ *
+ * El mapa de swap es un byte por página del disco (vmalloc en
+ * swap_init): referencias al slot, 0 = libre. La página 0 es la cabecera
+ * de mkswap y nunca se asigna, así que un slot válido nunca es 0. Los
+ * slots se buscan a partir del último asignado (next-fit) para que las
+ * escrituras de una misma pasada queden seguidas en el disco.
+ *
+ * El reloj no tiene lista de páginas propia: la manecilla es un proceso
+ * de la tabla de procesos y una dirección dentro de sus VMAs, y avanza
+ * leyendo las page tables (vmm_get_pte). Una página con PTE_ACCESSED se
+ * salva una vuelta y pierde el bit; la siguiente vez que la manecilla
+ * pase sin que la CPU lo haya vuelto a poner, se desaloja.
+ *
+ * Todo corre con interrupciones desactivadas (el disco se usa por
+ * polling): el reclaim puede llegar desde cualquier pmm_alloc_frame() y
+ * el #PF ya corre así.
+ */
+#include "swap.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "vma.h"
+#include "page.h"
+#include "vmalloc.h"
+#include "../proc/process.h"
+#include "../../drivers/storage/ata.h"
+#include <hal.h>
+#include <kstdlib.h>
+#include <types.h>
+
+extern void serial_puts(const char*);
+extern void serial_print_dec(uint32_t v);
+
+/* Firma de mkswap al final de la página 0 */
+#define SWAP_MAGIC      "SWAPSPACE2"
+#define SWAP_MAGIC_LEN  10
+
+static uint8_t*     g_swap_map  = NULL;   /* referencias por slot */
+static uint32_t     g_swap_end  = 0;      /* slots válidos: 1 .. g_swap_end-1 */
+static uint32_t     g_swap_hint = 1;      /* próximo slot a probar */
+static ULONG        g_swap_drive;
+static int          g_reclaiming = 0;
+static swap_stats_t g_swap_stats;
+
+/* Manecilla del reloj: índice en la tabla de procesos y dirección */
+static uint32_t g_hand_proc = 0;
+static uint32_t g_hand_addr = 0;
+
+/* ── Slots ────────────────────────────────────────────────────────────── */
+
+static uint32_t slot_alloc(void)
+{
+    for (uint32_t n = 1; n < g_swap_end; n++) {
+        uint32_t s = g_swap_hint;
+        if (++g_swap_hint >= g_swap_end) g_swap_hint = 1;
+        if (!g_swap_map[s]) {
+            g_swap_map[s] = 1;
+            g_swap_stats.used++;
+            return s;
+        }
+    }
+    return 0;   /* swap lleno */
+}
+
+static void slot_put(uint32_t slot)
+{
+    if (!slot || slot >= g_swap_end || !g_swap_map[slot]) return;
+    if (--g_swap_map[slot] == 0)
+        g_swap_stats.used--;
+}
+
+/* Leer o escribir la página del slot desde/hacia un frame */
+static int page_io(uint32_t slot, phys_addr_t frame, int write)
+{
+    void* p = vmm_kmap(frame);
+    NTSTATUS st;
+
+    if (!p) return 0;
+    if (write)
+        st = AtaWriteSectors(g_swap_drive, slot * SWAP_SECTORS_PER_PAGE,
+                             SWAP_SECTORS_PER_PAGE, p);
+    else
+        st = AtaReadSectors(g_swap_drive, slot * SWAP_SECTORS_PER_PAGE,
+                            SWAP_SECTORS_PER_PAGE, p);
+    vmm_kunmap(p);
+    if (!NT_SUCCESS(st)) {
+        g_swap_stats.io_errors++;
+        return 0;
+    }
+    return 1;
+}
+
+/* ── Reloj ────────────────────────────────────────────────────────────── */
+
+static int swappable(process_t* p)
+{
+    return p && p->active && p->privilege == PRIVILEGE_USER &&
+           p->page_dir && p->page_dir != vmm_get_kernel_directory();
+}
+
+/* Primera VMA de p que termina después de addr */
+static vma_t* next_vma(process_t* p, uint32_t addr)
+{
+    for (uint32_t i = 0; i < p->vm.count; i++) {
+        if (p->vm.area[i].end > addr) return &p->vm.area[i];
+    }
+    return NULL;
+}
+
+/* Desalojar la página va de p si es candidata. Retorna 1 si liberó su frame */
+static int try_evict(process_t* p, uint32_t va)
+{
+    pte_t pte = vmm_get_pte(p->page_dir, va);
+    phys_addr_t frame = PTE_ADDR(pte);
+    uint32_t slot;
+    page_t* pg;
+
+    if (!(pte & PTE_PRESENT) || !(pte & PTE_USER)) return 0;
+
+    /* Solo anónimas con una única referencia (no COW compartidas) */
+    pg = page_of(frame);
+    if (!pg || pg->refcount != 1 || !(pg->flags & PG_USER) ||
+        (pg->flags & PG_PINNED))
+        return 0;
+
+    /* Usada desde la última vuelta: segunda oportunidad */
+    if (pte & PTE_ACCESSED) {
+        vmm_update_pte(p->page_dir, va, PTE_ACCESSED, 0);
+        g_swap_stats.referenced++;
+        return 0;
+    }
+
+    slot = slot_alloc();
+    if (!slot) return 0;
+    if (!page_io(slot, frame, 1)) {
+        slot_put(slot);
+        return 0;
+    }
+    vmm_update_pte(p->page_dir, va, VMM_PTE_ALL, SWAP_ENTRY(slot));
+    page_put(frame);
+    if (p->vm.resident) p->vm.resident--;
+    p->vm.swapped++;
+    g_swap_stats.pages_out++;
+    return 1;
+}
+
+/* ── API pública ──────────────────────────────────────────────────────── */
+
+uint32_t swap_init(void)
+{
+    uint32_t frame, pages = 0;
+    ULONG drive;
+
+    if (!NT_SUCCESS(AtaInitialize())) {
+        serial_puts("[swap] sin discos ATA\r\n");
+        return 0;
+    }
+
+    /* La cabecera se lee en un frame cualquiera, por la ventana kmap */
+    frame = pmm_alloc_frame();
+    if (!frame) return 0;
+    for (drive = 0; drive < ATA_MAX_DRIVES; drive++) {
+        ULONG sectors = AtaGetSectorCount(drive);
+        char* hdr;
+        int ok;
+
+        if (sectors < 2 * SWAP_SECTORS_PER_PAGE) continue;
+        hdr = (char*)vmm_kmap(frame);
+        if (!hdr) break;
+        ok = NT_SUCCESS(AtaReadSectors(drive, 0, SWAP_SECTORS_PER_PAGE, hdr)) &&
+             memcmp(hdr + PAGE_SIZE - SWAP_MAGIC_LEN, SWAP_MAGIC,
+                    SWAP_MAGIC_LEN) == 0;
+        vmm_kunmap(hdr);
+        if (ok) {
+            pages = sectors / SWAP_SECTORS_PER_PAGE;
+            break;
+        }
+    }
+    pmm_free_frame(frame);
+    if (!pages) {
+        serial_puts("[swap] ningun disco con firma " SWAP_MAGIC "\r\n");
+        return 0;
+    }
+
+    if (pages > SWAP_MAX_SLOTS + 1) pages = SWAP_MAX_SLOTS + 1;
+    g_swap_map = (uint8_t*)vmalloc(pages);
+    if (!g_swap_map) return 0;
+    memset(g_swap_map, 0, pages);
+
+    g_swap_drive       = drive;
+    g_swap_end         = pages;
+    g_swap_stats.slots = pages - 1;
+
+    serial_puts("[swap] disco ATA ");
+    serial_print_dec(drive);
+    serial_puts(": ");
+    serial_print_dec((pages - 1) * (PAGE_SIZE / 1024));
+    serial_puts(" KB\r\n");
+    return (pages - 1) * (PAGE_SIZE / 1024);
+}
+
+int swap_active(void)
+{
+    return g_swap_end != 0;
+}
+
+uint32_t swap_reclaim(uint32_t want)
+{
+    process_t** table;
+    uint32_t freed = 0, budget = SWAP_SCAN_BUDGET, skipped = 0, flags;
+
+    if (!g_swap_end || g_reclaiming || !want) return 0;
+
+    flags = irq_save();
+    g_reclaiming = 1;
+    g_swap_stats.reclaims++;
+    table = proc_get_process_table();
+
+    while (freed < want && budget) {
+        process_t* p = table[g_hand_proc];
+        vma_t* r = swappable(p) ? next_vma(p, g_hand_addr) : NULL;
+        uint32_t va;
+
+        if (!r) {
+            /* Fin del espacio de este proceso: pasar al siguiente. Una
+             * vuelta entera sin nada que mirar = no hay usuarios */
+            g_hand_proc = (g_hand_proc + 1) % MAX_PROCESSES;
+            g_hand_addr = 0;
+            if (++skipped > MAX_PROCESSES) break;
+            continue;
+        }
+        skipped = 0;
+
+        va = g_hand_addr > r->start ? g_hand_addr : r->start;
+        for (; va < r->end && freed < want && budget; va += PAGE_SIZE) {
+            budget--;
+            g_swap_stats.scanned++;
+            freed += try_evict(p, va);
+        }
+        g_hand_addr = va;
+    }
+
+    g_reclaiming = 0;
+    irq_restore(flags);
+    return freed;
+}
+
+int swap_in(page_directory_t* dir, uint32_t virt, pte_t pte,
+            uint32_t pte_flags, uint32_t owner)
+{
+    uint32_t slot = SWAP_SLOT(pte);
+    phys_addr_t frame;
+
+    if (!(pte & PTE_SWAP) || !slot || slot >= g_swap_end || !g_swap_map[slot])
+        return 0;
+
+    /* Un reclaim dentro de esta allocación no toca el PTE: no está presente */
+    frame = pmm_alloc_user_frame();
+    if (!frame) return 0;
+    if (!page_io(slot, frame, 0)) {
+        pmm_free_frame(frame);
+        return 0;
+    }
+    page_set(frame, PG_USER, owner);
+
+    /* La tabla ya existe (guarda la entrada de swap) */
+    vmm_map_page(dir, virt & ~(PAGE_SIZE - 1), frame, pte_flags);
+    slot_put(slot);
+    g_swap_stats.pages_in++;
+    return 1;
+}
+
+void swap_dup(pte_t pte)
+{
+    uint32_t slot = SWAP_SLOT(pte);
+    if (!(pte & PTE_SWAP) || !slot || slot >= g_swap_end) return;
+    /* MAX_PROCESSES referencias como mucho: el byte no desborda */
+    if (g_swap_map[slot] && g_swap_map[slot] < 0xFF)
+        g_swap_map[slot]++;
+}
+
+void swap_free_entry(pte_t pte)
+{
+    if (!(pte & PTE_SWAP)) return;
+    slot_put(SWAP_SLOT(pte));
+}
+
+void swap_get_stats(swap_stats_t* out)
+{
+    if (!out) return;
+    *out = g_swap_stats;
+}
@@ -0,0 +1,82 @@
+/*
+ * swap.h — Reclaim de páginas de usuario y swap en disco
+ *
+ * Cuando el PMM se queda sin frames, swap_reclaim() recorre con un reloj
+ * (clock / second chance) las páginas anónimas de los procesos de usuario
+ * (las que están dentro de una VMA), escribe al área de swap las que no
+ * se usaron desde la última vuelta y libera sus frames. El PTE queda no
+ * presente con PTE_SWAP y el número de slot; el #PF la vuelve a leer
+ * (fallo "mayor", ver fault.c).
+ *
+ * El área de swap es un disco ATA entero (drivers/storage/ata.c) cuya
+ * primera página lleva la firma de mkswap ("SWAPSPACE2" al final de los
+ * primeros 4KB); esa página no se usa. Con QEMU:
+ *   ./run.sh -w 64      (crea swap.img de 64 MB en el primario esclavo)
+ * Sin disco de swap todo esto queda inactivo y pmm_alloc_frame() falla
+ * como antes cuando no hay memoria.
+ *
+ * Solo se desalojan frames con una única referencia (los compartidos por
+ * un fork en COW se quedan en RAM); un slot sí puede compartirse: el fork
+ * de un proceso con páginas en swap toma una referencia más (swap_dup).
+ */
+#ifndef _SWAP_H
+#define _SWAP_H
+
+#include <types.h>
+#include "vmm.h"
+
+/* ── Entradas de swap en un PTE no presente ─────────────────────────────── */
+#define SWAP_ENTRY(slot)    (((uint32_t)(slot) << 12) | PTE_SWAP)
+#define SWAP_SLOT(pte)      ((uint32_t)(pte) >> 12)
+
+#define SWAP_SECTORS_PER_PAGE  (PAGE_SIZE / 512)
+#define SWAP_MAX_SLOTS         65536     /* 256 MB de swap como máximo */
+
+/* Frames que intenta liberar cada pasada de reclaim */
+#define SWAP_CLUSTER           32
+
+/* PTEs que una pasada mira como mucho (dos vueltas de reloj para ~8 MB
+ * de páginas de usuario residentes) */
+#define SWAP_SCAN_BUDGET       4096
+
+typedef struct {
+    uint32_t slots;         /* slots utilizables del área (0 = sin swap) */
+    uint32_t used;          /* slots ocupados */
+    uint32_t pages_out;     /* páginas escritas al disco */
+    uint32_t pages_in;      /* páginas leídas del disco (fallos mayores) */
+    uint32_t reclaims;      /* pasadas de swap_reclaim() */
+    uint32_t scanned;       /* PTEs mirados por el reloj */
+    uint32_t referenced;    /* páginas salvadas por el bit Accessed */
+    uint32_t io_errors;
+} swap_stats_t;
+
+/* Buscar el disco de swap (AtaInitialize + firma). Después de vmm_init()
+ * y proc_init(). Retorna los KB de swap disponibles, 0 si no hay. */
+uint32_t swap_init(void);
+
+/* ¿Hay área de swap activa? */
+int swap_active(void);
+
+/*
+ * Liberar hasta want frames desalojando páginas de usuario al swap.
+ * Lo llama el PMM cuando se queda sin frames; no reentra (una llamada
+ * anidada retorna 0). Retorna los frames liberados.
+ */
+uint32_t swap_reclaim(uint32_t want);
+
+/*
+ * Traer de vuelta la página virt de dir, cuyo PTE es la entrada de swap
+ * pte, con los permisos pte_flags y owner como dueño. Retorna 1 si quedó
+ * mapeada o 0 sin memoria / error de disco.
+ */
+int swap_in(page_directory_t* dir, uint32_t virt, pte_t pte,
+            uint32_t pte_flags, uint32_t owner);
+
+/* Una referencia más / menos sobre el slot de una entrada de swap (fork y
+ * desmapeo). El slot queda libre al soltar la última. */
+void swap_dup(pte_t pte);
+void swap_free_entry(pte_t pte);
+
+void swap_get_stats(swap_stats_t* out);
+
+#endif /* _SWAP_H */
@@ -0,0 +1,141 @@
+/*
+ * uaccess.c — Copias entre kernel y memoria de usuario (ver uaccess.h)
+ *
+ * La validación es por página, no por byte: un vmm_get_pte() por cada
+ * página del rango. Aun así la página puede desaparecer o no poder
+ * asignarse entre la validación y la copia (sin memoria para un #PF de
+ * demanda o un COW); por eso las instrucciones de copia llevan entrada
+ * en __ex_table y page_fault_handler() continúa en su fixup.
+ */
+#include "uaccess.h"
+#include "vmm.h"
+#include "vma.h"
+#include "pmm.h"
+#include "../proc/process.h"
+#include <types.h>
+
+/* Límites de la tabla (linker.ld) */
+extern const exception_entry_t __start___ex_table[];
+extern const exception_entry_t __stop___ex_table[];
+
+/* ── Validación ───────────────────────────────────────────────────────── */
+
+int user_access_ok(const void* p, uint32_t len, int write)
+{
+    uint32_t start = (uint32_t)p, end = start + len, va, cr3;
+    process_t* proc = proc_current_process();
+    page_directory_t* dir;
+
+    if (!len) return 1;
+    if (end < start || end > USER_SPACE_END) return 0;
+
+    __asm__ volatile("mov %%cr3, %0" : "=r"(cr3));
+    dir = (page_directory_t*)(cr3 & ~0xFFF);
+
+    for (va = start & ~(PAGE_SIZE - 1); va < end; va += PAGE_SIZE) {
+        pte_t pte = vmm_get_pte(dir, va);
+        vma_t* v;
+
+        if (pte & PTE_PRESENT) {
+            /* las páginas COW se pueden escribir: el #PF las copia */
+            if (!(pte & PTE_USER)) return 0;
+            if (write && !(pte & (PTE_WRITABLE | PTE_COW))) return 0;
+            continue;
+        }
+        /* aún sin frame pero dentro de una VMA: el acceso del kernel
+         * provocará un #PF que la mapea */
+        v = proc ? vma_find(&proc->vm, va) : NULL;
+        if (!v || (write && !(v->pte_flags & PTE_WRITABLE))) return 0;
+    }
+    return 1;
+}
+
+/* ── Copias protegidas por __ex_table ─────────────────────────────────── */
+
+/* rep movsb; si falla, ECX conserva los bytes que faltaban. Retorna 0 o
+ * los bytes sin copiar. */
+static inline uint32_t copy_user_raw(void* dst, const void* src, uint32_t n)
+{
+    __asm__ volatile(
+        "1: rep movsb\n"
+        "2:\n"
+        ".section __ex_table, \"a\"\n"
+        "   .align 4\n"
+        "   .long 1b, 2b\n"
+        ".previous\n"
+        : "+D"(dst), "+S"(src), "+c"(n)
+        :
+        : "memory");
+    return n;
+}
+
+int copy_from_user(void* dst, const void* usrc, uint32_t len)
+{
+    if (!user_access_ok(usrc, len, 0)) return -EFAULT;
+    return copy_user_raw(dst, usrc, len) ? -EFAULT : 0;
+}
+
+int copy_to_user(void* udst, const void* src, uint32_t len)
+{
+    if (!user_access_ok(udst, len, 1)) return -EFAULT;
+    return copy_user_raw(udst, src, len) ? -EFAULT : 0;
+}
+
+int strncpy_from_user(char* dst, const char* usrc, uint32_t n)
+{
+    uint32_t left = n, first;
+    int err;
+
+    if (!n) return 0;
+    /* Validar solo la primera página: la cadena puede terminar antes del
+     * final del rango; las siguientes se comprueban al cruzarlas */
+    first = PAGE_SIZE - ((uint32_t)usrc & (PAGE_SIZE - 1));
+    if (first > n) first = n;
+    if (!user_access_ok(usrc, first, 0)) return -EFAULT;
+
+    while (left) {
+        uint32_t chunk = PAGE_SIZE - ((uint32_t)usrc & (PAGE_SIZE - 1));
+        uint32_t before;
+        if (chunk > left) chunk = left;
+        if (left != n && !user_access_ok(usrc, chunk, 0)) return -EFAULT;
+
+        /* lodsb/stosb hasta el '\0' o el fin del trozo */
+        before = chunk;
+        __asm__ volatile(
+            "   xorl %[err], %[err]\n"
+            "0: lodsb\n"
+            "   stosb\n"
+            "   testb %%al, %%al\n"
+            "   jz 2f\n"
+            "   decl %%ecx\n"
+            "   jnz 0b\n"
+            "   jmp 2f\n"
+            "1: movl %[efault], %[err]\n"
+            "2:\n"
+            ".section __ex_table, \"a\"\n"
+            "   .align 4\n"
+            "   .long 0b, 1b\n"
+            ".previous\n"
+            : [err] "=&r"(err), "+S"(usrc), "+D"(dst), "+c"(chunk)
+            : [efault] "i"(-EFAULT)
+            : "eax", "memory", "cc");
+        if (err) return err;
+        if (chunk) {
+            /* '\0' encontrado: chunk = bytes del trozo sin recorrer */
+            return (int)(n - left + (before - chunk));
+        }
+        left -= before;
+    }
+    return (int)n;
+}
+
+/* ── Búsqueda de fixups ───────────────────────────────────────────────── */
+
+uint32_t uaccess_fixup(uint32_t eip)
+{
+    const exception_entry_t* e;
+    for (e = __start___ex_table; e < __stop___ex_table; e++) {
+        if (e->insn == eip) return e->fixup;
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * uaccess.h — Acceso del kernel a memoria de usuario
+ *
+ * Las syscalls no desreferencian punteros de Ring 3 directamente: usan
+ * estas funciones, que validan el rango página a página (PTE_USER o
+ * dentro de una VMA) y copian con rep movsb. Cada instrucción que toca
+ * memoria de usuario tiene una entrada en la tabla de excepciones
+ * (__ex_table, ver linker.ld): si provoca un #PF que no se puede
+ * resolver, el manejador salta a su código de fixup y la función
+ * retorna -EFAULT en vez de detener el kernel.
+ */
+#ifndef _UACCESS_H
+#define _UACCESS_H
+
+#include <types.h>
+
+#define EFAULT  14   /* dirección de usuario inválida */
+
+/* Entrada de la tabla de excepciones: instrucción que puede fallar y
+ * dirección donde continuar si falla */
+typedef struct {
+    uint32_t insn;
+    uint32_t fixup;
+} exception_entry_t;
+
+/* ¿[p, p+len) es memoria de usuario accesible (escribible si write)? */
+int user_access_ok(const void* p, uint32_t len, int write);
+
+/* Copiar len bytes de usuario a kernel / de kernel a usuario.
+ * Retornan 0 o -EFAULT. */
+int copy_from_user(void* dst, const void* usrc, uint32_t len);
+int copy_to_user(void* udst, const void* src, uint32_t len);
+
+/*
+ * Copiar una cadena de usuario de como mucho n bytes (incluido el '\0').
+ * Retorna su longitud sin el '\0', n si no terminaba dentro de los n
+ * bytes (dst queda sin terminar) o -EFAULT.
+ */
+int strncpy_from_user(char* dst, const char* usrc, uint32_t n);
+
+/* Dirección de fixup para una instrucción que falló, o 0 si no tiene */
+uint32_t uaccess_fixup(uint32_t eip);
+
+#endif /* _UACCESS_H */
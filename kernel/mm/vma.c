@@ -0,0 +1,245 @@
+/*
+ * vma.c — Áreas de memoria virtual de un proceso (ver vma.h)
+ *
+ * La lista es un array fijo ordenado por dirección: con VMA_MAX = 16 un
+ * recorrido lineal es más barato que cualquier árbol, y copiarla en un
+ * fork es un memcpy del struct.
+ *
+ * Los frames de una VMA no se guardan aquí: se descubren por las page
+ * tables del proceso al desmapear (vmm_get_pte) y se sueltan con
+ * page_put(), de modo que los compartidos por un fork (COW) sobreviven
+ * mientras el otro proceso los tenga. Lo único que se lleva aquí es la
+ * cuenta de páginas residentes y en swap de vma_set_t, que suben en el
+ * #PF (fault.c) y el reclaim (swap.c) y bajan al soltarlas.
+ */
+#include "vma.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "page.h"
+#include "swap.h"
+#include <types.h>
+
+/* ── Helpers ──────────────────────────────────────────────────────────── */
+
+/* Soltar y desmapear las páginas ya presentes (o en swap) de [start, end) */
+static void release_pages(vma_set_t* vm, page_directory_t* dir,
+                          uint32_t start, uint32_t end)
+{
+    uint32_t va;
+
+    if (!dir || end <= start) return;
+    for (va = start; va < end; va += PAGE_SIZE) {
+        pte_t pte = vmm_get_pte(dir, va);
+        if ((pte & PTE_PRESENT) && (pte & PTE_USER)) {
+            page_put(PTE_ADDR(pte));
+            if (vm->resident) vm->resident--;
+        } else if (pte & PTE_SWAP) {
+            swap_free_entry(pte);
+            if (vm->swapped) vm->swapped--;
+        }
+    }
+    vmm_unmap_range(dir, start, end - start);
+}
+
+/* ¿Alguna VMA corta [start, end)? */
+static int overlaps(vma_set_t* vm, uint32_t start, uint32_t end)
+{
+    for (uint32_t i = 0; i < vm->count; i++) {
+        if (vm->area[i].start < end && start < vm->area[i].end)
+            return 1;
+    }
+    return 0;
+}
+
+static void delete_at(vma_set_t* vm, uint32_t i)
+{
+    for (; i + 1 < vm->count; i++)
+        vm->area[i] = vm->area[i + 1];
+    vm->count--;
+}
+
+/* Insertar a en la posición i (hay slot libre) */
+static void insert_at(vma_set_t* vm, uint32_t i, const vma_t* a)
+{
+    for (uint32_t j = vm->count; j > i; j--)
+        vm->area[j] = vm->area[j - 1];
+    vm->area[i] = *a;
+    vm->count++;
+}
+
+/* VMAs que quedan tras reemplazar [start, end) por una nueva: las
+ * cubiertas enteras desaparecen y una que lo contenga se parte en dos */
+static uint32_t slots_after_fixed(vma_set_t* vm, uint32_t start, uint32_t end)
+{
+    uint32_t n = vm->count + 1;
+
+    for (uint32_t i = 0; i < vm->count; i++) {
+        vma_t* a = &vm->area[i];
+        if (start <= a->start && end >= a->end)     n--;
+        else if (a->start < start && end < a->end)  n++;
+    }
+    return n;
+}
+
+/* ── API pública ──────────────────────────────────────────────────────── */
+
+void vma_init(vma_set_t* vm)
+{
+    if (!vm) return;
+    vm->count         = 0;
+    vm->brk_start     = USER_HEAP_BASE;
+    vm->brk           = USER_HEAP_BASE;
+    vm->resident      = 0;
+    vm->swapped       = 0;
+    vm->peak_resident = 0;
+}
+
+uint32_t vma_committed_pages(const vma_set_t* vm)
+{
+    uint32_t pages = 0;
+
+    if (!vm) return 0;
+    for (uint32_t i = 0; i < vm->count; i++)
+        pages += (vm->area[i].end - vm->area[i].start) / PAGE_SIZE;
+    return pages;
+}
+
+vma_t* vma_find(vma_set_t* vm, uint32_t addr)
+{
+    if (!vm) return NULL;
+    for (uint32_t i = 0; i < vm->count; i++) {
+        if (addr < vm->area[i].start) break;    /* ordenadas */
+        if (addr < vm->area[i].end) return &vm->area[i];
+    }
+    return NULL;
+}
+
+int vma_insert(vma_set_t* vm, uint32_t start, uint32_t size,
+               uint32_t pte_flags, uint32_t kind)
+{
+    vma_t a;
+    uint32_t end, i;
+
+    if (!vm || !size || vm->count >= VMA_MAX) return -1;
+    start &= ~(PAGE_SIZE - 1);
+    end = PAGE_ALIGN(start + size);
+    /* Nada por debajo del identity map del kernel ni en su mitad alta */
+    if (start < PMM_DIRECT_LIMIT || end <= start || end > USER_SPACE_END)
+        return -1;
+    if (overlaps(vm, start, end)) return -1;
+
+    a.start     = start;
+    a.end       = end;
+    a.pte_flags = pte_flags | PTE_PRESENT | PTE_USER;
+    a.kind      = kind;
+    for (i = 0; i < vm->count && vm->area[i].start < start; i++)
+        ;
+    insert_at(vm, i, &a);
+    return 0;
+}
+
+int vma_remove(vma_set_t* vm, page_directory_t* dir,
+               uint32_t start, uint32_t size)
+{
+    uint32_t end, i = 0;
+
+    if (!vm || !size) return -1;
+    start &= ~(PAGE_SIZE - 1);
+    end = PAGE_ALIGN(start + size);
+    if (end <= start) return -1;
+
+    while (i < vm->count) {
+        vma_t* a = &vm->area[i];
+
+        if (a->end <= start) { i++; continue; }
+        if (a->start >= end) break;
+
+        if (start <= a->start && end >= a->end) {
+            /* Cubierta entera */
+            release_pages(vm, dir, a->start, a->end);
+            delete_at(vm, i);
+            continue;
+        }
+        if (start <= a->start) {
+            /* Recortar por abajo */
+            release_pages(vm, dir, a->start, end);
+            a->start = end;
+        } else if (end >= a->end) {
+            /* Recortar por arriba */
+            release_pages(vm, dir, start, a->end);
+            a->end = start;
+        } else {
+            /* Hueco en medio: la parte alta pasa a ser otra VMA */
+            vma_t hi = *a;
+            if (vm->count >= VMA_MAX) return -1;
+            release_pages(vm, dir, start, end);
+            hi.start = end;
+            a->end   = start;
+            insert_at(vm, i + 1, &hi);
+        }
+        i++;
+    }
+    return 0;
+}
+
+uint32_t vma_mmap(vma_set_t* vm, page_directory_t* dir, uint32_t addr,
+                  uint32_t size, uint32_t pte_flags, int fixed)
+{
+    uint32_t len = PAGE_ALIGN(size), cand;
+
+    if (!vm || !len) return 0;
+
+    if (fixed) {
+        /* Validar todo antes de vma_remove: si después fallara el insert,
+         * el llamador ya habría perdido sus páginas */
+        if (addr & (PAGE_SIZE - 1)) return 0;
+        if (addr < PMM_DIRECT_LIMIT || addr + len <= addr ||
+            addr + len > USER_SPACE_END)
+            return 0;
+        if (slots_after_fixed(vm, addr, addr + len) > VMA_MAX) return 0;
+        if (vma_remove(vm, dir, addr, len) != 0) return 0;
+        return vma_insert(vm, addr, len, pte_flags, VMA_ANON) == 0 ? addr : 0;
+    }
+
+    /* Primer hueco libre (first fit) */
+    cand = USER_MMAP_BASE;
+    for (uint32_t i = 0; i < vm->count; i++) {
+        vma_t* a = &vm->area[i];
+        if (a->end <= cand) continue;
+        if (a->start >= cand + len) break;
+        cand = a->end;
+    }
+    if (cand + len > USER_MMAP_TOP || cand + len < cand) return 0;
+    return vma_insert(vm, cand, len, pte_flags, VMA_ANON) == 0 ? cand : 0;
+}
+
+uint32_t vma_brk(vma_set_t* vm, page_directory_t* dir, uint32_t new_brk)
+{
+    uint32_t old_end, new_end;
+
+    if (!vm) return 0;
+    if (!new_brk || new_brk < vm->brk_start || new_brk > USER_HEAP_MAX)
+        return vm->brk;
+
+    old_end = PAGE_ALIGN(vm->brk);
+    new_end = PAGE_ALIGN(new_brk);
+
+    if (new_end > old_end) {
+        if (overlaps(vm, old_end, new_end)) return vm->brk;
+        if (old_end == vm->brk_start) {
+            if (vma_insert(vm, vm->brk_start, new_end - vm->brk_start,
+                           PTE_WRITABLE, VMA_HEAP) != 0)
+                return vm->brk;
+        } else {
+            vma_t* heap = vma_find(vm, old_end - 1);
+            if (!heap || heap->kind != VMA_HEAP) return vm->brk;
+            heap->end = new_end;
+        }
+    } else if (new_end < old_end) {
+        if (vma_remove(vm, dir, new_end, old_end - new_end) != 0)
+            return vm->brk;
+    }
+
+    vm->brk = new_brk;
+    return vm->brk;
+}
@@ -0,0 +1,102 @@
+/*
+ * vma.h — Áreas de memoria virtual (VMA) de un proceso
+ *
+ * Cada proceso describe su memoria de usuario "de demanda" con una lista
+ * de VMAs ordenada por dirección y sin solapes: stack, heap (brk) y
+ * regiones anónimas de SYS_MMAP. Una VMA solo reserva el rango; los
+ * frames llegan con el primer acceso a cada página (#PF, ver fault.c).
+ *
+ * El código del proceso (mapeado por proc_create_user) y el shadow de
+ * la pantalla (SYS_SURFACE_MAP) no son VMAs: munmap/brk nunca los tocan.
+ */
+#ifndef _VMA_H
+#define _VMA_H
+
+#include <types.h>
+#include "vmm.h"
+
+/* ── Layout de usuario ──────────────────────────────────────────────────── */
+/* Por encima del identity map del kernel (PMM_DIRECT_LIMIT) para que los
+ * PDEs del proceso nunca coincidan con tablas del kernel */
+#define USER_HEAP_BASE   0x10000000   /* inicio del brk */
+#define USER_HEAP_MAX    0x30000000   /* tope del brk */
+#define USER_MMAP_BASE   0x40000000   /* huecos para SYS_MMAP */
+#define USER_MMAP_TOP    0x7F000000   /* por debajo del stack */
+#define USER_SHADOW_BASE 0x7F000000   /* pantalla de solo lectura (SYS_SURFACE_MAP) */
+#define USER_SPACE_END   0x80000000   /* primera dirección del kernel */
+
+#define VMA_MAX          16           /* VMAs por proceso */
+
+/* ── Tipos de VMA ───────────────────────────────────────────────────────── */
+#define VMA_STACK   1
+#define VMA_HEAP    2
+#define VMA_ANON    3
+
+typedef struct {
+    uint32_t start, end;    /* [start, end), alineados a página */
+    uint32_t pte_flags;     /* PTE_* de las páginas que se creen */
+    uint32_t kind;          /* VMA_* */
+} vma_t;
+
+typedef struct {
+    vma_t    area[VMA_MAX]; /* ordenadas por start */
+    uint32_t count;
+    uint32_t brk_start;     /* base del heap */
+    uint32_t brk;           /* fin actual del heap (puede no estar alineado) */
+
+    /* Contabilidad de páginas de las VMAs (ps, SYS_PROC_INFO) */
+    uint32_t resident;      /* presentes en RAM */
+    uint32_t swapped;       /* desalojadas al swap */
+    uint32_t peak_resident; /* máximo de resident */
+} vma_set_t;
+
+/* ── API ────────────────────────────────────────────────────────────────── */
+
+/* Conjunto vacío con el heap en USER_HEAP_BASE */
+void vma_init(vma_set_t* vm);
+
+/* Sumar pages páginas residentes (un #PF las mapeó) y actualizar el pico */
+static inline void vma_charge(vma_set_t* vm, uint32_t pages)
+{
+    vm->resident += pages;
+    if (vm->resident > vm->peak_resident)
+        vm->peak_resident = vm->resident;
+}
+
+/* Páginas reservadas por todas las VMAs (tocadas o no) */
+uint32_t vma_committed_pages(const vma_set_t* vm);
+
+/* VMA que contiene addr, o NULL */
+vma_t* vma_find(vma_set_t* vm, uint32_t addr);
+
+/*
+ * Añadir [start, start+size) como VMA de tipo kind. Retorna 0, o -1 si
+ * se solapa con otra, no quedan slots o el rango no es de usuario.
+ */
+int vma_insert(vma_set_t* vm, uint32_t start, uint32_t size,
+               uint32_t pte_flags, uint32_t kind);
+
+/*
+ * Quitar [start, start+size) de todas las VMAs que lo cortan (recortando
+ * o partiendo) y soltar los frames que ya estuvieran mapeados en dir.
+ * Retorna 0 o -1 si partir una VMA necesitaría un slot que no hay.
+ */
+int vma_remove(vma_set_t* vm, page_directory_t* dir,
+               uint32_t start, uint32_t size);
+
+/*
+ * Reservar una región anónima de size bytes. Con fixed, exactamente en
+ * addr (lo que hubiera ahí se desmapea antes); si no, en el primer hueco
+ * de [USER_MMAP_BASE, USER_MMAP_TOP). Retorna la dirección o 0.
+ */
+uint32_t vma_mmap(vma_set_t* vm, page_directory_t* dir, uint32_t addr,
+                  uint32_t size, uint32_t pte_flags, int fixed);
+
+/*
+ * Mover el fin del heap a new_brk (0 = solo consultar). Crecer extiende
+ * la VMA del heap; encoger suelta las páginas que quedan fuera.
+ * Retorna el brk resultante (el anterior si no se pudo mover).
+ */
+uint32_t vma_brk(vma_set_t* vm, page_directory_t* dir, uint32_t new_brk);
+
+#endif /* _VMA_H */
@@ -0,0 +1,182 @@
+/*
+ * vmalloc.c — Memoria del kernel virtualmente contigua (ver vmalloc.h)
+ *
+ * Las áreas vivas se guardan en un array fijo ordenado por dirección,
+ * como las VMAs de un proceso; se busca hueco con first fit dejando una
+ * página de guarda detrás de cada área. El array solo se toca con
+ * interrupciones desactivadas. Los frames se piden y se mapean fuera de
+ * esa sección: el área ya está reservada y nadie más la ve.
+ *
+ * Los frames de un área no se guardan aquí: vfree() los descubre por los
+ * PTEs del directorio del kernel.
+ */
+#include "vmalloc.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "page.h"
+#include <hal.h>
+#include <types.h>
+
+#define VM_FLAGS        (PTE_PRESENT | PTE_WRITABLE)
+#define VM_CHUNK        64          /* frames pedidos al PMM por pasada */
+
+typedef struct {
+    uint32_t start;
+    uint32_t pages;                 /* sin contar la guarda */
+} varea_t;
+
+static varea_t          g_areas[VMALLOC_MAX_AREAS];
+static uint32_t         g_count;
+static vmalloc_stats_t  g_stats;
+
+/* ── Helpers ──────────────────────────────────────────────────────────── */
+
+static inline void tlb_flush(uint32_t virt)
+{
+    __asm__ volatile("invlpg (%0)" :: "r"(virt) : "memory");
+}
+
+/* Reservar pages páginas (+ guarda) en el primer hueco. 0 si no hay. */
+static uint32_t area_reserve(uint32_t pages)
+{
+    uint32_t span = (pages + 1) * PAGE_SIZE;
+    uint32_t cand = VMALLOC_START, i;
+
+    if (g_count >= VMALLOC_MAX_AREAS) return 0;
+    for (i = 0; i < g_count; i++) {
+        if (g_areas[i].start >= cand + span) break;
+        cand = g_areas[i].start + (g_areas[i].pages + 1) * PAGE_SIZE;
+    }
+    if (cand + span > VMALLOC_END || cand + span < cand) return 0;
+
+    for (uint32_t j = g_count; j > i; j--)
+        g_areas[j] = g_areas[j - 1];
+    g_areas[i].start = cand;
+    g_areas[i].pages = pages;
+    g_count++;
+    return cand;
+}
+
+/* Índice del área que empieza en start, o g_count si no hay */
+static uint32_t area_find(uint32_t start)
+{
+    uint32_t i;
+    for (i = 0; i < g_count; i++) {
+        if (g_areas[i].start == start) break;
+    }
+    return i;
+}
+
+static void area_delete(uint32_t i)
+{
+    for (; i + 1 < g_count; i++)
+        g_areas[i] = g_areas[i + 1];
+    g_count--;
+}
+
+/*
+ * Desmapear [start, start + pages) del kernel y soltar sus frames.
+ * page_put y no pmm_free_frame: un frame también mapeado en un proceso
+ * (el shadow de vídeo en USER_SHADOW_BASE) vive hasta su última
+ * referencia. El directorio actual puede compartir esas tablas sin ser
+ * el del kernel, así que se invalida el TLB aquí siempre.
+ */
+static void unmap_pages(uint32_t start, uint32_t pages)
+{
+    page_directory_t* kdir = vmm_get_kernel_directory();
+
+    for (uint32_t p = 0; p < pages; p++) {
+        pte_t pte = vmm_get_pte(kdir, start + p * PAGE_SIZE);
+        if (pte & PTE_PRESENT) page_put(PTE_ADDR(pte));
+    }
+    vmm_unmap_range(kdir, start, pages * PAGE_SIZE);
+    for (uint32_t p = 0; p < pages; p++)
+        tlb_flush(start + p * PAGE_SIZE);
+}
+
+/* ── API pública ──────────────────────────────────────────────────────── */
+
+void* vmalloc(size_t size)
+{
+    uint32_t pages = PAGE_ALIGN(size) / PAGE_SIZE;
+    uint32_t chunk[VM_CHUNK];
+    uint32_t start, done, flags;
+
+    if (!pages) return NULL;
+
+    flags = irq_save();
+    start = area_reserve(pages);
+    if (!start) g_stats.failures++;
+    irq_restore(flags);
+    if (!start) return NULL;
+
+    /* Respaldar el área por tandas de frames sueltos */
+    for (done = 0; done < pages; ) {
+        uint32_t n = pages - done;
+        if (n > VM_CHUNK) n = VM_CHUNK;
+        if (!pmm_alloc_batch(n, chunk)) break;
+        for (uint32_t i = 0; i < n; i++)
+            page_set(chunk[i], PG_KERNEL, 0);
+        if (vmm_map_frames(vmm_get_kernel_directory(),
+                           start + done * PAGE_SIZE, chunk, n, VM_FLAGS) != 0) {
+            /* sin memoria para una tabla: quitar lo que llegó a mapearse
+             * de esta tanda y devolverla entera */
+            vmm_unmap_range(vmm_get_kernel_directory(),
+                            start + done * PAGE_SIZE, n * PAGE_SIZE);
+            for (uint32_t i = 0; i < n; i++)
+                tlb_flush(start + (done + i) * PAGE_SIZE);
+            pmm_free_batch(n, chunk);
+            break;
+        }
+        done += n;
+    }
+
+    if (done < pages) {
+        unmap_pages(start, done);
+        flags = irq_save();
+        area_delete(area_find(start));
+        g_stats.failures++;
+        irq_restore(flags);
+        return NULL;
+    }
+
+    flags = irq_save();
+    g_stats.areas++;
+    g_stats.allocs++;
+    g_stats.pages += pages;
+    if (g_stats.pages > g_stats.peak_pages) g_stats.peak_pages = g_stats.pages;
+    irq_restore(flags);
+    return (void*)start;
+}
+
+void vfree(void* addr)
+{
+    uint32_t flags, i, pages = 0;
+
+    if (!addr) return;
+
+    flags = irq_save();
+    i = area_find((uint32_t)addr);
+    if (i < g_count) pages = g_areas[i].pages;
+    irq_restore(flags);
+    if (!pages) return;
+
+    /* Desmapear antes de soltar el rango: hasta entonces nadie lo reusa */
+    unmap_pages((uint32_t)addr, pages);
+
+    flags = irq_save();
+    area_delete(area_find((uint32_t)addr));
+    g_stats.areas--;
+    g_stats.frees++;
+    g_stats.pages -= pages;
+    irq_restore(flags);
+}
+
+void vmalloc_get_stats(vmalloc_stats_t* out)
+{
+    uint32_t flags;
+    if (!out) return;
+    flags = irq_save();
+    *out = g_stats;
+    irq_restore(flags);
+}
@@ -0,0 +1,44 @@
+/*
+ * vmalloc.h — Memoria del kernel virtualmente contigua
+ *
+ * vmalloc() reserva un rango de [VMALLOC_START, VMALLOC_END) y lo respalda
+ * con frames sueltos del PMM (cualquiera, también por encima del identity
+ * map), mapeados en el momento del pedido. Sirve para buffers grandes que
+ * no necesitan ser físicamente contiguos y que antes eran arrays .bss
+ * fijos en la imagen del kernel: solo ocupan RAM mientras alguien los usa.
+ *
+ * Las tablas del rango viven en el directorio del kernel; un directorio
+ * de proceso creado antes las recibe en su primer acceso
+ * (vmm_sync_kernel_pde desde el #PF).
+ *
+ * Entre dos áreas queda siempre una página sin mapear: salirse de un
+ * buffer da #PF en vez de pisar el siguiente.
+ */
+#ifndef _VMALLOC_H
+#define _VMALLOC_H
+
+#include <types.h>
+
+#define VMALLOC_START       0xD0000000
+#define VMALLOC_END         0xD8000000  /* 128 MB de direcciones */
+#define VMALLOC_MAX_AREAS   32
+
+typedef struct {
+    uint32_t areas;         /* áreas vivas */
+    uint32_t pages;         /* frames que las respaldan */
+    uint32_t peak_pages;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;      /* sin direcciones, slots o frames */
+} vmalloc_stats_t;
+
+/* size bytes (redondeado a páginas), sin poner a cero. NULL si no hay
+ * memoria. Llamar después de vmm_init(). */
+void* vmalloc(size_t size);
+
+/* Desmapear y devolver al PMM un área de vmalloc() (NULL se ignora) */
+void vfree(void* addr);
+
+void vmalloc_get_stats(vmalloc_stats_t* out);
+
+#endif /* _VMALLOC_H */
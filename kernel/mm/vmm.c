@@ -1,15 +1,59 @@
 /*
  * vmm.c — Virtual Memory Manager x86
  *
- * Implementa paginación de 2 niveles (page directory + page tables).
+ * Implementa paginación de 2 niveles (page directory + page tables), o
+ * de 3 con PAE (PDPT + 4 page directories + page tables de 8 bytes por
+ * entrada). El modo se elige una vez en vmm_init() y todo lo demás pasa
+ * por la misma geometría: un directorio "plano" de g_pd_entries PDEs
+ * (1024, o 2048 = los 4 PDs seguidos con PAE), tablas de g_pt_entries
+ * entradas y ent_get()/ent_set() para el ancho de cada entrada.
  * El kernel usa identity mapping: virt == phys para todo el espacio del kernel.
- * Cada proceso de usuario tiene su propio page directory que incluye
- * los mappings del kernel (para que las syscalls funcionen sin cambiar CR3).
+ * Cada proceso de usuario tiene su propio page directory que comparte
+ * las page tables del kernel por referencia (para que las syscalls
+ * funcionen sin cambiar CR3); solo las regiones de usuario tienen tablas
+ * propias.
+ *
+ * Las page tables y directorios NO se leen por identity mapping (solo
+ * cubre los primeros PMM_DIRECT_LIMIT bytes): page_directory_t* es la
+ * dirección física del directorio (del PDPT con PAE) y se accede a las
+ * tablas así:
+ *   - directorio cargado en CR3: por los slots recursivos (el PDE 1023
+ *     apunta al propio directorio; con PAE los PDEs 2044-2047 apuntan a
+ *     los 4 PDs) → tablas en g_pt_base, directorio plano en g_pd_virt
+ *   - cualquier otro: por la ventana de mapeos temporales (vmm_kmap),
+ *     page tables compartidas por todos los directorios; los 4 PDs de un
+ *     directorio PAE se mapean en 4 slots seguidos
+ * Antes de activar paginación todo se accede por su dirección física
+ * (los 4 PDs del kernel son físicamente contiguos).
+ *
+ * Si la CPU tiene PSE el identity map del kernel usa páginas de 4MB (con
+ * PAE, de 2MB, que no necesitan PSE), y con PGE se marcan globales:
+ * recargar CR3 al cambiar de proceso ya no vacía esas traducciones del
+ * TLB. Las páginas grandes que contienen las secciones .user quedan en
+ * páginas de 4KB no globales, porque los procesos mapean ahí su código
+ * encima del mapping del kernel.
  */
 #include "vmm.h"
 #include "pmm.h"
+#include "page.h"
+#include "swap.h"
+#include <hal.h>       /* cpu_cpuid, irq_save */
 #include <types.h>
 
+extern void serial_puts(const char*);
+extern void serial_print_dec(uint32_t v);
+
+/* Secciones .user (linker.ld) */
+extern uint8_t _user_start, _user_end;
+
+#define CR4_PSE   (1 << 4)
+#define CR4_PAE   (1 << 5)
+#define CR4_PGE   (1 << 7)
+
+/* PAE: los 4 PDs de un directorio y sus slots recursivos al final */
+#define PAE_PDS         4
+#define PAE_SELF_PDI    2044
+
 /* ── Helpers de I/O para CR0/CR3 ─────────────────────────────────────────── */
 static inline void write_cr3(uint32_t val)
 {
@@ -27,10 +71,24 @@ static inline void enable_paging(void)
 {
     uint32_t cr0;
     __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
-    cr0 |= 0x80000001;   /* bit31 = PG, bit0 = PE (ya debería estar) */
+    /* bit31 = PG, bit16 = WP (el kernel también respeta las páginas de
+     * solo lectura: necesario para copy-on-write), bit0 = PE */
+    cr0 |= 0x80010001;
     __asm__ volatile("mov %0, %%cr0" :: "r"(cr0) : "memory");
 }
 
+static inline uint32_t read_cr4(void)
+{
+    uint32_t val;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(val));
+    return val;
+}
+
+static inline void write_cr4(uint32_t val)
+{
+    __asm__ volatile("mov %0, %%cr4" :: "r"(val) : "memory");
+}
+
 static inline void tlb_flush(uint32_t virt)
 {
     __asm__ volatile("invlpg (%0)" :: "r"(virt) : "memory");
@@ -38,121 +96,744 @@ static inline void tlb_flush(uint32_t virt)
 
 /* ── Estado global ────────────────────────────────────────────────────────── */
 static page_directory_t* g_kernel_dir = NULL;
+static int               g_paging_on  = 0;
+static uint32_t          g_features   = 0;    /* VMM_FEAT_* */
+static vmm_tlb_stats_t   g_tlb_stats;
+
+/* Geometría del modo elegido (valores sin PAE; vmm_init() los cambia) */
+static int      g_pae        = 0;
+static uint32_t g_pd_shift   = 22;            /* bits de virt que cubre un PDE */
+static uint32_t g_pd_entries = 1024;          /* PDEs del directorio plano */
+static uint32_t g_pt_entries = 1024;          /* entradas por page table */
+static uint32_t g_pd_pages   = 1;             /* frames del directorio plano */
+static uint32_t g_kmap_pdi   = VMM_KMAP_BASE >> 22;   /* ventana kmap; desde
+                                                 aquí los PDEs son fijos */
+static uint32_t g_self_pdi   = 1023;          /* primer slot recursivo */
+static uint32_t g_pt_base    = 0xFFC00000;    /* tablas del directorio actual */
+static uint32_t g_pd_virt    = 0xFFFFF000;    /* su directorio plano */
+
+#define PDI(va)   ((uint32_t)(va) >> g_pd_shift)
+#define PTI(va)   (((uint32_t)(va) >> 12) & (g_pt_entries - 1))
+
+/* Slots ocupados de la ventana kmap: 1 bit por slot */
+static uint32_t g_kmap_used[VMM_KMAP_SLOTS / 32];
+
+/* ── Entradas de 4 u 8 bytes ──────────────────────────────────────────────── */
+
+static inline pte_t ent_get(const void* table, uint32_t i)
+{
+    if (g_pae) {
+        const volatile uint32_t* e = (const volatile uint32_t*)table + 2 * i;
+        return (pte_t)e[0] | ((pte_t)e[1] << 32);
+    }
+    return ((const volatile uint32_t*)table)[i];
+}
+
+/* Con PAE la entrada se escribe en dos mitades: si cambia la alta, la
+ * baja (con P) pasa antes por 0 para que la MMU nunca vea una mezcla */
+static inline void ent_set(void* table, uint32_t i, pte_t v)
+{
+    if (g_pae) {
+        volatile uint32_t* e = (volatile uint32_t*)table + 2 * i;
+        if (e[1] != (uint32_t)(v >> 32)) {
+            e[0] = 0;
+            e[1] = (uint32_t)(v >> 32);
+        }
+        e[0] = (uint32_t)v;
+        return;
+    }
+    ((volatile uint32_t*)table)[i] = (uint32_t)v;
+}
+
+/* ── Ventana de mapeos temporales ─────────────────────────────────────────── */
+
+/* PTEs de la ventana vistos por el slot recursivo del directorio actual
+ * (con PAE son dos tablas seguidas, también seguidas en esa vista) */
+#define KMAP_PTES   ((void*)(g_pt_base + g_kmap_pdi * PAGE_SIZE))
+
+/* Mapear n frames (n potencia de 2, <= 32) en n slots seguidos y
+ * alineados a n de la ventana. NULL si no hay hueco. */
+static void* kmap_frames(const phys_addr_t* frames, uint32_t n)
+{
+    uint32_t flags, w, b = 0, mask = (n >= 32) ? 0xFFFFFFFF : (1u << n) - 1;
+    uint32_t slot, virt;
+
+    flags = irq_save();
+    for (w = 0; w < VMM_KMAP_SLOTS / 32; w++) {
+        if (g_kmap_used[w] == 0xFFFFFFFF) continue;
+        if (n == 1) {
+            __asm__("bsf %1, %0" : "=r"(b) : "r"(~g_kmap_used[w]));
+            break;
+        }
+        for (b = 0; b < 32; b += n) {
+            if (!(g_kmap_used[w] & (mask << b))) break;
+        }
+        if (b < 32) break;
+    }
+    if (w == VMM_KMAP_SLOTS / 32) {
+        irq_restore(flags);
+        return NULL;   /* ventana agotada */
+    }
+    g_kmap_used[w] |= mask << b;
+    slot = w * 32 + b;
+    virt = VMM_KMAP_BASE + slot * PAGE_SIZE;
+
+    for (uint32_t i = 0; i < n; i++) {
+        ent_set(KMAP_PTES, slot + i,
+                PTE_ADDR(frames[i]) | PTE_PRESENT | PTE_WRITABLE);
+        tlb_flush(virt + i * PAGE_SIZE);
+    }
+    irq_restore(flags);
+    return (void*)virt;
+}
+
+static void kunmap_frames(void* ptr, uint32_t n)
+{
+    uint32_t virt = (uint32_t)ptr & ~0xFFF;
+    uint32_t slot, flags;
+
+    if (!g_paging_on) return;
+    if (virt < VMM_KMAP_BASE ||
+        virt + n * PAGE_SIZE > VMM_KMAP_BASE + VMM_KMAP_SLOTS * PAGE_SIZE)
+        return;
+
+    slot  = (virt - VMM_KMAP_BASE) / PAGE_SIZE;
+    flags = irq_save();
+    for (uint32_t i = 0; i < n; i++) {
+        ent_set(KMAP_PTES, slot + i, 0);
+        tlb_flush(virt + i * PAGE_SIZE);
+        g_kmap_used[(slot + i) / 32] &= ~(1u << ((slot + i) % 32));
+    }
+    irq_restore(flags);
+}
+
+void* vmm_kmap(phys_addr_t phys)
+{
+    /* Sin paginación solo hay memoria baja, leída por su dirección */
+    if (!g_paging_on) return (void*)((uint32_t)phys & ~0xFFF);
+    return kmap_frames(&phys, 1);
+}
+
+void vmm_kunmap(void* ptr)
+{
+    kunmap_frames(ptr, 1);
+}
+
+/* ── Acceso a directorios y tablas ────────────────────────────────────────── */
+
+static inline int is_current(page_directory_t* dir)
+{
+    return g_paging_on && (read_cr3() & ~0xFFF) == (uint32_t)dir;
+}
+
+/* PAE: frames de los 4 page directories de dir (sus entradas del PDPT) */
+static int pae_pds(page_directory_t* dir, phys_addr_t pds[PAE_PDS])
+{
+    uint64_t* pdpt = (uint64_t*)vmm_kmap((uint32_t)dir);
+    if (!pdpt) return 0;
+    for (int i = 0; i < PAE_PDS; i++)
+        pds[i] = PTE_ADDR(pdpt[i]);
+    vmm_kunmap(pdpt);
+    return 1;
+}
+
+/* Entradas del directorio plano: por el slot recursivo si es el actual */
+static void* pd_map(page_directory_t* dir)
+{
+    phys_addr_t pds[PAE_PDS];
+
+    if (is_current(dir)) return (void*)g_pd_virt;
+    if (!g_pae) return vmm_kmap((uint32_t)dir);
+    if (!pae_pds(dir, pds)) return NULL;
+    if (!g_paging_on) return (void*)(uint32_t)pds[0];   /* contiguos */
+    return kmap_frames(pds, PAE_PDS);
+}
+
+static void pd_unmap(page_directory_t* dir, void* pd)
+{
+    if (pd != (void*)g_pd_virt || !is_current(dir))
+        kunmap_frames(pd, g_pd_pages);
+}
+
+/* Entradas de la tabla del PDE pdi (pde ya presente) */
+static void* pt_map(page_directory_t* dir, uint32_t pdi, pde_t pde)
+{
+    if (is_current(dir)) return (void*)(g_pt_base + pdi * PAGE_SIZE);
+    return vmm_kmap(PTE_ADDR(pde));
+}
+
+static void pt_unmap(void* pt)
+{
+    if ((uint32_t)pt < g_pt_base)   /* las vistas recursivas no se sueltan */
+        vmm_kunmap(pt);
+}
 
 /* ── Internos ─────────────────────────────────────────────────────────────── */
 
-/* Obtener o crear la page table para un PDE */
-static page_table_t* get_or_create_table(page_directory_t* dir,
-                                          uint32_t pdi, uint32_t flags)
+/* PDE pdi del directorio del kernel */
+static pde_t kernel_pde(uint32_t pdi)
+{
+    void* kpd = pd_map(g_kernel_dir);
+    pde_t pde;
+    if (!kpd) return 0;
+    pde = ent_get(kpd, pdi);
+    pd_unmap(g_kernel_dir, kpd);
+    return pde;
+}
+
+/* ¿El PDE de dir apunta a la misma page table que el del kernel? */
+static int shares_kernel_table(page_directory_t* dir, uint32_t pdi, pde_t pde)
+{
+    pde_t kpde;
+    if (dir == g_kernel_dir || !(pde & PTE_PRESENT)) return 0;
+    kpde = kernel_pde(pdi);
+    return (kpde & PTE_PRESENT) && PTE_ADDR(kpde) == PTE_ADDR(pde);
+}
+
+/*
+ * Sustituir una page table compartida del kernel por una copia privada
+ * del directorio, para poder poner páginas de usuario en ese rango (p.ej.
+ * las secciones .user dentro de los primeros 4MB) sin tocar la tabla que
+ * ven todos los procesos. Las entradas copiadas siguen sin PTE_USER.
+ */
+static int privatize_table(page_directory_t* dir, void* pd, uint32_t pdi)
 {
-    pde_t pde = dir->entries[pdi];
+    uint32_t phys = pmm_alloc_frame();
+    pde_t pde = ent_get(pd, pdi);
+    uint32_t *src, *dst;
 
-    if (pde & PTE_PRESENT) {
-        /* Ya existe — retornar la dirección física como puntero virtual
-         * (válido porque usamos identity mapping para el kernel) */
-        return (page_table_t*)(pde & ~0xFFF);
+    if (!phys) return 0;
+    src = (uint32_t*)vmm_kmap(PTE_ADDR(pde));
+    dst = (uint32_t*)vmm_kmap(phys);
+    if (!src || !dst) {
+        if (src) vmm_kunmap(src);
+        if (dst) vmm_kunmap(dst);
+        pmm_free_frame(phys);
+        return 0;
     }
+    for (int j = 0; j < PAGE_SIZE / 4; j++)   /* la tabla entera, de 4 u 8 */
+        dst[j] = src[j];
+    vmm_kunmap(dst);
+    vmm_kunmap(src);
+    page_set(phys, PG_PAGETABLE, 0);
 
-    /* Allocar un nuevo frame para la page table */
+    ent_set(pd, pdi, phys | (pde & 0xFFF));
+    if (is_current(dir))
+        tlb_flush(g_pt_base + pdi * PAGE_SIZE);
+    return 1;
+}
+
+/*
+ * Partir una página grande (4MB, o 2MB con PAE) en una page table de
+ * páginas de 4KB con la misma traducción y permisos. En el directorio
+ * del kernel la tabla queda fija; en el de un proceso es privada (como
+ * privatize_table).
+ */
+static int split_large(page_directory_t* dir, void* pd, uint32_t pdi)
+{
+    pde_t pde = ent_get(pd, pdi);
+    phys_addr_t base = PTE_ADDR(pde) & ~(phys_addr_t)((1u << g_pd_shift) - 1);
     uint32_t phys = pmm_alloc_frame();
-    if (!phys) return NULL;
+    void* pt;
+
+    if (!phys) return 0;
+    pt = vmm_kmap(phys);
+    if (!pt) { pmm_free_frame(phys); return 0; }
+    for (uint32_t j = 0; j < g_pt_entries; j++)
+        ent_set(pt, j, (base + j * PAGE_SIZE) |
+                (pde & (PTE_PRESENT | PTE_WRITABLE | PTE_USER | PTE_GLOBAL)));
+    vmm_kunmap(pt);
 
-    /* Limpiar la nueva page table */
-    page_table_t* table = (page_table_t*)phys;
-    for (int i = 0; i < 1024; i++)
-        table->entries[i] = 0;
+    page_set(phys, dir == g_kernel_dir ? PG_PAGETABLE | PG_KERNEL | PG_PINNED
+                                       : PG_PAGETABLE, 0);
+    ent_set(pd, pdi, phys | (pde & (PTE_PRESENT | PTE_WRITABLE | PTE_USER)));
+    if (is_current(dir))
+        tlb_flush(g_pt_base + pdi * PAGE_SIZE);
+    return 1;
+}
+
+/* Obtener o crear la page table para un PDE. Retorna la tabla mapeada
+ * (soltar con pt_unmap) o NULL. */
+static void* get_or_create_table(page_directory_t* dir, void* pd,
+                                 uint32_t pdi, uint32_t flags)
+{
+    pde_t pde = ent_get(pd, pdi);
 
-    /* Instalar el PDE */
-    dir->entries[pdi] = phys | flags | PTE_PRESENT;
+    if ((pde & PTE_PRESENT) && (pde & PTE_PS)) {
+        if (!split_large(dir, pd, pdi)) return NULL;
+    } else if (!(pde & PTE_PRESENT)) {
+        /* Allocar un frame ya limpio para la page table */
+        uint32_t phys = pmm_alloc_zeroed_frame();
+        if (!phys) return NULL;
+        page_set(phys, PG_PAGETABLE, 0);
 
-    return table;
+        /* Instalar el PDE; la vista recursiva de esa tabla cambia */
+        ent_set(pd, pdi, phys | flags | PTE_PRESENT);
+        if (is_current(dir))
+            tlb_flush(g_pt_base + pdi * PAGE_SIZE);
+    } else if ((flags & PTE_USER) &&
+               shares_kernel_table(dir, pdi, pde)) {
+        if (!privatize_table(dir, pd, pdi)) return NULL;
+    }
+    return pt_map(dir, pdi, ent_get(pd, pdi));
 }
 
 /* ── API pública ──────────────────────────────────────────────────────────── */
 
+int vmm_sync_kernel_pde(uint32_t virt)
+{
+    uint32_t pdi = PDI(virt);
+    void* pd;
+    pde_t kpde;
+
+    if (!g_paging_on || pdi >= g_kmap_pdi || is_current(g_kernel_dir))
+        return 0;
+    kpde = kernel_pde(pdi);
+    if (!(kpde & PTE_PRESENT)) return 0;
+
+    pd = (void*)g_pd_virt;
+    if (ent_get(pd, pdi) & PTE_PRESENT) return 0;
+    ent_set(pd, pdi, kpde);
+    tlb_flush(g_pt_base + pdi * PAGE_SIZE);
+    return 1;
+}
+
 page_directory_t* vmm_create_directory(void)
 {
-    uint32_t phys = pmm_alloc_frame();
+    phys_addr_t pds[PAE_PDS];
+    uint32_t phys;
+    void *kpd, *pd;
+
+    /* El directorio (el PDPT con PAE) empieza vacío */
+    phys = pmm_alloc_zeroed_frame();
     if (!phys) return NULL;
+    pds[0] = phys;
 
+    if (g_pae) {
+        /* Los 4 PDs: todas sus entradas se escriben abajo */
+        uint32_t f[PAE_PDS];
+        uint64_t* pdpt;
+
+        if (!pmm_alloc_batch(PAE_PDS, f)) {
+            pmm_free_frame(phys);
+            return NULL;
+        }
+        pdpt = (uint64_t*)vmm_kmap(phys);
+        if (!pdpt) {
+            pmm_free_batch(PAE_PDS, f);
+            pmm_free_frame(phys);
+            return NULL;
+        }
+        /* Las entradas del PDPT solo llevan P: R/W y U/S están reservados */
+        for (int i = 0; i < PAE_PDS; i++) {
+            pds[i]  = f[i];
+            pdpt[i] = f[i] | PTE_PRESENT;
+            page_set(f[i], PG_PAGETABLE, 0);
+        }
+        vmm_kunmap(pdpt);
+    }
+
+    kpd = pd_map(g_kernel_dir);
+    pd  = g_pae ? kmap_frames(pds, PAE_PDS) : vmm_kmap(phys);
+    if (!kpd || !pd) {
+        if (kpd) pd_unmap(g_kernel_dir, kpd);
+        if (pd)  kunmap_frames(pd, g_pd_pages);
+        if (g_pae) {
+            for (int i = 0; i < PAE_PDS; i++) pmm_free_frame(pds[i]);
+        }
+        pmm_free_frame(phys);
+        return NULL;
+    }
     page_directory_t* dir = (page_directory_t*)phys;
+    page_set(phys, PG_PAGETABLE, 0);
 
-    /* Limpiar todas las entradas */
-    for (int i = 0; i < 1024; i++)
-        dir->entries[i] = 0;
-
-    /* Copiar las entradas del kernel para que las syscalls funcionen
-     * sin cambiar CR3. Esto incluye tanto la "mitad alta" (0x80000000+)
-     * como el mapeo de identidad de la memoria baja (incluyendo VGA).
-     * Las entradas ya tienen PTE_USER=0, por lo que los procesos no pueden
-     * acceder a ellas directamente desde Ring 3. */
-    if (g_kernel_dir) {
-        /* copiar los mappings del kernel, y si hay page tables presentes
-         * clonarlas para que el proceso de usuario pueda acceder a todas
-         * las páginas (PTE_USER). No queremos alterar las tablas del
-         * kernel, por lo que creamos copias físicas. */
-        for (int i = 0; i < 1024; i++) {
-            pde_t pde = g_kernel_dir->entries[i];
-            if (!(pde & PTE_PRESENT)) {
-                dir->entries[i] = 0;
-                continue;
-            }
-            /* si el PDE apunta a una tabla, clonarla */
-            page_table_t* orig = (page_table_t*)(pde & ~0xFFF);
-            uint32_t new_phys = pmm_alloc_frame();
-            if (!new_phys) {
-                /* fallar limpiamente manteniendo solo kernel mapping */
-                dir->entries[i] = pde | PTE_USER;
-                continue;
-            }
-            page_table_t* newtbl = (page_table_t*)new_phys;
-            /* copiar contenido de la tabla y establecer PTE_USER en cada fila */
-            for (int j = 0; j < 1024; j++) {
-                newtbl->entries[j] = orig->entries[j] | PTE_USER;
+    /* Compartir las page tables del kernel por referencia: mismos PDEs
+     * (identity map, ventana kmap), sin PTE_USER, de modo que las
+     * syscalls funcionan sin cambiar CR3 y Ring 3 no ve nada del kernel.
+     * Las regiones de usuario se mapean después con vmm_map_page(), que
+     * crea tablas propias (o copia privada si caen en un rango del kernel). */
+    for (uint32_t i = 0; i < g_self_pdi; i++)
+        ent_set(pd, i, ent_get(kpd, i));
+    /* Recursivo: el directorio (o sus 4 PDs) como page tables */
+    for (uint32_t i = 0; i < g_pd_pages; i++)
+        ent_set(pd, g_self_pdi + i, pds[i] | PTE_PRESENT | PTE_WRITABLE);
+
+    kunmap_frames(pd, g_pd_pages);
+    pd_unmap(g_kernel_dir, kpd);
+    return dir;
+}
+
+/* ¿Es el PDE i de pd una page table propia (no compartida con kpd)? */
+static inline int own_table(void* pd, void* kpd, uint32_t i)
+{
+    pde_t pde = ent_get(pd, i), kpde = ent_get(kpd, i);
+    if (!(pde & PTE_PRESENT) || (pde & PTE_PS)) return 0;
+    return !((kpde & PTE_PRESENT) && PTE_ADDR(kpde) == PTE_ADDR(pde));
+}
+
+void vmm_destroy_directory(page_directory_t* dir)
+{
+    phys_addr_t pds[PAE_PDS];
+    void *pd, *kpd;
+
+    if (!dir || dir == g_kernel_dir || is_current(dir)) return;
+    if (g_pae && !pae_pds(dir, pds)) return;
+    kpd = pd_map(g_kernel_dir);
+    pd  = pd_map(dir);
+    if (!pd || !kpd) {
+        if (kpd) pd_unmap(g_kernel_dir, kpd);
+        if (pd)  pd_unmap(dir, pd);
+        return;
+    }
+
+    /* Soltar solo las page tables propias del directorio; las del kernel
+     * se comparten y los slots recursivos apuntan al propio directorio */
+    for (uint32_t i = 0; i < g_self_pdi; i++) {
+        if (own_table(pd, kpd, i))
+            page_put(PTE_ADDR(ent_get(pd, i)));
+    }
+    pd_unmap(dir, pd);
+    pd_unmap(g_kernel_dir, kpd);
+    if (g_pae) {
+        for (int i = 0; i < PAE_PDS; i++) page_put(pds[i]);
+    }
+    page_put((uint32_t)dir);
+}
+
+uint32_t vmm_count_tables(page_directory_t* dir)
+{
+    void *pd, *kpd;
+    uint32_t n = 0;
+
+    if (!dir || dir == g_kernel_dir) return 0;
+    kpd = pd_map(g_kernel_dir);
+    pd  = pd_map(dir);
+    if (pd && kpd) {
+        /* Mismo criterio que vmm_destroy_directory() */
+        n = 1 + (g_pae ? PAE_PDS : 0);
+        for (uint32_t i = 0; i < g_self_pdi; i++)
+            n += own_table(pd, kpd, i);
+    }
+    if (pd)  pd_unmap(dir, pd);
+    if (kpd) pd_unmap(g_kernel_dir, kpd);
+    return n;
+}
+
+/* Soltar la referencia a cada frame de usuario (o slot de swap) de una
+ * tabla (fork fallido) */
+static void put_user_frames(phys_addr_t table_phys)
+{
+    void* pt = vmm_kmap(table_phys);
+    if (!pt) return;
+    for (uint32_t j = 0; j < g_pt_entries; j++) {
+        pte_t pte = ent_get(pt, j);
+        if ((pte & PTE_PRESENT) && (pte & PTE_USER))
+            page_put(PTE_ADDR(pte));
+        else if (pte & PTE_SWAP)
+            swap_free_entry(pte);
+    }
+    vmm_kunmap(pt);
+}
+
+page_directory_t* vmm_fork_directory(page_directory_t* src)
+{
+    page_directory_t* dir;
+    void *spd, *dpd;
+    uint32_t pdi = 0, protected = 0;
+
+    if (!src || src == g_kernel_dir) return NULL;
+    dir = vmm_create_directory();
+    if (!dir) return NULL;
+    spd = pd_map(src);
+    dpd = pd_map(dir);
+    if (!spd || !dpd) goto fail;
+
+    /* Solo el espacio de usuario: tablas propias de src por debajo de la
+     * ventana kmap (las compartidas con el kernel ya están en dir) */
+    for (pdi = 0; pdi < g_kmap_pdi; pdi++) {
+        pde_t pde = ent_get(spd, pdi);
+        void *sp, *dp;
+        uint32_t phys;
+
+        if (!(pde & PTE_PRESENT) || (pde & PTE_PS)) continue;
+        if (shares_kernel_table(src, pdi, pde)) continue;
+
+        phys = pmm_alloc_frame();
+        if (!phys) goto fail;
+        sp = pt_map(src, pdi, pde);
+        dp = vmm_kmap(phys);
+        if (!sp || !dp) {
+            if (sp) pt_unmap(sp);
+            if (dp) vmm_kunmap(dp);
+            pmm_free_frame(phys);
+            goto fail;
+        }
+        page_set(phys, PG_PAGETABLE, 0);
+
+        for (uint32_t j = 0; j < g_pt_entries; j++) {
+            pte_t pte = ent_get(sp, j);
+            /* Entradas del kernel (copia privada de una tabla del
+             * identity map) se copian tal cual, sin referencias */
+            if ((pte & PTE_PRESENT) && (pte & PTE_USER)) {
+                if (pte & PTE_WRITABLE) {
+                    pte = (pte & ~(pte_t)PTE_WRITABLE) | PTE_COW;
+                    ent_set(sp, j, pte);
+                    protected++;
+                }
+                page_get(PTE_ADDR(pte));
+            } else if (pte & PTE_SWAP) {
+                swap_dup(pte);   /* el hijo también apunta al slot */
             }
-            /* instalar la nueva tabla en el directorio de usuario */
-            dir->entries[i] = new_phys | (pde & 0xFFF) | PTE_USER;
+            ent_set(dp, j, pte);
         }
+        vmm_kunmap(dp);
+        pt_unmap(sp);
+        ent_set(dpd, pdi, phys | (pde & 0xFFF));
     }
+    pd_unmap(dir, dpd);
+    pd_unmap(src, spd);
 
+    /* Las páginas de src que quedaron de solo lectura pueden estar en el
+     * TLB como escribibles: un solo reload de CR3 (no son globales) */
+    if (protected && is_current(src)) {
+        write_cr3(read_cr3());
+        g_tlb_stats.full_flushes++;
+    }
     return dir;
+
+fail:
+    /* Deshacer las tablas ya copiadas: sus frames de usuario tenían una
+     * referencia extra. Las páginas de src ya marcadas COW se quedan así */
+    if (dpd) {
+        for (uint32_t i = 0; i < pdi; i++) {
+            pde_t pde = ent_get(dpd, i);
+            if ((pde & PTE_PRESENT) && !(pde & PTE_PS) &&
+                !shares_kernel_table(dir, i, pde))
+                put_user_frames(PTE_ADDR(pde));
+        }
+        pd_unmap(dir, dpd);
+    }
+    if (spd) pd_unmap(src, spd);
+    if (protected && is_current(src)) write_cr3(read_cr3());
+    vmm_destroy_directory(dir);
+    return NULL;
+}
+
+/* ── Mapeo por rangos e invalidación diferida del TLB ─────────────────────── */
+
+/*
+ * Invalidar 'stale' páginas de [virt, virt + pages*4KB) cuyo PTE anterior
+ * estaba presente (las entradas no presentes nunca están en el TLB).
+ * Directorios que no están en CR3 no se invalidan: el TLB solo tiene
+ * traducciones del actual. Las tablas del directorio del kernel se
+ * comparten con todos, así que sus cambios cuentan siempre como activos.
+ */
+static void flush_range(page_directory_t* dir, uint32_t virt,
+                        uint32_t pages, uint32_t stale)
+{
+    if (!g_paging_on) return;
+    if (!stale || (dir != g_kernel_dir && !is_current(dir))) {
+        g_tlb_stats.avoided += pages;
+        return;
+    }
+    if (stale > VMM_FLUSH_THRESHOLD) {
+        /* Un solo reload de CR3 en vez de muchos invlpg (las páginas
+         * globales del kernel no se ven afectadas) */
+        write_cr3(read_cr3());
+        g_tlb_stats.full_flushes++;
+        g_tlb_stats.avoided += pages - 1;
+        return;
+    }
+    for (uint32_t i = 0; i < pages; i++) {
+        /* sin saber cuáles eran presentes, invalidar todo el rango */
+        tlb_flush(virt + i * PAGE_SIZE);
+    }
+    g_tlb_stats.invlpg += pages;
+}
+
+/* Escribir PTEs de [virt, virt + count páginas): frames[i] si hay lista,
+ * si no phys + i*4KB. Retorna las páginas mapeadas. */
+static uint32_t map_pages(page_directory_t* dir, uint32_t virt,
+                          const uint32_t* frames, phys_addr_t phys,
+                          uint32_t count, uint32_t flags)
+{
+    uint32_t done = 0, stale = 0;
+    void* pd = pd_map(dir);
+    if (!pd) return 0;
+
+    while (done < count) {
+        uint32_t va  = virt + done * PAGE_SIZE;
+        uint32_t pdi = PDI(va);
+        uint32_t pti = PTI(va);
+
+        void* table = get_or_create_table(dir, pd, pdi,
+                                          flags | PTE_PRESENT | PTE_WRITABLE);
+        if (!table) break;
+        /* if we're requesting user access, make sure the PDE itself is
+         * user-accessible (U bit). Kernel PDEs have U=0 (and the table is
+         * now private), so without this the PTE U bit would be ignored and
+         * Ring 3 accesses will PF. */
+        if (flags & PTE_USER) {
+            pde_t pde = ent_get(pd, pdi) | PTE_USER;
+            /* also propagate writability if requested */
+            if (flags & PTE_WRITABLE) pde |= PTE_WRITABLE;
+            ent_set(pd, pdi, pde);
+        }
+
+        /* Todas las entradas de esta tabla de una vez */
+        for (; pti < g_pt_entries && done < count; pti++, done++) {
+            phys_addr_t f = frames ? frames[done] : phys + done * PAGE_SIZE;
+            if (ent_get(table, pti) & PTE_PRESENT) stale++;
+            ent_set(table, pti, PTE_ADDR(f) | flags | PTE_PRESENT);
+        }
+        pt_unmap(table);
+    }
+    pd_unmap(dir, pd);
+
+    flush_range(dir, virt, done, stale);
+    return done;
 }
 
 void vmm_map_page(page_directory_t* dir,
-                  uint32_t virt, uint32_t phys,
+                  uint32_t virt, phys_addr_t phys,
                   uint32_t flags)
 {
-    uint32_t pdi = virt >> 22;          /* bits 31:22 = índice en PD */
-    uint32_t pti = (virt >> 12) & 0x3FF; /* bits 21:12 = índice en PT */
-    /* if PDE already exists and we're requesting user access, make sure
-     * the PDE itself is user-accessible (U bit).  vmm_create_directory
-     * copies kernel PDEs with U=0, so without this the PTE U bit would be
-     * ignored and Ring 3 accesses will PF. */
-    pde_t pde = dir->entries[pdi];
-    if ((pde & PTE_PRESENT) && (flags & PTE_USER)) {
-        dir->entries[pdi] |= PTE_USER;
-        /* also propagate writability if requested */
-        if (flags & PTE_WRITABLE) dir->entries[pdi] |= PTE_WRITABLE;
+    map_pages(dir, virt & ~0xFFF, NULL, phys, 1, flags);
+}
+
+int vmm_map_range(page_directory_t* dir, uint32_t virt, phys_addr_t phys,
+                  uint32_t size, uint32_t flags)
+{
+    uint32_t pages = PAGE_ALIGN(size) / PAGE_SIZE;
+    return map_pages(dir, virt & ~0xFFF, NULL, PTE_ADDR(phys),
+                     pages, flags) == pages ? 0 : -1;
+}
+
+int vmm_map_frames(page_directory_t* dir, uint32_t virt,
+                   const uint32_t* frames, uint32_t count, uint32_t flags)
+{
+    if (!frames) return -1;
+    return map_pages(dir, virt & ~0xFFF, frames, 0,
+                     count, flags) == count ? 0 : -1;
+}
+
+void vmm_unmap_range(page_directory_t* dir, uint32_t virt, uint32_t size)
+{
+    uint32_t pages = PAGE_ALIGN(size) / PAGE_SIZE;
+    uint32_t done = 0, stale = 0;
+    void* pd = pd_map(dir);
+
+    virt &= ~0xFFF;
+    if (!pd) return;
+
+    while (done < pages) {
+        uint32_t va  = virt + done * PAGE_SIZE;
+        uint32_t pdi = PDI(va);
+        uint32_t pti = PTI(va);
+        uint32_t n   = g_pt_entries - pti;
+        pde_t pde    = ent_get(pd, pdi);
+
+        if (n > pages - done) n = pages - done;
+
+        /* sin tabla no hay nada que quitar; las páginas grandes del
+         * kernel no se desmapean */
+        if ((pde & PTE_PRESENT) && !(pde & PTE_PS)) {
+            void* table = pt_map(dir, pdi, pde);
+            if (table) {
+                for (uint32_t i = 0; i < n; i++) {
+                    if (ent_get(table, pti + i) & PTE_PRESENT) stale++;
+                    ent_set(table, pti + i, 0);
+                }
+                pt_unmap(table);
+            }
+        }
+        done += n;
     }
-    page_table_t* table = get_or_create_table(dir, pdi,
-                              flags | PTE_PRESENT | PTE_WRITABLE);
-    if (!table) return;
+    pd_unmap(dir, pd);
 
-    table->entries[pti] = (phys & ~0xFFF) | flags | PTE_PRESENT;
-    tlb_flush(virt);
+    flush_range(dir, virt, pages, stale);
 }
 
 void vmm_unmap_page(page_directory_t* dir, uint32_t virt)
 {
-    uint32_t pdi = virt >> 22;
-    uint32_t pti = (virt >> 12) & 0x3FF;
+    vmm_unmap_range(dir, virt, PAGE_SIZE);
+}
+
+void vmm_get_tlb_stats(vmm_tlb_stats_t* out)
+{
+    if (!out) return;
+    *out = g_tlb_stats;
+}
+
+pte_t vmm_get_pte(page_directory_t* dir, uint32_t virt)
+{
+    uint32_t pdi = PDI(virt);
+    void* pd = pd_map(dir);
+    void* table;
+    pte_t pte = 0;
+    pde_t pde;
+    if (!pd) return 0;
+
+    pde = ent_get(pd, pdi);
+    pd_unmap(dir, pd);
+    if (!(pde & PTE_PRESENT) || pdi >= g_kmap_pdi) return 0;
+
+    /* Página grande: sintetizar el PTE de 4KB equivalente */
+    if (pde & PTE_PS) {
+        uint32_t span = (1u << g_pd_shift) - 1;
+        return ((PTE_ADDR(pde) & ~(phys_addr_t)span) + (virt & span & ~0xFFF)) |
+               (pde & (PTE_PRESENT | PTE_WRITABLE | PTE_USER | PTE_ACCESSED |
+                       PTE_DIRTY | PTE_GLOBAL));
+    }
+
+    table = pt_map(dir, pdi, pde);
+    if (!table) return 0;
+    pte = ent_get(table, PTI(virt));
+    pt_unmap(table);
+
+    /* Permisos efectivos: U y W deben estar en PDE y PTE */
+    if (!(pde & PTE_USER))     pte &= ~(pte_t)PTE_USER;
+    if (!(pde & PTE_WRITABLE)) pte &= ~(pte_t)PTE_WRITABLE;
+    return pte;
+}
+
+pte_t vmm_update_pte(page_directory_t* dir, uint32_t virt,
+                     pte_t clear, pte_t set)
+{
+    uint32_t pdi = PDI(virt);
+    void* pd = pd_map(dir);
+    void* table;
+    pte_t old;
+    pde_t pde;
+
+    if (!pd) return 0;
+    pde = ent_get(pd, pdi);
+    pd_unmap(dir, pd);
+    if (!(pde & PTE_PRESENT) || (pde & PTE_PS) || pdi >= g_kmap_pdi)
+        return 0;
 
-    pde_t pde = dir->entries[pdi];
-    if (!(pde & PTE_PRESENT)) return;
+    table = pt_map(dir, pdi, pde);
+    if (!table) return 0;
+    old = ent_get(table, PTI(virt));
+    ent_set(table, PTI(virt), (old & ~clear) | set);
+    pt_unmap(table);
 
-    page_table_t* table = (page_table_t*)(pde & ~0xFFF);
-    table->entries[pti] = 0;
-    tlb_flush(virt);
+    flush_range(dir, virt & ~0xFFF, 1, (old & PTE_PRESENT) ? 1 : 0);
+    return old;
+}
+
+pte_t vmm_kernel_pte(uint32_t virt)
+{
+    uint32_t pdi = PDI(virt);
+    void* pd = (void*)g_pd_virt;
+
+    if (!g_paging_on || pdi >= g_kmap_pdi) return 0;
+    /* Las tablas del kernel también están en el directorio actual (o
+     * se copian ahora): se leen por el slot recursivo, sin kmap */
+    if (!(ent_get(pd, pdi) & PTE_PRESENT) && !vmm_sync_kernel_pde(virt))
+        return 0;
+    if (ent_get(pd, pdi) & PTE_PS) return 0;
+    return ent_get((void*)g_pt_base, virt >> 12);
 }
 
 void vmm_load_directory(page_directory_t* dir)
@@ -160,27 +841,93 @@ void vmm_load_directory(page_directory_t* dir)
     write_cr3((uint32_t)dir);
 }
 
+int vmm_pae_capable(void)
+{
+    uint32_t edx;
+    cpu_cpuid(1, NULL, NULL, NULL, &edx);
+    return (edx & CPUID_EDX_PAE) != 0;
+}
+
 void vmm_init(void)
 {
-    uint32_t phys;
-    uint32_t addr;
+    uint32_t phys, edx, pdi, cr4;
+    uint32_t user_lo, user_hi, global = 0, large;
+    void* pd;
+
+    /* ¿Páginas grandes / globales / PAE? */
+    cpu_cpuid(1, NULL, NULL, NULL, &edx);
+    if (edx & CPUID_EDX_PSE) g_features |= VMM_FEAT_PSE;
+    if (edx & CPUID_EDX_PGE) g_features |= VMM_FEAT_PGE;
+    if (g_features & VMM_FEAT_PGE) global = PTE_GLOBAL;
+
+    /* PAE solo si hay frames sobre 4GB que aprovechar: sin ellos las
+     * tablas de 8 bytes solo gastarían el doble de memoria y de TLB */
+    if ((edx & CPUID_EDX_PAE) && pmm_highmem_frames()) {
+        g_pae        = 1;
+        g_features  |= VMM_FEAT_PAE;
+        g_pd_shift   = 21;
+        g_pd_entries = PAE_PDS * 512;
+        g_pt_entries = 512;
+        g_pd_pages   = PAE_PDS;
+        g_kmap_pdi   = VMM_KMAP_BASE >> 21;
+        g_self_pdi   = PAE_SELF_PDI;
+        g_pt_base    = 0xFF800000;
+        g_pd_virt    = g_pt_base + PAE_SELF_PDI * PAGE_SIZE;
+    }
+    /* Con PAE los PDEs de 2MB no necesitan PSE */
+    large = g_pae || (g_features & VMM_FEAT_PSE);
+
+    /*
+     * Allocar el directorio del kernel (paginación apagada: las direcciones
+     * físicas se usan directamente). Con PAE los 4 PDs van contiguos para
+     * verlos como un directorio plano antes de tener los slots recursivos.
+     */
+    if (g_pae) {
+        uint32_t pds = pmm_alloc_pages(2);
+        uint64_t* pdpt;
 
-    /* Allocar el page directory del kernel */
-    phys = pmm_alloc_frame();
+        phys = pmm_alloc_zeroed_frame();
+        pdpt = (uint64_t*)phys;
+        for (uint32_t i = 0; i < PAE_PDS * PAGE_SIZE / 4; i++)
+            ((uint32_t*)pds)[i] = 0;
+        for (int i = 0; i < PAE_PDS; i++) {
+            pdpt[i] = (pds + i * PAGE_SIZE) | PTE_PRESENT;
+            page_set(pds + i * PAGE_SIZE,
+                     PG_PAGETABLE | PG_KERNEL | PG_PINNED, 0);
+        }
+        pd = (void*)pds;
+    } else {
+        phys = pmm_alloc_zeroed_frame();
+        pd = (void*)phys;
+    }
     g_kernel_dir = (page_directory_t*)phys;
 
-    /* Limpiar */
-    for (int i = 0; i < 1024; i++)
-        g_kernel_dir->entries[i] = 0;
+    /* PDEs que contienen código/datos de usuario (ver cabecera) */
+    user_lo = (uint32_t)&_user_start >> g_pd_shift;
+    user_hi = ((uint32_t)&_user_end - 1) >> g_pd_shift;
 
     /*
-     * Identity map: 0x00000000 → 0x07FFFFFF (128 MB)
-     * Esto cubre: BIOS, kernel image, heap, pilas de kernel.
+     * Identity map: 0x00000000 → PMM_DIRECT_LIMIT (128 MB)
+     * Esto cubre: BIOS, kernel image, heap, pilas de kernel, bitmap del PMM.
      * virt == phys para todo lo que ya corre en el kernel.
+     * Con PSE (o PAE): un PDE grande por cada 4MB (2MB); sin ellas: page
+     * tables de 4KB llenadas directamente (sin un invlpg por página).
      */
-    for (addr = 0; addr < 0x08000000; addr += PAGE_SIZE) {
-        vmm_map_page(g_kernel_dir, addr, addr,
-                     PTE_PRESENT | PTE_WRITABLE);
+    for (pdi = 0; pdi < ((uint32_t)PMM_DIRECT_LIMIT >> g_pd_shift); pdi++) {
+        int overlay = pdi >= user_lo && pdi <= user_hi;
+        uint32_t base = pdi << g_pd_shift;
+
+        if (large && !overlay) {
+            ent_set(pd, pdi, base | PTE_PRESENT | PTE_WRITABLE | PTE_PS | global);
+            continue;
+        }
+        void* pt = get_or_create_table(g_kernel_dir, pd, pdi,
+                                       PTE_PRESENT | PTE_WRITABLE);
+        if (!pt) continue;
+        for (uint32_t j = 0; j < g_pt_entries; j++)
+            ent_set(pt, j, (base + j * PAGE_SIZE) | PTE_PRESENT |
+                    PTE_WRITABLE | (overlay ? 0 : global));
+        pt_unmap(pt);
     }
 
     /*
@@ -190,9 +937,51 @@ void vmm_init(void)
      * lo dejamos documentado explícitamente.
      */
 
+    /* Ventana kmap (tablas vacías, solo kernel: 2 con PAE) y slots
+     * recursivos (el directorio, o los 4 PDs) */
+    for (uint32_t i = 0; i < VMM_KMAP_SLOTS / g_pt_entries; i++)
+        ent_set(pd, g_kmap_pdi + i,
+                pmm_alloc_zeroed_frame() | PTE_PRESENT | PTE_WRITABLE);
+    for (uint32_t i = 0; i < g_pd_pages; i++)
+        ent_set(pd, g_self_pdi + i,
+                (g_pae ? (uint32_t)pd + i * PAGE_SIZE : phys) |
+                PTE_PRESENT | PTE_WRITABLE);
+
+    /* El directorio y las tablas del kernel no se liberan nunca */
+    page_set(phys, PG_PAGETABLE | PG_KERNEL | PG_PINNED, 0);
+    for (uint32_t i = 0; i < g_self_pdi; i++) {
+        pde_t pde = ent_get(pd, i);
+        if ((pde & PTE_PRESENT) && !(pde & PTE_PS))
+            page_set(PTE_ADDR(pde), PG_PAGETABLE | PG_KERNEL | PG_PINNED, 0);
+    }
+
+    /* CR4 antes de activar paginación: PAE (o PSE, hay PDEs con PS) y
+     * PGE para que los mappings globales sobrevivan a las recargas de CR3 */
+    cr4 = read_cr4();
+    if (g_pae) cr4 |= CR4_PAE;
+    else if (g_features & VMM_FEAT_PSE) cr4 |= CR4_PSE;
+    if (g_features & VMM_FEAT_PGE) cr4 |= CR4_PGE;
+    write_cr4(cr4);
+
     /* Activar paginación cargando CR3 y poniendo bit PG en CR0 */
     write_cr3((uint32_t)g_kernel_dir);
     enable_paging();
+    g_paging_on = 1;
+
+    serial_puts("[vmm] identity map con paginas de ");
+    serial_puts(g_pae ? "2MB" : (g_features & VMM_FEAT_PSE) ? "4MB" : "4KB");
+    serial_puts((g_features & VMM_FEAT_PGE) ? " globales" : "");
+    if (g_pae) {
+        serial_puts(", PAE (");
+        serial_print_dec(pmm_highmem_frames() / 256);
+        serial_puts(" MB sobre 4GB)");
+    }
+    serial_puts("\r\n");
+}
+
+uint32_t vmm_get_features(void)
+{
+    return g_features;
 }
 
 page_directory_t* vmm_get_kernel_directory(void)
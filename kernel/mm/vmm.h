@@ -1,19 +1,40 @@
 /*
- * vmm.h — Virtual Memory Manager (x86 paginación de 2 niveles)
+ * vmm.h — Virtual Memory Manager (x86: 2 niveles, o 3 con PAE)
  *
- * x86 protected mode paging:
+ * x86 protected mode paging clásico:
  *   CR3 → Page Directory (1024 entradas × 4 bytes = 4KB)
  *   Cada PDE → Page Table (1024 entradas × 4 bytes = 4KB)
  *   Cada PTE → Frame físico de 4KB
  *   Total: 1024 × 1024 × 4KB = 4GB de espacio virtual
  *
+ * Con PAE (si CPUID lo anuncia y hay RAM por encima de 4GB):
+ *   CR3 → PDPT (4 entradas, una por GB)
+ *   Cada PDPTE → Page Directory (512 entradas × 8 bytes)
+ *   Cada PDE → Page Table (512 entradas × 8 bytes) o página de 2MB
+ *   Frames de hasta 52 bits: los procesos pueden usar RAM sobre 4GB
+ * vmm.c ve los 4 page directories como uno solo de 2048 PDEs (índice
+ * virt >> 21), así que el resto del código no distingue los modos.
+ *
  * Layout virtual de cada proceso:
  *   0x00000000 - 0x003FFFFF  →  [NO USAR — null guard]
- *   0x00400000 - 0x7FFEFFFF  →  Código + datos de usuario (Ring 3)
+ *   0x00400000 - 0x7FFEFFFF  →  Código + datos de usuario (Ring 3); el
+ *                               heap (brk) desde 0x10000000 y SYS_MMAP en
+ *                               0x40000000 - 0x7EFFFFFF (ver vma.h); el
+ *                               shadow de la pantalla, si se pidió, en
+ *                               0x7F000000 (solo lectura)
  *   0x7FFF0000 - 0x7FFFFFFF  →  Stack de usuario
- *   0x80000000 - 0x9FFFFFFF  →  [reservado futuro]
- *   0xA0000000 - 0xA000FFFF  →  VGA framebuffer (identity mapped, kernel only)
- *   0xC0000000 - 0xFFFFFFFF  →  Kernel (identity mapped)
+ *   0x80000000 - 0xCFFFFFFF  →  [reservado futuro]
+ *   0xD0000000 - 0xD7FFFFFF  →  vmalloc (kernel, frames sueltos; vmalloc.h)
+ *   0xD8000000 - 0xDFFFFFFF  →  Heap del kernel (kmalloc; crece por páginas)
+ *   0xE0000000 - 0xFF3FFFFF  →  [reservado futuro]
+ *   0xFF400000 - 0xFF7FFFFF  →  Ventana de mapeos temporales (vmm_kmap)
+ *   0xFF800000 - 0xFFFFFFFF  →  Page tables del directorio actual (slots
+ *                               recursivos): sin PAE solo 0xFFC00000+, el
+ *                               PD en 0xFFFFF000; con PAE los 4 PDs en
+ *                               0xFFFFC000
+ *
+ * page_directory_t* es la dirección FÍSICA del directorio (del PDPT con
+ * PAE), siempre por debajo de 4GB: solo vmm.c accede a su contenido.
  */
 #ifndef _VMM_H
 #define _VMM_H
@@ -26,40 +47,142 @@
 #define PTE_USER        (1 << 2)   /* Accesible desde Ring 3 */
 #define PTE_ACCESSED    (1 << 5)
 #define PTE_DIRTY       (1 << 6)
+#define PTE_PS          (1 << 7)   /* PDE: página de 4MB (CR4.PSE) o 2MB (PAE) */
+#define PTE_GLOBAL      (1 << 8)   /* no se invalida al recargar CR3 (CR4.PGE) */
+#define PTE_COW         (1 << 9)   /* bit libre del SO: copy-on-write (R/O hasta el #PF) */
+#define PTE_SWAP        (1 << 10)  /* PTE no presente: página en swap, slot en bits 12-31 */
 
-/* ── Tipos ──────────────────────────────────────────────────────────────── */
-typedef uint32_t pde_t;   /* Page Directory Entry */
-typedef uint32_t pte_t;   /* Page Table Entry     */
+/* Frame de una entrada (bits 12-51; sin PAE solo hay 12-31) */
+#define PTE_ADDR_MASK   0x000FFFFFFFFFF000ULL
+#define PTE_ADDR(e)     ((phys_addr_t)((e) & PTE_ADDR_MASK))
 
-/* Page Directory: 1024 PDEs, alineado a 4KB */
-typedef struct {
-    pde_t entries[1024];
-} __attribute__((aligned(4096))) page_directory_t;
+/* ── Ventana de mapeos temporales ───────────────────────────────────────── */
+#define VMM_KMAP_BASE   0xFF400000
+#define VMM_KMAP_SLOTS  1024
 
-/* Page Table: 1024 PTEs, alineado a 4KB */
-typedef struct {
-    pte_t entries[1024];
-} __attribute__((aligned(4096))) page_table_t;
+/* ── Tipos ──────────────────────────────────────────────────────────────── */
+/* Valor de una entrada: 64 bits para servir a los dos modos (sin PAE la
+ * mitad alta es 0); en memoria las tablas son de 4 u 8 bytes por entrada */
+typedef uint64_t pde_t;   /* Page Directory Entry */
+typedef uint64_t pte_t;   /* Page Table Entry     */
+
+/* Opaco: el puntero es una dirección física, nunca se desreferencia */
+typedef struct _page_directory page_directory_t;
 
 /* ── API ────────────────────────────────────────────────────────────────── */
 
-/* Crear un nuevo page directory vacío (todo no-presente) */
+/* Crear un page directory para un proceso: comparte las page tables del
+ * kernel (supervisor-only) y no tiene nada de usuario mapeado */
 page_directory_t* vmm_create_directory(void);
 
+/* Liberar un page directory y sus page tables propias. Los frames
+ * mapeados NO se liberan: el dueño debe soltarlos antes. No usar con el
+ * directorio cargado en CR3. */
+void vmm_destroy_directory(page_directory_t* dir);
+
+/* Frames de paginación propios de dir: el directorio (PDPT y sus 4 PDs
+ * con PAE) y las page tables que vmm_destroy_directory liberaría. 0 para
+ * el directorio del kernel. */
+uint32_t vmm_count_tables(page_directory_t* dir);
+
+/*
+ * Duplicar el espacio de usuario de src para un fork: directorio nuevo con
+ * copia de las page tables propias de src (las del kernel se comparten).
+ * Las páginas de usuario escribibles pasan a solo lectura + PTE_COW en
+ * ambos directorios y cada frame de usuario gana una referencia
+ * (page_get); la copia real se hace en el primer #PF de escritura.
+ * Retorna NULL si no hay memoria (src puede quedar con páginas COW, que
+ * el #PF vuelve a hacer escribibles sin copiar).
+ */
+page_directory_t* vmm_fork_directory(page_directory_t* src);
+
 /* Mapear virt → phys en un page directory con los flags dados */
 void vmm_map_page(page_directory_t* dir,
-                  uint32_t virt, uint32_t phys,
+                  uint32_t virt, phys_addr_t phys,
                   uint32_t flags);
 
 /* Deshacer el mapeo de una dirección virtual */
 void vmm_unmap_page(page_directory_t* dir, uint32_t virt);
 
+/*
+ * Mapeo por rangos: escriben los PTEs de cada page table de una pasada y
+ * difieren la invalidación del TLB al final. Si el directorio no está
+ * cargado no se invalida nada; si hay más de VMM_FLUSH_THRESHOLD páginas
+ * que estaban presentes se recarga CR3 una vez en vez de hacer invlpg.
+ * Retornan 0 o -1 si faltó memoria para alguna page table.
+ */
+#define VMM_FLUSH_THRESHOLD 32
+
+/* [virt, virt+size) → [phys, phys+size) contiguo */
+int  vmm_map_range(page_directory_t* dir, uint32_t virt, phys_addr_t phys,
+                   uint32_t size, uint32_t flags);
+
+/* count páginas desde virt → frames[0..count-1] (p.ej. de pmm_alloc_batch) */
+int  vmm_map_frames(page_directory_t* dir, uint32_t virt,
+                    const uint32_t* frames, uint32_t count, uint32_t flags);
+
+/* Quitar [virt, virt+size); los frames no se liberan */
+void vmm_unmap_range(page_directory_t* dir, uint32_t virt, uint32_t size);
+
+/* Contadores de invalidaciones del TLB */
+typedef struct {
+    uint32_t invlpg;        /* invlpg emitidos */
+    uint32_t full_flushes;  /* recargas de CR3 en lugar de invlpg */
+    uint32_t avoided;       /* páginas cuya invalidación se evitó */
+} vmm_tlb_stats_t;
+
+void vmm_get_tlb_stats(vmm_tlb_stats_t* out);
+
+/* PTE que traduce virt en dir (0 si no está mapeada). U y W reflejan los
+ * permisos efectivos (PDE y PTE). */
+pte_t vmm_get_pte(page_directory_t* dir, uint32_t virt);
+
+/*
+ * Cambiar bits del PTE de virt en dir: se quitan los de clear y se ponen
+ * los de set (clear = VMM_PTE_ALL reemplaza la entrada entera). La page
+ * table tiene que existir. Invalida el TLB si la entrada anterior estaba
+ * presente y dir está cargado. Retorna el PTE anterior (0 sin tabla).
+ */
+#define VMM_PTE_ALL  (~(pte_t)0)
+
+pte_t vmm_update_pte(page_directory_t* dir, uint32_t virt,
+                     pte_t clear, pte_t set);
+
+/* PTE de una dirección del kernel fuera del identity map (vmalloc, heap)
+ * leído por el slot recursivo del directorio actual: más barato que
+ * vmm_get_pte(kernel_dir, ...). 0 si no está mapeada. */
+pte_t vmm_kernel_pte(uint32_t virt);
+
+/* Mapear temporalmente un frame físico cualquiera (también sobre 4GB con
+ * PAE) en la ventana kmap del kernel. Retorna la dirección virtual o NULL
+ * si la ventana está llena. Soltar cuanto antes con vmm_kunmap(). */
+void* vmm_kmap(phys_addr_t phys);
+void  vmm_kunmap(void* virt);
+
 /* Activar un page directory (cargar en CR3 + activar paginación si no está) */
 void vmm_load_directory(page_directory_t* dir);
 
-/* Inicializar VMM: crear y activar el page directory del kernel */
+/* Inicializar VMM: crear y activar el page directory del kernel. Elige
+ * PAE si la CPU lo tiene y el PMM gestiona memoria sobre 4GB. */
 void vmm_init(void);
 
+/* ¿Tiene la CPU PAE? (CPUID; lo consulta pmm_init() antes de vmm_init()
+ * para saber si vale la pena tomar la RAM por encima de 4GB) */
+int vmm_pae_capable(void);
+
+/* Características de paginación detectadas por vmm_init() */
+#define VMM_FEAT_PSE    (1 << 0)
+#define VMM_FEAT_PGE    (1 << 1)
+#define VMM_FEAT_PAE    (1 << 2)   /* 3 niveles, PTEs de 64 bits */
+uint32_t vmm_get_features(void);
+
+/*
+ * Copiar al directorio actual el PDE de virt que el kernel creó después
+ * de crear ese directorio (p.ej. una tabla nueva de vmalloc). Lo llama
+ * el #PF: retorna 1 si el PDE faltaba y ahora está.
+ */
+int vmm_sync_kernel_pde(uint32_t virt);
+
 /* Obtener el page directory del kernel (para copiar mappings en nuevos procesos) */
 page_directory_t* vmm_get_kernel_directory(void);
 
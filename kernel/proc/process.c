@@ -4,17 +4,25 @@
 #include "process.h"
 #include "../mm/pmm.h"
 #include "../mm/vmm.h"
+#include "../mm/page.h"
+#include "../mm/lookaside.h"
 #include <types.h>
 
 /* Forward declaration para evitar dependencia circular con scheduler.h */
 extern void scheduler_add_thread(thread_t* t);
+extern void scheduler_remove_thread(thread_t* t);
 
 /* memset desde lib */
 extern void* memset(void*, int, size_t);
 
 /* ── Tablas globales ────────────────────────────────────────────────────── */
-static process_t g_processes[MAX_PROCESSES];
-static thread_t  g_threads[MAX_THREADS];
+/* Los PCB/TCB salen de listas lookaside; las tablas solo registran los
+ * vivos para buscarlos por PID */
+static process_t* g_processes[MAX_PROCESSES];
+static thread_t*  g_threads[MAX_THREADS];
+
+static lookaside_list_t g_process_list;
+static lookaside_list_t g_thread_list;
 
 static uint32_t  g_next_pid = 1;
 static uint32_t  g_next_tid = 1;
@@ -22,40 +30,94 @@ static uint32_t  g_next_tid = 1;
 /* Thread actualmente en ejecución (actualizado por el scheduler) */
 static thread_t* g_current_thread = NULL;
 
+/* ── Constructores de la lookaside de threads ──────────────────────────── */
+
+/*
+ * Un thread_t de la lista ya trae su stack de kernel: KERNEL_STACK_SIZE
+ * bytes físicamente contiguos del buddy, que se quedan con el objeto
+ * mientras circula por la lista. Crear y destruir threads en racha no
+ * toca ni kmalloc ni el buddy.
+ */
+static int thread_ctor(void* obj)
+{
+    thread_t* t = (thread_t*)obj;
+    uint32_t kstack = pmm_alloc_pages(PMM_ORDER_FOR(KERNEL_STACK_SIZE));
+    if (!kstack) return -1;
+    for (uint32_t off = 0; off < KERNEL_STACK_SIZE; off += PAGE_SIZE)
+        page_set(kstack + off, PG_KERNEL | PG_PINNED, 0);
+    t->kernel_stack_base = kstack;
+    t->kernel_stack_top  = kstack + KERNEL_STACK_SIZE;
+    return 0;
+}
+
+static void thread_dtor(void* obj)
+{
+    thread_t* t = (thread_t*)obj;
+    pmm_free_pages(t->kernel_stack_base, PMM_ORDER_FOR(KERNEL_STACK_SIZE));
+}
+
 /* ── Helpers internos ───────────────────────────────────────────────────── */
 
 static process_t* alloc_process(void)
 {
     for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (!g_processes[i].active) {
-            memset(&g_processes[i], 0, sizeof(process_t));
-            g_processes[i].active = 1;
-            g_processes[i].pid    = g_next_pid++;
-            return &g_processes[i];
+        if (!g_processes[i]) {
+            process_t* p = ExAllocateFromLookasideList(&g_process_list);
+            if (!p) return NULL;
+            memset(p, 0, sizeof(process_t));
+            p->active = 1;
+            p->pid    = g_next_pid++;
+            g_processes[i] = p;
+            return p;
         }
     }
     return NULL;
 }
 
+/* Deshacer alloc_process() (rutas de error de la creación) */
+static void free_process(process_t* p)
+{
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (g_processes[i] == p) {
+            g_processes[i] = NULL;
+            break;
+        }
+    }
+    p->active = 0;
+    ExFreeToLookasideList(&g_process_list, p);
+}
+
+/* Thread con tid nuevo y su stack de kernel ya reservado (thread_ctor) */
 static thread_t* alloc_thread(void)
 {
     for (int i = 0; i < MAX_THREADS; i++) {
-        if (g_threads[i].state == THREAD_DEAD &&
-            g_threads[i].tid == 0) {
-            memset(&g_threads[i], 0, sizeof(thread_t));
-            g_threads[i].tid = g_next_tid++;
-            return &g_threads[i];
+        if (!g_threads[i]) {
+            thread_t* t = ExAllocateFromLookasideList(&g_thread_list);
+            uint32_t base, top;
+            if (!t) return NULL;
+            base = t->kernel_stack_base;
+            top  = t->kernel_stack_top;
+            memset(t, 0, sizeof(thread_t));
+            t->kernel_stack_base = base;
+            t->kernel_stack_top  = top;
+            t->tid = g_next_tid++;
+            g_threads[i] = t;
+            return t;
         }
     }
-    /* Buscar slot nunca usado (tid == 0) */
+    return NULL;
+}
+
+/* Deshacer alloc_thread(): el stack de kernel vuelve a la lista con el objeto */
+static void free_thread(thread_t* t)
+{
     for (int i = 0; i < MAX_THREADS; i++) {
-        if (g_threads[i].tid == 0) {
-            memset(&g_threads[i], 0, sizeof(thread_t));
-            g_threads[i].tid = g_next_tid++;
-            return &g_threads[i];
+        if (g_threads[i] == t) {
+            g_threads[i] = NULL;
+            break;
         }
     }
-    return NULL;
+    ExFreeToLookasideList(&g_thread_list, t);
 }
 
 /*
@@ -157,10 +219,13 @@ static cpu_context_t* setup_user_stack(uint32_t kstack_top,
 /* ── Proceso idle del kernel ────────────────────────────────────────────── */
 static void kernel_idle(void)
 {
-    /* El proceso idle solo cede la CPU continuamente.
-     * Corre cuando no hay ningún otro thread READY. */
+    /* El proceso idle corre cuando no hay ningún otro thread READY.
+     * Antes de dormir aprovecha para rellenar el pool de frames
+     * pre-zeroed; si ya está lleno va directo a hlt. */
     while (1) {
-        __asm__ volatile("sti; hlt");
+        __asm__ volatile("sti");
+        pmm_zero_pool_refill(PMM_ZERO_REFILL);
+        __asm__ volatile("hlt");
     }
 }
 
@@ -171,6 +236,10 @@ void proc_init(void)
     /* Limpiar tablas */
     memset(g_processes, 0, sizeof(g_processes));
     memset(g_threads,   0, sizeof(g_threads));
+    ExInitializeLookasideList(&g_process_list, NULL, NULL,
+                              sizeof(process_t), LOOKASIDE_TAG('P','r','o','c'), MAX_PROCESSES);
+    ExInitializeLookasideList(&g_thread_list, thread_ctor, thread_dtor,
+                              sizeof(thread_t), LOOKASIDE_TAG('T','h','r','e'), MAX_THREADS);
 
     /* Crear el proceso idle (PID 0 — siempre listo) */
     process_t* idle = alloc_process();
@@ -192,11 +261,6 @@ void proc_init(void)
     t->quantum   = 1;
     t->state     = THREAD_READY;
 
-    /* Stack del kernel para el idle */
-    uint32_t kstack = pmm_alloc_frame();
-    t->kernel_stack_base = kstack;
-    t->kernel_stack_top  = kstack + PAGE_SIZE;
-
     t->saved_context = setup_kernel_stack(t->kernel_stack_top, kernel_idle);
 
     idle->main_thread = t;
@@ -218,16 +282,13 @@ process_t* proc_create_kernel(const char* name, void (*entry_point)(void))
 
     /* Thread principal */
     thread_t* t = alloc_thread();
-    if (!t) { proc->active = 0; return NULL; }
+    if (!t) { free_process(proc); return NULL; }
 
     t->pid       = proc->pid;
     t->privilege = PRIVILEGE_KERNEL;
     t->quantum   = 5;
     t->state     = THREAD_READY;
 
-    uint32_t kstack = pmm_alloc_frame();
-    t->kernel_stack_base = kstack;
-    t->kernel_stack_top  = kstack + PAGE_SIZE;
     t->saved_context = setup_kernel_stack(t->kernel_stack_top, entry_point);
 
     proc->main_thread = t;
@@ -238,6 +299,46 @@ process_t* proc_create_kernel(const char* name, void (*entry_point)(void))
     return proc;
 }
 
+/*
+ * Soltar el espacio de usuario de proc: VMAs (frames y slots de swap),
+ * las referencias a la imagen y al shadow, y el directorio con sus page
+ * tables. Lo usan proc_destroy y las rutas de error de la creación.
+ */
+static void release_user_space(process_t* proc)
+{
+    if (!proc->page_dir) return;
+
+    /* Memoria de demanda: frames residentes y slots de swap */
+    while (proc->vm.count) {
+        vma_t* r = &proc->vm.area[0];
+        if (vma_remove(&proc->vm, proc->page_dir, r->start,
+                       r->end - r->start) != 0)
+            break;
+    }
+
+    /* Imagen: la referencia que tomó proc_create_user (o el fork) */
+    for (uint32_t p = 0; p < proc->image_pages; p++) {
+        pte_t pte = vmm_get_pte(proc->page_dir,
+                                proc->image_base + p * PAGE_SIZE);
+        if ((pte & PTE_PRESENT) && (pte & PTE_USER))
+            page_put(PTE_ADDR(pte));
+    }
+    vmm_unmap_range(proc->page_dir, proc->image_base,
+                    proc->image_pages * PAGE_SIZE);
+
+    /* Shadow de la pantalla: igual, una referencia por página */
+    for (uint32_t p = 0; p < proc->shadow_pages; p++) {
+        pte_t pte = vmm_get_pte(proc->page_dir,
+                                USER_SHADOW_BASE + p * PAGE_SIZE);
+        if ((pte & PTE_PRESENT) && (pte & PTE_USER))
+            page_put(PTE_ADDR(pte));
+    }
+    vmm_unmap_range(proc->page_dir, USER_SHADOW_BASE,
+                    proc->shadow_pages * PAGE_SIZE);
+    vmm_destroy_directory(proc->page_dir);
+    proc->page_dir = NULL;
+}
+
 process_t* proc_create_user(const char* name,
                              uint32_t code_phys,
                              uint32_t code_size,
@@ -300,45 +401,59 @@ process_t* proc_create_user(const char* name,
 
     /* Crear page directory propio para este proceso */
     proc->page_dir = vmm_create_directory();
-    if (!proc->page_dir) { proc->active = 0; return NULL; }
+    if (!proc->page_dir) goto fail;
 
     /* Mapear el código del proceso en el espacio de usuario */
     uint32_t virt = entry_virt & ~(PAGE_SIZE - 1);   /* alinear */
     uint32_t phys = code_phys  & ~(PAGE_SIZE - 1);
     uint32_t pages = (code_size + PAGE_SIZE - 1) / PAGE_SIZE;
 
-    for (uint32_t p = 0; p < pages; p++) {
-        /* mapeo de pagina para procesos de usuario
-         * notas:
-         * - Antes marcabamos solo PTE_USER, que deja las paginas como
-         *   read-only. Esto causaba fallos al escribir en .user.data
-         *   (p.ej. el buffer del cursor) porque el slot no era escribible.
-         *   Para la prueba de GUI es más sencillo mapear TODO el espacio
-         *   de usuario como escribible; podemos refinar si queremos
-         *   volver a proteger el codigo.
-         */
-        vmm_map_page(proc->page_dir,
-                     virt + p * PAGE_SIZE,
-                     phys + p * PAGE_SIZE,
-                     PTE_PRESENT | PTE_USER | PTE_WRITABLE);
-    }
-
-    /* Mapear stack de usuario */
-    uint32_t stack_virt = USER_STACK_TOP - USER_STACK_SIZE;
-    uint32_t stack_pages = USER_STACK_SIZE / PAGE_SIZE;
-
-    for (uint32_t p = 0; p < stack_pages; p++) {
-        uint32_t frame = pmm_alloc_frame();
-        if (!frame) { proc->active = 0; return NULL; }
-        vmm_map_page(proc->page_dir,
-                     stack_virt + p * PAGE_SIZE,
-                     frame,
-                     PTE_PRESENT | PTE_WRITABLE | PTE_USER);
+    /* mapeo de las paginas de usuario (un solo rango)
+     * notas:
+     * - Antes marcabamos solo PTE_USER, que deja las paginas como
+     *   read-only. Esto causaba fallos al escribir en .user.data
+     *   (p.ej. el buffer del cursor) porque el slot no era escribible.
+     *   Para la prueba de GUI es más sencillo mapear TODO el espacio
+     *   de usuario como escribible; podemos refinar si queremos
+     *   volver a proteger el codigo.
+     */
+    if (vmm_map_range(proc->page_dir, virt, phys, pages * PAGE_SIZE,
+                      PTE_PRESENT | PTE_USER | PTE_WRITABLE) != 0)
+        goto fail;
+    for (uint32_t p = 0; p < pages; p++)
+        page_get(phys + p * PAGE_SIZE);   /* frame del kernel compartido */
+    proc->image_base  = virt;
+    proc->image_pages = pages;
+
+    /* Stack de usuario: una VMA entera, con las primeras páginas (las de
+     * arriba) ya mapeadas; el resto llega por demand paging */
+    uint32_t stack_pages = USER_STACK_EAGER_PAGES;
+    uint32_t stack_virt  = USER_STACK_TOP - stack_pages * PAGE_SIZE;
+    uint32_t stack_frames[USER_STACK_EAGER_PAGES];
+
+    vma_init(&proc->vm);
+    if (vma_insert(&proc->vm, USER_STACK_TOP - USER_STACK_SIZE,
+                   USER_STACK_SIZE, PTE_WRITABLE, VMA_STACK) != 0)
+        goto fail;
+
+    /* Todos los frames del stack en una sola pasada por el PMM */
+    if (!pmm_alloc_batch(stack_pages, stack_frames))
+        goto fail;
+    for (uint32_t p = 0; p < stack_pages; p++)
+        page_set(stack_frames[p], PG_USER, proc->pid);
+    if (vmm_map_frames(proc->page_dir, stack_virt, stack_frames, stack_pages,
+                       PTE_PRESENT | PTE_WRITABLE | PTE_USER) != 0) {
+        /* lo que llegó a mapearse sale antes de devolver la tanda, para
+         * que vma_remove no vuelva a soltar esos frames */
+        vmm_unmap_range(proc->page_dir, stack_virt, stack_pages * PAGE_SIZE);
+        pmm_free_batch(stack_pages, stack_frames);
+        goto fail;
     }
+    vma_charge(&proc->vm, stack_pages);
 
     /* Thread principal */
     thread_t* t = alloc_thread();
-    if (!t) { proc->active = 0; return NULL; }
+    if (!t) goto fail;
 
     t->pid            = proc->pid;
     t->privilege      = PRIVILEGE_USER;
@@ -346,32 +461,111 @@ process_t* proc_create_user(const char* name,
     t->state          = THREAD_READY;
     t->user_stack_top = USER_STACK_TOP;
 
-    /* Stack del KERNEL para este thread (para manejar syscalls/irqs) */
-    uint32_t kstack = pmm_alloc_frame();
-    t->kernel_stack_base = kstack;
-    t->kernel_stack_top  = kstack + PAGE_SIZE;
+    /* Frame inicial en el stack del KERNEL del thread (el que usan
+     * syscalls/irqs), que ya viene con el objeto */
     t->saved_context = setup_user_stack(t->kernel_stack_top,
                                          entry_virt,
                                          USER_STACK_TOP - 4);
 
     proc->main_thread = t;
 
-    /* Fix: algunas funciones en .user (como user_entry) usan PIC y
-     * llaman a __x86.get_pc_thunk.* situado en la sección .text del
-     * kernel. Esas páginas no están accesibles a Ring 3, provocando
-     * page faults al entrar. Mapeamos explícitamente la página que
-     * contiene el thunk para que el proceso pueda ejecutarlo. */
-    {
-        const uint32_t thunk_addr = 0x00106ccb;
-        uint32_t page = thunk_addr & ~(PAGE_SIZE - 1);
-        vmm_map_page(proc->page_dir, page, page,
-                     PTE_PRESENT | PTE_USER /* no escribible */);
-    }
-
     /* Registrar el thread en la cola del scheduler para que pueda correr */
     scheduler_add_thread(t);
 
     return proc;
+
+fail:
+    release_user_space(proc);
+    free_process(proc);
+    return NULL;
+}
+
+process_t* proc_fork(const cpu_context_t* regs)
+{
+    process_t* parent = proc_current_process();
+    process_t* proc;
+    thread_t* t;
+    cpu_context_t* ctx;
+
+    if (!parent || !regs || parent->privilege != PRIVILEGE_USER)
+        return NULL;
+
+    proc = alloc_process();
+    if (!proc) return NULL;
+
+    for (int i = 0; i < 32; i++) proc->name[i] = parent->name[i];
+    proc->privilege   = PRIVILEGE_USER;
+    proc->vm          = parent->vm;
+    proc->image_base  = parent->image_base;
+    proc->image_pages = parent->image_pages;
+
+    /* La superficie es memoria del proceso: el hijo hereda la suya en COW
+     * y el shadow con una referencia más por página (fork del directorio) */
+    proc->surface_base  = parent->surface_base;
+    proc->surface_pitch = parent->surface_pitch;
+    proc->surface_w     = parent->surface_w;
+    proc->surface_h     = parent->surface_h;
+    proc->surface_x     = parent->surface_x;
+    proc->surface_y     = parent->surface_y;
+    proc->shadow_pages  = parent->shadow_pages;
+
+    /* El hijo cuenta como suyas todas las páginas que comparte en COW
+     * (igual que el padre); su pico empieza en lo que hereda */
+    proc->vm.peak_resident = proc->vm.resident;
+
+    /* El thread antes que el directorio: fallar aquí no deja páginas del
+     * padre en COW ni slots de swap con una referencia de más */
+    t = alloc_thread();
+    if (!t) { free_process(proc); return NULL; }
+
+    /* Mismo espacio de usuario, compartido en copy-on-write */
+    proc->page_dir = vmm_fork_directory(parent->page_dir);
+    if (!proc->page_dir) {
+        free_thread(t);
+        free_process(proc);
+        return NULL;
+    }
+
+    t->pid            = proc->pid;
+    t->privilege      = PRIVILEGE_USER;
+    t->quantum        = 5;
+    t->state          = THREAD_READY;
+    t->user_stack_top = parent->main_thread ? parent->main_thread->user_stack_top
+                                            : USER_STACK_TOP;
+
+
+    /* Retomar donde estaba el padre: mismos registros salvo EAX, que es
+     * el valor de retorno de fork() en el hijo */
+    ctx = setup_user_stack(t->kernel_stack_top, regs->eip, regs->user_esp);
+    ctx->ebx    = regs->ebx;
+    ctx->ecx    = regs->ecx;
+    ctx->edx    = regs->edx;
+    ctx->esi    = regs->esi;
+    ctx->edi    = regs->edi;
+    ctx->ebp    = regs->ebp;
+    ctx->eax    = 0;
+    ctx->eflags = regs->eflags | 0x200;   /* IF siempre activo en Ring 3 */
+    t->saved_context = ctx;
+
+    proc->main_thread = t;
+    scheduler_add_thread(t);
+    return proc;
+}
+
+void proc_destroy(process_t* proc)
+{
+    if (!proc || proc->privilege != PRIVILEGE_USER ||
+        proc == proc_current_process())
+        return;
+
+    if (proc->main_thread) {
+        scheduler_remove_thread(proc->main_thread);
+        free_thread(proc->main_thread);
+        proc->main_thread = NULL;
+    }
+
+    release_user_space(proc);
+    free_process(proc);
 }
 
 void proc_exit(uint32_t exit_code)
@@ -390,8 +584,8 @@ thread_t* proc_current_thread(void)  { return g_current_thread; }
 process_t* proc_get_process_by_pid(uint32_t pid)
 {
     for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (g_processes[i].active && g_processes[i].pid == pid)
-            return &g_processes[i];
+        if (g_processes[i] && g_processes[i]->pid == pid)
+            return g_processes[i];
     }
     return NULL;
 }
@@ -401,8 +595,8 @@ process_t* proc_current_process(void)
     if (!g_current_thread) return NULL;
     uint32_t pid = g_current_thread->pid;
     for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (g_processes[i].active && g_processes[i].pid == pid)
-            return &g_processes[i];
+        if (g_processes[i] && g_processes[i]->pid == pid)
+            return g_processes[i];
     }
     return NULL;
 }
@@ -414,7 +608,12 @@ void proc_set_current_thread(thread_t* t)
 }
 
 /* Getter de la tabla de threads (usado por el scheduler) */
-thread_t* proc_get_thread_table(void)
+thread_t** proc_get_thread_table(void)
 {
     return g_threads;
 }
+
+process_t** proc_get_process_table(void)
+{
+    return g_processes;
+}
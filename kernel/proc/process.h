@@ -18,6 +18,7 @@
 
 #include <types.h>
 #include "../mm/vmm.h"
+#include "../mm/vma.h"
 
 /* ── Límites ────────────────────────────────────────────────────────────── */
 #define MAX_PROCESSES   16
@@ -26,6 +27,10 @@
 #define USER_STACK_TOP     0x7FFF0000
 #define USER_STACK_SIZE    0x10000   /* 64KB de stack de usuario */
 
+/* Páginas del stack de usuario que se mapean al crear el proceso; el
+ * resto del stack se asigna al tocarlo (demand paging) */
+#define USER_STACK_EAGER_PAGES  2
+
 /* ── Niveles de privilegio ──────────────────────────────────────────────── */
 #define PRIVILEGE_KERNEL  0   /* Ring 0 */
 #define PRIVILEGE_USER    3   /* Ring 3 */
@@ -95,6 +100,25 @@ typedef struct _process {
     page_directory_t*   page_dir;       /* espacio de direcciones propio */
     thread_t*           main_thread;
     uint32_t            active;         /* 1 = activo */
+
+    /* Memoria de usuario de demanda (stack, heap, mmap); vm también lleva
+     * las páginas residentes, en swap y el pico (ps, SYS_PROC_INFO) */
+    vma_set_t           vm;
+    uint32_t            minor_faults;   /* #PF resueltos sin I/O */
+    uint32_t            major_faults;   /* #PF que leyeron la página del swap */
+
+    /* Imagen mapeada por proc_create_user (frames del kernel compartidos) */
+    uint32_t            image_base;
+    uint32_t            image_pages;
+
+    /* Superficie de dibujo (SYS_SURFACE_MAP): una VMA anónima del proceso
+     * que se copia a la pantalla en (surface_x, surface_y), y las páginas
+     * del shadow mapeadas en USER_SHADOW_BASE (referencias propias) */
+    uint32_t            surface_base;       /* 0 = sin superficie */
+    uint32_t            surface_pitch;
+    uint32_t            surface_w, surface_h;
+    int32_t             surface_x, surface_y;
+    uint32_t            shadow_pages;
 } process_t;
 
 /* ── API ────────────────────────────────────────────────────────────────── */
@@ -123,6 +147,23 @@ process_t* proc_create_user(const char* name,
                              uint32_t code_size,
                              uint32_t entry_virt);
 
+/*
+ * Duplicar el proceso de usuario actual (SYS_FORK).
+ * regs: estado de Ring 3 del padre en el momento de la syscall.
+ *
+ * El hijo comparte todos los frames de usuario del padre en copy-on-write
+ * (vmm_fork_directory) y hereda sus VMAs y el brk; su thread
+ * continúa en el mismo EIP/ESP con EAX = 0. Retorna el hijo o NULL.
+ */
+process_t* proc_fork(const cpu_context_t* regs);
+
+/*
+ * Liberar un proceso de usuario que no está corriendo: saca su thread del
+ * scheduler y suelta VMAs (frames y slots de swap), la imagen, el
+ * directorio y el PCB. No usar con el proceso actual.
+ */
+void proc_destroy(process_t* proc);
+
 /* Terminar el proceso actual (llamado desde syscall o explícitamente) */
 void proc_exit(uint32_t exit_code);
 
@@ -138,7 +179,11 @@ process_t* proc_get_process_by_pid(uint32_t pid);
 /* Setter usado por el scheduler */
 void proc_set_current_thread(thread_t* t);
 
-/* Getter de la tabla de threads (usado por el scheduler) */
-thread_t* proc_get_thread_table(void);
+/* Getter de la tabla de threads vivos (MAX_THREADS punteros, NULL = libre) */
+thread_t** proc_get_thread_table(void);
+
+/* Getter de la tabla de procesos (MAX_PROCESSES punteros, NULL = libre);
+ * la recorre el reclaim de swap */
+process_t** proc_get_process_table(void);
 
 #endif /* _PROCESS_H */
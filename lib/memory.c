@@ -6,91 +6,139 @@
  */
 
 #include <types.h>
+#include <hal.h>       /* cpu_cpuid, CPUID_EDX_SSE2 */
 
 /*
- * HEAP_START debe estar DESPUES del fin del kernel image.
- * El kernel se carga en 0x00100000 (linker.ld). Sus secciones ocupan:
- *   .text   ~28KB  (EIPs del kernel llegan hasta ~0x107000)
- *   .rodata ~4KB
- *   .data   ~4KB
- *   .bss    ~310KB (incluye g_shadow[640*480] = 300KB)
- * Total kernel ~ 0x56000 bytes -> termina alrededor de 0x156000
+ * El heap del kernel es kmalloc() (kernel/mm/kmalloc.c): slabs por clases
+ * de tamaño en su propio rango virtual. malloc()/free() se mantienen como
+ * nombres para los drivers portados de ReactOS.
  *
- * ANTES era 0x00100000 = MISMA DIRECCION que el inicio del kernel.
- * El primer malloc() sobreescribia la cabecera multiboot y el .text
- * del kernel con ceros -> comportamiento completamente indefinido.
- *
- * 0x00200000 (2MB) es seguro: deja >600KB de margen sobre el kernel
- * y coincide con el comentario de pmm.h ("0x200000-... frames libres").
+ * Antes era un bump allocator sobre una ventana fija de 6MB despues de
+ * _kernel_end, reservada en el PMM, y free() no hacia nada: cada ciclo
+ * IoCreateDevice/IoDeleteDevice perdia memoria para siempre.
  */
-#define HEAP_SIZE  0x00600000  /* 6MB de heap del kernel */
-
-/* _kernel_end es exportado por linker.ld como el primer byte libre
- * despues de todas las secciones del kernel (.text/.rodata/.data/.bss).
- * El heap empieza en el siguiente PAGE_ALIGN para que no haya overlap. */
-extern uint32_t _kernel_end;
-#define PAGE_ALIGN_UP(x) (((x) + 0xFFF) & ~0xFFFu)
-
-static uint32_t heap_current = 0;   /* inicializado en heap_init() */
-static uint32_t heap_end     = 0;
+extern void kmalloc_init(void);
+extern void *kmalloc(size_t size);
+extern void kfree(void *ptr);
 
-/* Debe llamarse UNA vez al inicio, antes del primer malloc() */
+/* Debe llamarse UNA vez al inicio, antes del primer malloc().
+ * No necesita el PMM ni el VMM: malloc() retorna NULL hasta vmm_init(). */
 void heap_init(void)
 {
-    uint32_t start = PAGE_ALIGN_UP((uint32_t)&_kernel_end);
-    /* Nunca empieza antes de 0x200000 por seguridad (evita solapar con kernel) */
-    if (start < 0x00200000u) start = 0x00200000u;
-    heap_current = start;
-    heap_end     = start + HEAP_SIZE;
+    kmalloc_init();
 }
 
 /**
  * malloc - Allocate memory
  * @size: Size in bytes to allocate
- * 
- * Returns: Pointer to allocated memory or NULL if failed
+ *
+ * Returns: Pointer to allocated memory (16-byte aligned) or NULL if failed
  */
 void *malloc(size_t size)
 {
-    void *ptr;
+    return kmalloc(size);
+}
+
+/**
+ * free - Free allocated memory
+ * @ptr: Pointer returned by malloc() (NULL is ignored)
+ */
+void free(void *ptr)
+{
+    kfree(ptr);
+}
 
-    /* Si heap_init() no se llamo todavia, devolver NULL en lugar de
-     * escribir en la direccion 0 (o en el kernel image). */
-    if (heap_current == 0) return NULL;
+/* ── mem*: rutinas por palabras, elegidas una vez al arrancar ─────────── */
 
-    /* Align to 4 bytes */
-    size = (size + 3) & ~3;
-    
-    /* Check if we have enough space */
-    if (heap_current + size > heap_end) {
-        return NULL;
+/*
+ * memcpy/memset mueven dwords con rep movsl/stosl después de alinear el
+ * destino a 4. A partir de MEM_NT_THRESHOLD bytes, si la CPU tiene SSE2,
+ * el grueso se escribe con movnti (store no temporal): un bloque así no
+ * cabe en la caché y escribirlo normal echaría todo lo demás. movnti usa
+ * registros generales, así que no hace falta CR4.OSFXSR ni guardar
+ * estado SSE en los cambios de contexto.
+ *
+ * memory_init() consulta CPUID y fija los punteros de los caminos
+ * grandes; antes de llamarla se usa rep movsl/stosl para todo.
+ */
+#define MEM_SMALL           16              /* por debajo, byte a byte */
+#define MEM_NT_THRESHOLD    (256 * 1024)
+
+/* Accesos de 32 bits a un buffer de bytes sin romper el aliasing */
+typedef uint32_t __attribute__((may_alias)) mem_word_t;
+
+extern void serial_puts(const char*);
+
+static void copy_words_rep(void *d, const void *s, size_t words)
+{
+    __asm__ volatile("cld; rep movsl"
+                     : "+D"(d), "+S"(s), "+c"(words) :: "memory");
+}
+
+static void fill_words_rep(void *d, uint32_t v, size_t words)
+{
+    __asm__ volatile("cld; rep stosl"
+                     : "+D"(d), "+c"(words) : "a"(v) : "memory");
+}
+
+/* Bloques de 16 bytes con movnti; el sfence ordena los stores no
+ * temporales antes de lo que venga después */
+static void copy_words_nt(void *d, const void *s, size_t words)
+{
+    mem_word_t *dw = (mem_word_t *)d;
+    const mem_word_t *sw = (const mem_word_t *)s;
+
+    for (; words >= 4; words -= 4, dw += 4, sw += 4) {
+        __asm__ volatile("movl   (%1), %%eax\n"
+                         "movl  4(%1), %%edx\n"
+                         "movnti %%eax,  (%0)\n"
+                         "movnti %%edx, 4(%0)\n"
+                         "movl  8(%1), %%eax\n"
+                         "movl 12(%1), %%edx\n"
+                         "movnti %%eax,  8(%0)\n"
+                         "movnti %%edx, 12(%0)\n"
+                         :: "r"(dw), "r"(sw) : "eax", "edx", "memory");
     }
-    
-    ptr = (void *)heap_current;
-    heap_current += size;
-    
-    return ptr;
+    while (words--) *dw++ = *sw++;
+    __asm__ volatile("sfence" ::: "memory");
 }
 
+static void fill_words_nt(void *d, uint32_t v, size_t words)
+{
+    mem_word_t *dw = (mem_word_t *)d;
+
+    for (; words >= 4; words -= 4, dw += 4) {
+        __asm__ volatile("movnti %1,  (%0)\n"
+                         "movnti %1, 4(%0)\n"
+                         "movnti %1, 8(%0)\n"
+                         "movnti %1, 12(%0)\n"
+                         :: "r"(dw), "r"(v) : "memory");
+    }
+    while (words--) *dw++ = v;
+    __asm__ volatile("sfence" ::: "memory");
+}
+
+static void (*g_copy_large)(void *, const void *, size_t) = copy_words_rep;
+static void (*g_fill_large)(void *, uint32_t, size_t)     = fill_words_rep;
+
 /**
- * free - Free allocated memory
- * @ptr: Pointer to memory to free
- * 
- * Note: LIMITATION - This is a simple bump allocator implementation.
- * Memory is NOT actually freed or reused. This will lead to memory exhaustion
- * over time as allocations accumulate. A proper allocator (buddy system,
- * slab allocator, etc.) should be implemented for production use.
- * 
- * For Phase 1, this is acceptable since:
- * - Drivers are loaded once at boot
- * - Device objects persist for system lifetime
- * - Limited dynamic allocation occurs after initialization
+ * memory_init - Pick the mem* routines for this CPU
+ *
+ * Llamar una vez al arrancar; con SSE2 los bloques grandes usan stores
+ * no temporales.
  */
-void free(void *ptr)
+void memory_init(void)
 {
-    /* Simple bump allocator - memory is never actually freed */
-    /* TODO: Implement proper free list or buddy allocator */
-    (void)ptr;
+    uint32_t edx = 0;
+
+    cpu_cpuid(1, NULL, NULL, NULL, &edx);
+    if (edx & CPUID_EDX_SSE2) {
+        g_copy_large = copy_words_nt;
+        g_fill_large = fill_words_nt;
+        serial_puts("[mem] memcpy/memset: rep movsl/stosl, movnti desde 256 KB\r\n");
+    } else {
+        serial_puts("[mem] memcpy/memset: rep movsl/stosl (sin SSE2)\r\n");
+    }
 }
 
 /**
@@ -105,11 +153,27 @@ void *memset(void *ptr, int value, size_t n)
 {
     unsigned char *p = (unsigned char *)ptr;
     unsigned char val = (unsigned char)value;
-    
-    for (size_t i = 0; i < n; i++) {
-        p[i] = val;
+    uint32_t v32;
+    size_t words;
+
+    if (n >= MEM_SMALL) {
+        /* alinear el destino a 4 */
+        while ((uint32_t)p & 3) {
+            *p++ = val;
+            n--;
+        }
+        v32 = val * 0x01010101u;
+        words = n / 4;
+        if (n >= MEM_NT_THRESHOLD)
+            g_fill_large(p, v32, words);
+        else
+            fill_words_rep(p, v32, words);
+        p += words * 4;
+        n &= 3;
     }
-    
+    while (n--)
+        *p++ = val;
+
     return ptr;
 }
 
@@ -125,11 +189,59 @@ void *memcpy(void *dest, const void *src, size_t n)
 {
     unsigned char *d = (unsigned char *)dest;
     const unsigned char *s = (const unsigned char *)src;
-    
-    for (size_t i = 0; i < n; i++) {
-        d[i] = s[i];
+    size_t words;
+
+    if (n >= MEM_SMALL) {
+        while ((uint32_t)d & 3) {
+            *d++ = *s++;
+            n--;
+        }
+        words = n / 4;
+        if (n >= MEM_NT_THRESHOLD)
+            g_copy_large(d, s, words);
+        else
+            copy_words_rep(d, s, words);
+        d += words * 4;
+        s += words * 4;
+        n &= 3;
     }
-    
+    while (n--)
+        *d++ = *s++;
+
+    return dest;
+}
+
+/**
+ * memmove - Copy memory between possibly overlapping blocks
+ * @dest: Destination pointer
+ * @src: Source pointer
+ * @n: Number of bytes to copy
+ *
+ * Returns: Destination pointer
+ */
+void *memmove(void *dest, const void *src, size_t n)
+{
+    unsigned char *d = (unsigned char *)dest;
+    const unsigned char *s = (const unsigned char *)src;
+
+    /* Hacia adelante es seguro si el destino no cae dentro del origen */
+    if (d <= s || d >= s + n)
+        return memcpy(dest, src, n);
+
+    /* Hacia atrás, por palabras; sin std: una IRQ en medio correría con
+     * DF=1 */
+    d += n;
+    s += n;
+    while (n & 3) {
+        *--d = *--s;
+        n--;
+    }
+    for (; n; n -= 4) {
+        d -= 4;
+        s -= 4;
+        *(mem_word_t *)d = *(const mem_word_t *)s;
+    }
+
     return dest;
 }
 
@@ -145,7 +257,14 @@ int memcmp(const void *s1, const void *s2, size_t n)
 {
     const unsigned char *p1 = (const unsigned char *)s1;
     const unsigned char *p2 = (const unsigned char *)s2;
-    
+
+    /* De a 4 bytes hasta la primera palabra distinta */
+    while (n >= 4 &&
+           *(const mem_word_t *)p1 == *(const mem_word_t *)p2) {
+        p1 += 4;
+        p2 += 4;
+        n -= 4;
+    }
     for (size_t i = 0; i < n; i++) {
         if (p1[i] != p2[i]) {
             return p1[i] - p2[i];
@@ -26,6 +26,8 @@ KVM=0
 SMP="1"
 RAM="256M"
 VERBOSE=0
+SWAP_MB=0
+SWAP_IMG="${SCRIPT_DIR}/swap.img"
 
 # Procesar argumentos
 while [ $# -gt 0 ]; do
@@ -44,12 +46,15 @@ while [ $# -gt 0 ]; do
             echo "  -s, --smp <n>     Número de CPUs (ej: -s 2)"
             echo "  -R, --ram <size>  RAM en MB (ej: -R 512)"
             echo "  -v, --verbose     Log detallado de QEMU"
+            echo "  -w, --swap <MB>   Disco de swap (swap.img, IDE primario esclavo)"
             echo ""
             echo "Ejemplos:"
             echo "  $0                # Compila y ejecuta normal"
             echo "  $0 -d             # Compila y ejecuta con debug"
             echo "  $0 -r -k          # Solo ejecuta con KVM"
             echo "  $0 -c -s 4 -R 1G  # Limpia, compila con 4 CPUs y 1GB RAM"
+            echo "  $0 -R 64 -w 128   # 64MB de RAM y 128MB de swap"
+            echo "  $0 -R 6G          # RAM sobre 4GB: el kernel activa PAE"
             exit 0
             ;;
         -b|--build-only)
@@ -88,6 +93,10 @@ while [ $# -gt 0 ]; do
             VERBOSE=1
             shift
             ;;
+        -w|--swap)
+            SWAP_MB="$2"
+            shift 2
+            ;;
         *)
             echo "${RED}Error: Opción desconocida $1${NC}"
             exit 1
@@ -132,6 +141,18 @@ build() {
     echo "${GREEN}✓ Compilación exitosa${NC}"
 }
 
+# Crear swap.img con la firma de mkswap ("SWAPSPACE2" al final de los
+# primeros 4KB), que es lo que busca el kernel (kernel/mm/swap.h)
+create_swap() {
+    if [ -f "$SWAP_IMG" ] && \
+       [ "$(wc -c < "$SWAP_IMG")" -eq $((SWAP_MB * 1024 * 1024)) ]; then
+        return
+    fi
+    echo "${BLUE}Creando ${SWAP_IMG} (${SWAP_MB}MB)...${NC}"
+    dd if=/dev/zero of="$SWAP_IMG" bs=1M count="$SWAP_MB" 2>/dev/null
+    printf 'SWAPSPACE2' | dd of="$SWAP_IMG" bs=1 seek=4086 conv=notrunc 2>/dev/null
+}
+
 # Función para ejecutar QEMU
 run_qemu() {
     echo "${YELLOW}=== Iniciando QEMU ===${NC}"
@@ -151,6 +172,12 @@ run_qemu() {
     QEMU_CMD="${QEMU_CMD} -cdrom \"${ISO_PATH}\""
     QEMU_CMD="${QEMU_CMD} -m ${RAM}"
     QEMU_CMD="${QEMU_CMD} -smp ${SMP}"
+
+    # Disco de swap en el IDE primario esclavo (el CD-ROM es el secundario)
+    if [ "$SWAP_MB" != 0 ]; then
+        create_swap
+        QEMU_CMD="${QEMU_CMD} -drive file=\"${SWAP_IMG}\",format=raw,if=ide,index=1"
+    fi
     
     # Opciones de salida
     if [ "$VERBOSE" = 1 ]; then
@@ -234,6 +261,9 @@ show_summary() {
     fi
     echo "  Debug: ${YELLOW}${DEBUG_TEXT}${NC}"
     
+    if [ "$SWAP_MB" != 0 ]; then
+        echo "  Swap: ${YELLOW}${SWAP_MB}MB${NC}"
+    fi
     echo "  Log: ${YELLOW}${QEMU_LOG}${NC}"
     echo ""
 }
@@ -38,6 +38,129 @@
 #define BUTTON_H         8
 
 
+/* ── ps: uso de memoria por proceso (SYS_PROC_INFO) ──────────────────── */
+
+/* escribir v en decimal alineado a la derecha en width columnas */
+UCODE static int u_put_dec(char* buf, int n, uint32_t v, int width)
+{
+    char dec[12];
+    int di = 0;
+    if (v == 0) dec[di++] = '0';
+    while (v) { dec[di++] = '0' + (v % 10); v /= 10; }
+    while (width-- > di) buf[n++] = ' ';
+    while (di--) buf[n++] = dec[di];
+    return n;
+}
+
+/* copiar s rellenando con espacios hasta width columnas */
+UCODE static int u_put_str(char* buf, int n, const char* s, int width)
+{
+    while (*s && width) { buf[n++] = *s++; width--; }
+    while (width--) buf[n++] = ' ';
+    return n;
+}
+
+/* Ventana con una línea por proceso; también la vuelca al serial.
+ * Tamaños en KB: RSS residente, PICO máximo de RSS, PT page tables,
+ * RESERV imagen + VMAs, TOCADA páginas de VMAs ya usadas (RAM + swap) */
+UCODE static void ps_show(void)
+{
+    static const char ps_title[] URODATA = "Procesos (ps)";
+    static GUI_WINDOW ps_win UDATA = {
+        .x = 40,
+        .y = 60,
+        .w = 560,
+        .h = 200,
+        .title = ps_title,
+        .visible = 1
+    };
+    SYS_PROCESS_INFO pi;
+    char line[80];
+    uint32_t i = 0;
+    int row = 0, n;
+
+    sys_gui_draw_window(ps_win.x, ps_win.y, ps_win.w, ps_win.h, ps_title);
+    sys_gui_draw_window_text(&ps_win, 8, 6,
+        USTR(" PID NOMBRE         RSS   PICO   PT  RESERV  TOCADA   SWAP  MAY"),
+        VGA_COLOR_BLUE);
+    sys_debug(USTR("[ps]  PID NOMBRE         RSS   PICO   PT  RESERV  TOCADA   SWAP  MAY\r\n"));
+
+    /* La cota evita girar para siempre si el retorno llega corrupto */
+    while ((int32_t)(i = sys_proc_info(i, &pi)) > 0 &&
+           i <= SYS_MAX_PROCESSES) {
+        n = 0;
+        n = u_put_dec(line, n, pi.pid, 4);
+        line[n++] = ' ';
+        n = u_put_str(line, n, pi.name, 12);
+        n = u_put_dec(line, n, pi.rss * 4, 6);
+        n = u_put_dec(line, n, pi.peak_rss * 4, 7);
+        n = u_put_dec(line, n, pi.page_tables * 4, 5);
+        n = u_put_dec(line, n, pi.committed * 4, 8);
+        n = u_put_dec(line, n, pi.touched * 4, 8);
+        n = u_put_dec(line, n, pi.swapped * 4, 7);
+        n = u_put_dec(line, n, pi.major_faults, 5);
+        line[n] = '\0';
+        if (row < 16)
+            sys_gui_draw_window_text(&ps_win, 8, 18 + row * 10, line,
+                                     VGA_COLOR_BLACK);
+        row++;
+
+        sys_debug(USTR("[ps] "));
+        sys_debug(line);
+        sys_debug(USTR("\r\n"));
+    }
+}
+
+/* ── superficie propia (SYS_SURFACE_MAP / SYS_SURFACE_DAMAGE) ──────────── */
+
+/* rellenar un rectángulo de la superficie: memoria de usuario, sin trap */
+UCODE static void u_surf_fill(SYS_SURFACE* s, int x, int y, int w, int h,
+                              uint8_t color)
+{
+    for (int row = y; row < y + h; row++) {
+        uint8_t* p = s->pixels + (uint32_t)row * s->pitch + x;
+        for (int col = 0; col < w; col++) p[col] = color;
+    }
+}
+
+/* Paleta de 16 colores dentro de la ventana: se copia el fondo desde el
+ * shadow de solo lectura, se pintan las muestras en la superficie y se
+ * publica todo con una sola syscall en vez de una SYS_FILL_RECT por
+ * muestra */
+UCODE static void palette_show(int x, int y)
+{
+    static SYS_SURFACE surf UDATA = { .width = 320, .height = 16 };
+
+    /* Una superficie por proceso: mapearla la primera vez y reutilizarla */
+    if (!surf.pixels) {
+        surf.x = x;
+        surf.y = y;
+        if (sys_surface_map(&surf, SURFACE_MAP_SHADOW) != 0) {
+            sys_debug(USTR("[user] sys_surface_map fallo\r\n"));
+            return;
+        }
+    }
+    x = surf.x;
+    y = surf.y;
+
+    if (surf.shadow) {
+        for (uint32_t row = 0; row < surf.height; row++) {
+            const uint8_t* src = surf.shadow
+                               + (uint32_t)(y + row) * surf.shadow_pitch + x;
+            uint8_t* dst = surf.pixels + row * surf.pitch;
+            for (uint32_t col = 0; col < surf.width; col++) dst[col] = src[col];
+        }
+    } else {
+        u_surf_fill(&surf, 0, 0, surf.width, surf.height, GUI_COLOR_WINDOW_BG);
+    }
+
+    for (int c = 0; c < 16; c++)
+        u_surf_fill(&surf, c * 20 + 1, 1, 18, 14, (uint8_t)c);
+
+    if (sys_surface_damage(0, 0, surf.width, surf.height) != 0)
+        sys_debug(USTR("[user] sys_surface_damage fallo\r\n"));
+}
+
 /* punto de entrada del programa de usuario */
 __attribute__((section(".user")))
 void user_entry(void)
@@ -73,7 +196,7 @@ void user_entry(void)
     {
         uint32_t ptr = (uint32_t)&welcome;
         char hex[9];
-        const char *h="0123456789ABCDEF";
+        const char *h=USTR("0123456789ABCDEF");
         for (int i = 0; i < 8; i++) {
             hex[7 - i] = h[(ptr >> (i * 4)) & 0xF];
         }
@@ -91,12 +214,15 @@ void user_entry(void)
     sys_gui_draw_window_text(&welcome, 10, 22, USTR("Universidad de Guayaquil v0.1"), VGA_COLOR_DARK_GRAY);
     sys_debug(USTR("window text done\r\n"));
 
+    palette_show(welcome.x + 10, welcome.y + 60);
+
     /* ya no manejamos cursor manualmente, el kernel se ocupa */
 
     /* dibujamos taskbar una sola vez al arrancar; el kernel se encargará
        de actualizar el reloj por su cuenta. */
     sys_gui_draw_taskbar();
     int start_pressed = 0;
+    int ps_pressed = 0;
     while (1) {
         /* el reloj ya está pintado por kernel, simplemente procesamos eventos */
 
@@ -150,10 +276,17 @@ void user_entry(void)
                 sys_gui_draw_taskbar();
             }
             if (ms.buttons & 1) {
-                sys_debug("[user] left click\r\n");
+                sys_debug(USTR("[user] left click\r\n"));
             }
             if (ms.buttons & 2) {
-                sys_debug("[user] right click\r\n");
+                sys_debug(USTR("[user] right click\r\n"));
+            }
+            /* clic derecho: listar procesos y su memoria */
+            if ((ms.buttons & 2) && !ps_pressed) {
+                ps_pressed = 1;
+                ps_show();
+            } else if (!(ms.buttons & 2)) {
+                ps_pressed = 0;
             }
         }
 